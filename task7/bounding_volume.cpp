@@ -0,0 +1,106 @@
+#include "bounding_volume.h"
+
+#include <algorithm>
+#include <cmath>
+
+MeshBounds ComputeMeshBounds(const void *vertices, const std::size_t count, const std::size_t stride)
+{
+     MeshBounds bounds = {};
+     if (0 == count)
+          return bounds;
+
+     const char *pVertex = static_cast<const char *>(vertices);
+     bounds.box.min = *reinterpret_cast<const DirectX::XMFLOAT3 *>(pVertex);
+     bounds.box.max = bounds.box.min;
+     for (std::size_t i = 1; i < count; ++i)
+     {
+          const auto &pos = *reinterpret_cast<const DirectX::XMFLOAT3 *>(pVertex + i * stride);
+          bounds.box.min = DirectX::XMFLOAT3(
+               std::min(bounds.box.min.x, pos.x),
+               std::min(bounds.box.min.y, pos.y),
+               std::min(bounds.box.min.z, pos.z));
+          bounds.box.max = DirectX::XMFLOAT3(
+               std::max(bounds.box.max.x, pos.x),
+               std::max(bounds.box.max.y, pos.y),
+               std::max(bounds.box.max.z, pos.z));
+     }
+
+     bounds.sphere.center = DirectX::XMFLOAT3(
+          0.5f * (bounds.box.min.x + bounds.box.max.x),
+          0.5f * (bounds.box.min.y + bounds.box.max.y),
+          0.5f * (bounds.box.min.z + bounds.box.max.z));
+     float radiusSq = 0.0f;
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          const auto &pos = *reinterpret_cast<const DirectX::XMFLOAT3 *>(pVertex + i * stride);
+          const float dx = pos.x - bounds.sphere.center.x;
+          const float dy = pos.y - bounds.sphere.center.y;
+          const float dz = pos.z - bounds.sphere.center.z;
+          radiusSq = std::max(radiusSq, dx * dx + dy * dy + dz * dz);
+     }
+     bounds.sphere.radius = std::sqrt(radiusSq);
+
+     return bounds;
+}
+
+Aabb TransformAabb(const Aabb &box, DirectX::FXMMATRIX world)
+{
+     const DirectX::XMVECTOR min = DirectX::XMLoadFloat3(&box.min);
+     const DirectX::XMVECTOR max = DirectX::XMLoadFloat3(&box.max);
+     const DirectX::XMVECTOR center = DirectX::XMVectorScale(DirectX::XMVectorAdd(min, max), 0.5f);
+     const DirectX::XMVECTOR extents = DirectX::XMVectorScale(DirectX::XMVectorSubtract(max, min), 0.5f);
+
+     const DirectX::XMVECTOR worldCenter = DirectX::XMVector3Transform(center, world);
+     DirectX::XMVECTOR worldExtents = DirectX::XMVectorMultiply(DirectX::XMVectorSplatX(extents), DirectX::XMVectorAbs(world.r[0]));
+     worldExtents = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorSplatY(extents), DirectX::XMVectorAbs(world.r[1]), worldExtents);
+     worldExtents = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorSplatZ(extents), DirectX::XMVectorAbs(world.r[2]), worldExtents);
+
+     Aabb res;
+     DirectX::XMStoreFloat3(&res.min, DirectX::XMVectorSubtract(worldCenter, worldExtents));
+     DirectX::XMStoreFloat3(&res.max, DirectX::XMVectorAdd(worldCenter, worldExtents));
+     return res;
+}
+
+Sphere TransformRigidSphere(const Sphere &sphere, DirectX::FXMMATRIX world)
+{
+     Sphere res;
+     DirectX::XMStoreFloat3(&res.center, DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&sphere.center), world));
+     res.radius = sphere.radius;
+     return res;
+}
+
+Aabb SphereToAabb(const Sphere &sphere)
+{
+     return Aabb{
+          DirectX::XMFLOAT3(sphere.center.x - sphere.radius, sphere.center.y - sphere.radius, sphere.center.z - sphere.radius),
+          DirectX::XMFLOAT3(sphere.center.x + sphere.radius, sphere.center.y + sphere.radius, sphere.center.z + sphere.radius)};
+}
+
+Aabb SpinInnerAabb(const Aabb &box)
+{
+     // Square inscribed in the largest circle around the axis which fits into the box footprint
+     const float radius = std::max(0.0f, std::min({box.max.x, -box.min.x, box.max.z, -box.min.z}));
+     const float halfSide = radius / std::sqrt(2.0f);
+     return Aabb{
+          DirectX::XMFLOAT3(-halfSide, box.min.y, -halfSide),
+          DirectX::XMFLOAT3(halfSide, box.max.y, halfSide)};
+}
+
+Aabb SpinOuterAabb(const Aabb &box)
+{
+     const float maxX = std::max(std::abs(box.min.x), std::abs(box.max.x));
+     const float maxZ = std::max(std::abs(box.min.z), std::abs(box.max.z));
+     const float radius = std::sqrt(maxX * maxX + maxZ * maxZ);
+     return Aabb{
+          DirectX::XMFLOAT3(-radius, box.min.y, -radius),
+          DirectX::XMFLOAT3(radius, box.max.y, radius)};
+}
+
+Sphere SpinSphere(const Sphere &sphere)
+{
+     // Center moves on a circle around the axis, the sphere centered on the axis covers all its positions
+     Sphere res;
+     res.center = DirectX::XMFLOAT3(0.0f, sphere.center.y, 0.0f);
+     res.radius = sphere.radius + std::sqrt(sphere.center.x * sphere.center.x + sphere.center.z * sphere.center.z);
+     return res;
+}
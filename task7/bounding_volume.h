@@ -0,0 +1,35 @@
+#pragma once
+
+#include <directxmath.h>
+#include <cstddef>
+
+struct Aabb
+{
+     DirectX::XMFLOAT3 min;
+     DirectX::XMFLOAT3 max;
+};
+
+struct Sphere
+{
+     DirectX::XMFLOAT3 center;
+     float radius;
+};
+
+struct MeshBounds
+{
+     Aabb box;
+     Sphere sphere;
+};
+
+// Local bounds of mesh vertices, position must be the first field of vertex of given stride
+MeshBounds ComputeMeshBounds(const void *vertices, const std::size_t count, const std::size_t stride);
+// Box enclosing the transformed box (Arvo's method with absolute matrix values)
+Aabb TransformAabb(const Aabb &box, DirectX::FXMMATRIX world);
+// Sphere transformed by matrix without scale (rotation and translation only)
+Sphere TransformRigidSphere(const Sphere &sphere, DirectX::FXMMATRIX world);
+Aabb SphereToAabb(const Sphere &sphere);
+// Boxes always covered / ever covered by box spinning around vertical axis through local origin
+Aabb SpinInnerAabb(const Aabb &box);
+Aabb SpinOuterAabb(const Aabb &box);
+// Sphere covering sphere spinning around vertical axis through local origin, it does not depend on the angle
+Sphere SpinSphere(const Sphere &sphere);
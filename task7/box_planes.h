@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <immintrin.h>
+
+// Box against plane tests shared by single and multi frustum culling. Planes are normal xyz and offset w,
+// inside is positive. Box is inside of a plane if its corner farthest along the normal (p-vertex) is.
+
+// Distance from plane to p-vertex. Batch versions sum in the same order, so all paths agree bit for bit.
+inline float PVertexDistance(const float *plane, float minX, float minY, float minZ, float maxX, float maxY, float maxZ)
+{
+     return std::max(plane[0] * minX, plane[0] * maxX) +
+          std::max(plane[1] * minY, plane[1] * maxY) +
+          std::max(plane[2] * minZ, plane[2] * maxZ) +
+          plane[3];
+}
+
+// Four structure-of-arrays boxes, loaded once to be tested against any number of planes
+struct BoxBatch4
+{
+     __m128 minX, minY, minZ, maxX, maxY, maxZ;
+};
+
+inline BoxBatch4 LoadBoxBatch4(
+     const float *minX,
+     const float *minY,
+     const float *minZ,
+     const float *maxX,
+     const float *maxY,
+     const float *maxZ,
+     const std::size_t index)
+{
+     return BoxBatch4{
+          _mm_loadu_ps(minX + index),
+          _mm_loadu_ps(minY + index),
+          _mm_loadu_ps(minZ + index),
+          _mm_loadu_ps(maxX + index),
+          _mm_loadu_ps(maxY + index),
+          _mm_loadu_ps(maxZ + index)};
+}
+
+// All ones in lanes of boxes inside of every plane, planes are 4 floats each
+inline __m128 CheckBoxPlanes4(const BoxBatch4 &boxes, const float *planes, const int planeNumber)
+{
+     __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+     for (int p = 0; p < planeNumber; ++p)
+     {
+          const float *plane = planes + p * 4;
+          const __m128 a = _mm_set1_ps(plane[0]);
+          const __m128 b = _mm_set1_ps(plane[1]);
+          const __m128 c = _mm_set1_ps(plane[2]);
+          __m128 dot = _mm_add_ps(
+               _mm_max_ps(_mm_mul_ps(a, boxes.minX), _mm_mul_ps(a, boxes.maxX)),
+               _mm_max_ps(_mm_mul_ps(b, boxes.minY), _mm_mul_ps(b, boxes.maxY)));
+          dot = _mm_add_ps(dot, _mm_max_ps(_mm_mul_ps(c, boxes.minZ), _mm_mul_ps(c, boxes.maxZ)));
+          dot = _mm_add_ps(dot, _mm_set1_ps(plane[3]));
+          inside = _mm_and_ps(inside, _mm_cmpge_ps(dot, _mm_setzero_ps()));
+          if (0 == _mm_movemask_ps(inside))
+               break;
+     }
+     return inside;
+}
+
+#if defined(__AVX2__)
+struct BoxBatch8
+{
+     __m256 minX, minY, minZ, maxX, maxY, maxZ;
+};
+
+inline BoxBatch8 LoadBoxBatch8(
+     const float *minX,
+     const float *minY,
+     const float *minZ,
+     const float *maxX,
+     const float *maxY,
+     const float *maxZ,
+     const std::size_t index)
+{
+     return BoxBatch8{
+          _mm256_loadu_ps(minX + index),
+          _mm256_loadu_ps(minY + index),
+          _mm256_loadu_ps(minZ + index),
+          _mm256_loadu_ps(maxX + index),
+          _mm256_loadu_ps(maxY + index),
+          _mm256_loadu_ps(maxZ + index)};
+}
+
+inline __m256 CheckBoxPlanes8(const BoxBatch8 &boxes, const float *planes, const int planeNumber)
+{
+     __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+     for (int p = 0; p < planeNumber; ++p)
+     {
+          const float *plane = planes + p * 4;
+          const __m256 a = _mm256_set1_ps(plane[0]);
+          const __m256 b = _mm256_set1_ps(plane[1]);
+          const __m256 c = _mm256_set1_ps(plane[2]);
+          __m256 dot = _mm256_add_ps(
+               _mm256_max_ps(_mm256_mul_ps(a, boxes.minX), _mm256_mul_ps(a, boxes.maxX)),
+               _mm256_max_ps(_mm256_mul_ps(b, boxes.minY), _mm256_mul_ps(b, boxes.maxY)));
+          dot = _mm256_add_ps(dot, _mm256_max_ps(_mm256_mul_ps(c, boxes.minZ), _mm256_mul_ps(c, boxes.maxZ)));
+          dot = _mm256_add_ps(dot, _mm256_set1_ps(plane[3]));
+          inside = _mm256_and_ps(inside, _mm256_cmp_ps(dot, _mm256_setzero_ps(), _CMP_GE_OQ));
+          if (0 == _mm256_movemask_ps(inside))
+               break;
+     }
+     return inside;
+}
+#endif
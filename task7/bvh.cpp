@@ -0,0 +1,303 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+
+     float HalfArea(const float *min, const float *max)
+     {
+          const float dx = max[0] - min[0];
+          const float dy = max[1] - min[1];
+          const float dz = max[2] - min[2];
+          return dx * dy + dy * dz + dz * dx;
+     }
+
+     void Extend(float *min, float *max, const float *otherMin, const float *otherMax)
+     {
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               min[axis] = std::min(min[axis], otherMin[axis]);
+               max[axis] = std::max(max[axis], otherMax[axis]);
+          }
+     }
+
+     struct Bin
+     {
+          float min[3] = {
+               std::numeric_limits<float>::max(),
+               std::numeric_limits<float>::max(),
+               std::numeric_limits<float>::max()};
+          float max[3] = {
+               std::numeric_limits<float>::lowest(),
+               std::numeric_limits<float>::lowest(),
+               std::numeric_limits<float>::lowest()};
+          std::uint32_t count = 0;
+     };
+
+}
+
+void Bvh::Build(
+     const float *minX,
+     const float *minY,
+     const float *minZ,
+     const float *maxX,
+     const float *maxY,
+     const float *maxZ,
+     const std::size_t count)
+{
+     nodes_.clear();
+     indices_.resize(count);
+     for (std::size_t i = 0; i < count; ++i)
+          indices_[i] = static_cast<std::uint32_t>(i);
+
+     const float *sourceBounds[] = {minX, minY, minZ, maxX, maxY, maxZ};
+     for (int i = 0; i < 6; ++i)
+          bounds_[i].assign(sourceBounds[i], sourceBounds[i] + count);
+     if (0 == count)
+          return;
+
+     std::vector<float> centroids(count * 3);
+     for (std::size_t i = 0; i < count; ++i)
+          for (int axis = 0; axis < 3; ++axis)
+               centroids[i * 3 + axis] = 0.5f * (bounds_[axis][i] + bounds_[axis + 3][i]);
+
+     // Binary tree over count leaves never has more than 2 * count - 1 nodes, so nodes_ is not reallocated while building
+     nodes_.reserve(2 * count);
+     nodes_.emplace_back();
+     nodes_[0].first = 0;
+     nodes_[0].count = static_cast<std::uint32_t>(count);
+     BuildNode(0, 0, centroids);
+
+     for (int i = 0; i < 6; ++i)
+          for (std::size_t j = 0; j < count; ++j)
+               bounds_[i][j] = sourceBounds[i][indices_[j]];
+}
+
+void Bvh::BuildNode(const std::uint32_t nodeIndex, const std::size_t depth, const std::vector<float> &centroids)
+{
+     Node &node = nodes_[nodeIndex];
+     UpdateNodeBounds(node, false);
+     const std::uint32_t first = node.first;
+     const std::uint32_t count = node.count;
+     if (count <= 1 || depth >= maxDepth_)
+          return;
+
+     float centroidMin[3];
+     float centroidMax[3];
+     for (int axis = 0; axis < 3; ++axis)
+     {
+          centroidMin[axis] = std::numeric_limits<float>::max();
+          centroidMax[axis] = std::numeric_limits<float>::lowest();
+     }
+     for (std::uint32_t i = first; i < first + count; ++i)
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               centroidMin[axis] = std::min(centroidMin[axis], centroids[indices_[i] * 3 + axis]);
+               centroidMax[axis] = std::max(centroidMax[axis], centroids[indices_[i] * 3 + axis]);
+          }
+
+     float bestCost = std::numeric_limits<float>::max();
+     int bestAxis = -1;
+     std::size_t bestSplit = 0;
+     for (int axis = 0; axis < 3; ++axis)
+     {
+          const float extent = centroidMax[axis] - centroidMin[axis];
+          if (extent <= 0.0f)
+               continue;
+
+          Bin bins[binNumber_];
+          const float scale = binNumber_ / extent;
+          for (std::uint32_t i = first; i < first + count; ++i)
+          {
+               const std::uint32_t box = indices_[i];
+               const std::size_t binIndex = std::min(
+                    binNumber_ - 1,
+                    static_cast<std::size_t>((centroids[box * 3 + axis] - centroidMin[axis]) * scale));
+               const float boxMin[] = {bounds_[0][box], bounds_[1][box], bounds_[2][box]};
+               const float boxMax[] = {bounds_[3][box], bounds_[4][box], bounds_[5][box]};
+               Extend(bins[binIndex].min, bins[binIndex].max, boxMin, boxMax);
+               ++bins[binIndex].count;
+          }
+
+          float leftArea[binNumber_ - 1];
+          std::uint32_t leftCount[binNumber_ - 1];
+          Bin left;
+          for (std::size_t i = 0; i < binNumber_ - 1; ++i)
+          {
+               Extend(left.min, left.max, bins[i].min, bins[i].max);
+               left.count += bins[i].count;
+               leftArea[i] = left.count > 0 ? HalfArea(left.min, left.max) : 0.0f;
+               leftCount[i] = left.count;
+          }
+          Bin right;
+          for (std::size_t i = binNumber_ - 1; i > 0; --i)
+          {
+               Extend(right.min, right.max, bins[i].min, bins[i].max);
+               right.count += bins[i].count;
+               const float rightArea = right.count > 0 ? HalfArea(right.min, right.max) : 0.0f;
+               const float cost = leftArea[i - 1] * leftCount[i - 1] + rightArea * right.count;
+               if (cost < bestCost)
+               {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i;
+               }
+          }
+     }
+
+     const float nodeArea = HalfArea(node.min, node.max);
+     if (bestAxis < 0 || (count <= maxLeafSize_ && traversalCost_ * nodeArea + bestCost >= nodeArea * count))
+          return;
+
+     const float scale = binNumber_ / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+     const auto middle = std::partition(
+          indices_.begin() + first,
+          indices_.begin() + first + count,
+          [&](std::uint32_t box)
+          {
+               const std::size_t binIndex = std::min(
+                    binNumber_ - 1,
+                    static_cast<std::size_t>((centroids[box * 3 + bestAxis] - centroidMin[bestAxis]) * scale));
+               return binIndex < bestSplit;
+          });
+     const std::uint32_t leftCount = static_cast<std::uint32_t>(middle - (indices_.begin() + first));
+     if (0 == leftCount || count == leftCount)
+          return;
+
+     const std::uint32_t leftIndex = static_cast<std::uint32_t>(nodes_.size());
+     nodes_.emplace_back();
+     nodes_.emplace_back();
+     nodes_[leftIndex].first = first;
+     nodes_[leftIndex].count = leftCount;
+     nodes_[leftIndex + 1].first = first + leftCount;
+     nodes_[leftIndex + 1].count = count - leftCount;
+     node.first = leftIndex;
+     node.count = 0;
+
+     BuildNode(leftIndex, depth + 1, centroids);
+     BuildNode(leftIndex + 1, depth + 1, centroids);
+}
+
+void Bvh::UpdateNodeBounds(Node &node, bool reordered) const
+{
+     for (int axis = 0; axis < 3; ++axis)
+     {
+          node.min[axis] = std::numeric_limits<float>::max();
+          node.max[axis] = std::numeric_limits<float>::lowest();
+     }
+     for (std::uint32_t i = node.first; i < node.first + node.count; ++i)
+     {
+          const std::uint32_t box = reordered ? i : indices_[i];
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               node.min[axis] = std::min(node.min[axis], bounds_[axis][box]);
+               node.max[axis] = std::max(node.max[axis], bounds_[axis + 3][box]);
+          }
+     }
+}
+
+void Bvh::Refit(
+     const float *minX,
+     const float *minY,
+     const float *minZ,
+     const float *maxX,
+     const float *maxY,
+     const float *maxZ)
+{
+     const float *sourceBounds[] = {minX, minY, minZ, maxX, maxY, maxZ};
+     for (int i = 0; i < 6; ++i)
+          for (std::size_t j = 0; j < indices_.size(); ++j)
+               bounds_[i][j] = sourceBounds[i][indices_[j]];
+
+     // Children are always stored after their parent
+     for (std::size_t i = nodes_.size(); i-- > 0;)
+     {
+          Node &node = nodes_[i];
+          if (node.count > 0)
+          {
+               UpdateNodeBounds(node, true);
+               continue;
+          }
+
+          const Node &left = nodes_[node.first];
+          const Node &right = nodes_[node.first + 1];
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               node.min[axis] = std::min(left.min[axis], right.min[axis]);
+               node.max[axis] = std::max(left.max[axis], right.max[axis]);
+          }
+     }
+}
+
+std::size_t Bvh::Cull(const Frustum &frustum, std::uint32_t *visibleIndices) const
+{
+     if (nodes_.empty())
+          return 0;
+
+     struct StackEntry
+     {
+          std::uint32_t node;
+          unsigned planeMask;
+     };
+     // Depth first order keeps at most one pending sibling per level
+     StackEntry stack[maxDepth_ + 2];
+     std::size_t stackSize = 0;
+     stack[stackSize++] = {0, Frustum::allPlanesMask};
+
+     std::size_t visibleNumber = 0;
+     while (stackSize > 0)
+     {
+          const StackEntry entry = stack[--stackSize];
+          const Node &node = nodes_[entry.node];
+          unsigned planeMask = entry.planeMask;
+          if (!frustum.CheckRectangleMasked(node.min, node.max, planeMask))
+               continue;
+
+          if (0 == planeMask)
+          {
+               // Subtree is fully inside, take every box without further tests.
+               // Its boxes are contiguous in indices_: from the leftmost leaf to the end of the rightmost one.
+               const Node *pNode = &node;
+               while (0 == pNode->count)
+                    pNode = &nodes_[pNode->first];
+               const std::uint32_t first = pNode->first;
+               pNode = &node;
+               while (0 == pNode->count)
+                    pNode = &nodes_[pNode->first + 1];
+               const std::uint32_t last = pNode->first + pNode->count;
+               for (std::uint32_t i = first; i < last; ++i)
+                    visibleIndices[visibleNumber++] = indices_[i];
+               continue;
+          }
+
+          if (node.count > 0)
+          {
+               std::uint32_t *leafVisible = visibleIndices + visibleNumber;
+               const std::size_t leafVisibleNumber = frustum.CheckRectangles(
+                    bounds_[0].data() + node.first,
+                    bounds_[1].data() + node.first,
+                    bounds_[2].data() + node.first,
+                    bounds_[3].data() + node.first,
+                    bounds_[4].data() + node.first,
+                    bounds_[5].data() + node.first,
+                    node.count,
+                    leafVisible);
+               for (std::size_t i = 0; i < leafVisibleNumber; ++i)
+                    leafVisible[i] = indices_[node.first + leafVisible[i]];
+               visibleNumber += leafVisibleNumber;
+               continue;
+          }
+
+          stack[stackSize++] = {node.first + 1, planeMask};
+          stack[stackSize++] = {node.first, planeMask};
+     }
+
+     return visibleNumber;
+}
+
+std::size_t Bvh::GetSize() const
+{
+     return indices_.size();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "frustum.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounding volume hierarchy over axis aligned boxes given as structure of arrays.
+// Built with binned SAH, refitted in place when boxes move without changing topology.
+class Bvh
+{
+public:
+     void Build(
+          const float *minX,
+          const float *minY,
+          const float *minZ,
+          const float *maxX,
+          const float *maxY,
+          const float *maxZ,
+          const std::size_t count);
+     void Refit(
+          const float *minX,
+          const float *minY,
+          const float *minZ,
+          const float *maxX,
+          const float *maxY,
+          const float *maxZ);
+     // Writes indices of visible boxes in tree order to visibleIndices (must hold GetSize() elements), returns their number.
+     std::size_t Cull(const Frustum &frustum, std::uint32_t *visibleIndices) const;
+     std::size_t GetSize() const;
+
+private:
+     static constexpr const std::size_t maxLeafSize_ = 8;
+     static constexpr const std::size_t binNumber_ = 12;
+     static constexpr const float traversalCost_ = 1.0f;
+     static constexpr const std::size_t maxDepth_ = 63;
+
+     struct Node
+     {
+          float min[3];
+          float max[3];
+          std::uint32_t first; // first box for leaf, left child for inner node (right one is next)
+          std::uint32_t count; // 0 for inner node
+     };
+
+     void BuildNode(const std::uint32_t nodeIndex, const std::size_t depth, const std::vector<float> &centroids);
+     void UpdateNodeBounds(Node &node, bool reordered) const;
+
+     std::vector<Node> nodes_;
+     std::vector<std::uint32_t> indices_;
+     std::vector<float> bounds_[6]; // min x, y, z, max x, y, z reordered by indices_
+};
@@ -1,37 +1,79 @@
 #include "scene_buffer.hlsli"
 #include "light_buffer.hlsli"
 
-float3 CalculateColor(in float3 objColor, in float3 objNormal, in float3 pos, in float shine, in bool trans)
+// Same falloff as light_falloff.cpp: inverse square windowed to zero at the influence radius
+float GetLightWindow(in float dist, in float radius)
 {
-     float3 finalColor = float3(0, 0, 0);
+     float ratio = dist / radius;
+     float window = saturate(1.0 - ratio * ratio * ratio * ratio);
+     return window * window;
+}
+
+float3 CalculateLight(in Light light, in float3 objColor, in float3 objNormal, in float3 pos, in float shine, in bool trans)
+{
+     float3 norm = objNormal;
+
+     float3 lightDir = light.position.xyz - pos;
+     float lightDist = length(lightDir);
+     if (lightDist >= light.position.w)
+     {
+          return float3(0, 0, 0);
+     }
+     lightDir /= lightDist;
+
+     float window = GetLightWindow(lightDist, light.position.w);
+     float atten = clamp(1.0 / (lightDist * lightDist), 0, 1) * window;
 
+     if (trans && dot(lightDir, objNormal) < 0.0)
+     {
+          norm = -norm;
+     }
+     float3 color = objColor * max(dot(lightDir, norm), 0) * atten * light.color.xyz;
+
+     float3 viewDir = normalize(cameraPos.xyz - pos);
+     float3 reflectDir = reflect(-lightDir, norm);
+     float spec = shine > 0 ? pow(max(dot(viewDir, reflectDir), 0.0), shine.x) : 0.0;
+
+     return color + objColor * spec * window * light.color.xyz;
+}
+
+// Lights of the pixel's cluster
+float3 CalculateColor(in float3 objColor, in float3 objNormal, in float3 pos, in float shine, in bool trans, in float2 screenPos)
+{
      if (lightCount.z > 0)
      {
           return float3(objNormal * 0.5 + float3(0.5, 0.5, 0.5));
      }
 
-     [unroll]
-     for (int i = 0; i < lightCount.x; i++)
+     float3 finalColor = float3(0, 0, 0);
+     uint2 range = GetClusterRange(screenPos, pos);
+     [loop]
+     for (uint i = 0; i < range.y; i++)
      {
-          float3 norm = objNormal;
+          finalColor += CalculateLight(lights[clusterLightIndices[range.x + i]], objColor, objNormal, pos, shine, trans);
+     }
 
-          float3 lightDir = lightPos[i].xyz - pos;
-          float lightDist = length(lightDir);
-          lightDir /= lightDist;
+     return finalColor;
+}
 
-          float atten = clamp(1.0 / (lightDist * lightDist), 0, 1);
+// Up to four lights assigned to the instance, 16 bit indices from the strongest, 0xFFFF ends the list
+float3 CalculateInstanceColor(in float3 objColor, in float3 objNormal, in float3 pos, in float shine, in bool trans, in uint2 packedLights)
+{
+     if (lightCount.z > 0)
+     {
+          return float3(objNormal * 0.5 + float3(0.5, 0.5, 0.5));
+     }
 
-          if (trans && dot(lightDir, objNormal) < 0.0)
+     float3 finalColor = float3(0, 0, 0);
+     [unroll]
+     for (uint i = 0; i < 4; i++)
+     {
+          uint index = (packedLights[i / 2] >> (16 * (i % 2))) & 0xFFFF;
+          if (index == 0xFFFF)
           {
-               norm = -norm;
+               break;
           }
-          finalColor += objColor * max(dot(lightDir, norm), 0) * atten * lightColor[i].xyz;
-
-          float3 viewDir = normalize(cameraPos.xyz - pos);
-          float3 reflectDir = reflect(-lightDir, norm);
-          float spec = shine > 0 ? pow(max(dot(viewDir, reflectDir), 0.0), shine.x) : 0.0;
-
-          finalColor += objColor * spec * lightColor[i].xyz;
+          finalColor += CalculateLight(lights[index], objColor, objNormal, pos, shine, trans);
      }
 
      return finalColor;
@@ -4,6 +4,7 @@ cbuffer WorldBuffer : register (b0)
 {
      float4x4 world;
      float4 color;
+     uint4 packedLights; // xy - lights of the plane when lightCount.w is set
 };
 
 struct VSOutput
@@ -14,5 +15,9 @@ struct VSOutput
 
 float4 main(VSOutput input) : SV_Target0
 {
-     return float4(CalculateColor(color.xyz, float3(1, 0, 0), input.worldPos.xyz, 0.0, true), color.w);
+     if (lightCount.w > 0)
+     {
+          return float4(CalculateInstanceColor(color.xyz, float3(1, 0, 0), input.worldPos.xyz, 0.0, true, packedLights.xy), color.w);
+     }
+     return float4(CalculateColor(color.xyz, float3(1, 0, 0), input.worldPos.xyz, 0.0, true, input.position.xy), color.w);
 }
@@ -4,6 +4,7 @@ cbuffer WorldBuffer : register (b0)
 {
      float4x4 world;
      float4 color;
+     uint4 packedLights;
 };
 
 struct VSInput
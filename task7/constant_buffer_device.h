@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+// Backend which owns GPU constant buffers for ConstantBufferManager. Buffers are opaque handles,
+// so the manager does not depend on D3D and can run against a stand-in device.
+class ConstantBufferDevice
+{
+public:
+     virtual ~ConstantBufferDevice() {}
+     // Returns nullptr on failure, name is used for debugging
+     virtual void *CreateBuffer(const std::string &name, const unsigned size) = 0;
+     virtual void ReleaseBuffer(void *buffer) = 0;
+     virtual bool SupportsPartialUpdate() const = 0;
+     // Uploads [begin, end) bytes of data, which holds the whole buffer content, returns number of uploaded bytes
+     virtual unsigned UpdateBuffer(void *buffer, const void *data, const unsigned size, const unsigned begin, const unsigned end) = 0;
+};
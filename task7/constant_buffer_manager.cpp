@@ -0,0 +1,108 @@
+#include "constant_buffer_manager.h"
+
+#include <algorithm>
+#include <cstring>
+
+ConstantBufferManager::ConstantBufferManager(ConstantBufferDevice &device) :
+     device_(device),
+     statistics_{}
+{
+}
+
+ConstantBufferManager::~ConstantBufferManager()
+{
+     for (auto &block : blocks_)
+          device_.ReleaseBuffer(block.buffer);
+}
+
+ConstantBufferManager::Block ConstantBufferManager::Register(const std::string &name, const unsigned size)
+{
+     for (std::size_t i = 0; i < blocks_.size(); ++i)
+          if (blocks_[i].name == name)
+               return blocks_[i].size == size ? static_cast<Block>(i) : invalidBlock;
+
+     void *buffer = device_.CreateBuffer(name, size);
+     if (nullptr == buffer)
+          return invalidBlock;
+
+     BlockData block;
+     block.name = name;
+     block.size = size;
+     block.shadow.assign(size, 0);
+     block.uploaded.assign(size, 0);
+     block.valid = false;
+     block.buffer = buffer;
+     blocks_.push_back(std::move(block));
+     return static_cast<Block>(blocks_.size() - 1);
+}
+
+void ConstantBufferManager::Write(const Block block, const void *data, const unsigned offset, const unsigned size)
+{
+     std::memcpy(blocks_[block].shadow.data() + offset, data, size);
+     statistics_.writtenBytes += size;
+}
+
+void ConstantBufferManager::Flush()
+{
+     for (auto &block : blocks_)
+          Flush(block);
+}
+
+void ConstantBufferManager::Flush(BlockData &block)
+{
+     if (!block.valid)
+     {
+          Upload(block, 0, block.size);
+          block.valid = true;
+          return;
+     }
+
+     const unsigned registerNumber = (block.size + registerSize_ - 1) / registerSize_;
+     unsigned first = registerNumber;
+     unsigned last = 0;
+     for (unsigned reg = 0; reg < registerNumber; ++reg)
+     {
+          const unsigned begin = reg * registerSize_;
+          const unsigned end = std::min(block.size, begin + registerSize_);
+          if (0 == std::memcmp(block.shadow.data() + begin, block.uploaded.data() + begin, end - begin))
+               continue;
+
+          if (first != registerNumber && reg - last > maxCleanGap_ + 1 && device_.SupportsPartialUpdate())
+          {
+               Upload(block, first * registerSize_, (last + 1) * registerSize_);
+               first = registerNumber;
+          }
+          if (first == registerNumber)
+               first = reg;
+          last = reg;
+     }
+     if (first == registerNumber)
+          return;
+
+     if (device_.SupportsPartialUpdate())
+          Upload(block, first * registerSize_, std::min(block.size, (last + 1) * registerSize_));
+     else
+          Upload(block, 0, block.size);
+}
+
+void ConstantBufferManager::Upload(BlockData &block, const unsigned begin, const unsigned end)
+{
+     statistics_.uploadedBytes += device_.UpdateBuffer(block.buffer, block.shadow.data(), block.size, begin, end);
+     ++statistics_.uploadNumber;
+     std::memcpy(block.uploaded.data() + begin, block.shadow.data() + begin, end - begin);
+}
+
+void *ConstantBufferManager::GetBuffer(const Block block) const
+{
+     return blocks_[block].buffer;
+}
+
+void ConstantBufferManager::ResetStatistics()
+{
+     statistics_ = Statistics{};
+}
+
+const ConstantBufferManager::Statistics &ConstantBufferManager::GetStatistics() const
+{
+     return statistics_;
+}
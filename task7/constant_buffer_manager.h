@@ -0,0 +1,66 @@
+#pragma once
+
+#include "constant_buffer_device.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Keeps CPU shadow copies of constant buffers and uploads only 16 byte registers which differ from
+// the last upload. Passes which register a block under the same name share one buffer.
+class ConstantBufferManager
+{
+public:
+     typedef std::uint32_t Block;
+     static constexpr const Block invalidBlock = 0xFFFFFFFF;
+
+     struct Statistics
+     {
+          std::size_t writtenBytes; // bytes passed to Write
+          std::size_t uploadedBytes; // bytes sent to device
+          std::size_t uploadNumber;
+     };
+
+     explicit ConstantBufferManager(ConstantBufferDevice &device);
+     ~ConstantBufferManager();
+     ConstantBufferManager(const ConstantBufferManager &) = delete;
+     ConstantBufferManager &operator=(const ConstantBufferManager &) = delete;
+
+     // Returns invalidBlock if buffer creation fails or name is registered with other size
+     Block Register(const std::string &name, const unsigned size);
+     void Write(const Block block, const void *data, const unsigned offset, const unsigned size);
+     template <typename T>
+     void Write(const Block block, const T &data)
+     {
+          Write(block, &data, 0, static_cast<unsigned>(sizeof(T)));
+     }
+     // Uploads dirty ranges of all blocks
+     void Flush();
+     void *GetBuffer(const Block block) const;
+
+     void ResetStatistics();
+     const Statistics &GetStatistics() const;
+
+private:
+     static constexpr const unsigned registerSize_ = 16;
+     // Clean registers between dirty ones which are still uploaded to save a call
+     static constexpr const unsigned maxCleanGap_ = 2;
+
+     struct BlockData
+     {
+          std::string name;
+          unsigned size;
+          std::vector<char> shadow;
+          std::vector<char> uploaded;
+          bool valid; // uploaded copy matches buffer content
+          void *buffer;
+     };
+
+     void Flush(BlockData &block);
+     void Upload(BlockData &block, const unsigned begin, const unsigned end);
+
+     ConstantBufferDevice &device_;
+     std::vector<BlockData> blocks_;
+     Statistics statistics_;
+};
@@ -0,0 +1,73 @@
+#include "contribution_culler.h"
+
+#include <algorithm>
+#include <cmath>
+
+ContributionCuller::ContributionCuller(const float minPixelRadius, const float hysteresis) :
+     minPixelRadius_(minPixelRadius),
+     hysteresis_(hysteresis),
+     eye_(0.0f, 0.0f, 0.0f),
+     pixelScale_(1.0f),
+     frame_(0)
+{
+}
+
+void ContributionCuller::SetView(const DirectX::XMFLOAT3 &eye, const float fov, const unsigned viewportHeight)
+{
+     eye_ = eye;
+     pixelScale_ = 0.5f * viewportHeight / std::tan(0.5f * fov);
+}
+
+std::size_t ContributionCuller::Filter(
+     const float *centerX,
+     const float *centerY,
+     const float *centerZ,
+     const float *radius,
+     const float *maxDistance,
+     const std::size_t objectNumber,
+     std::uint32_t *indices,
+     const std::size_t count)
+{
+     // Objects culled before this stage keep stale entries, which then no longer match the previous frame
+     ++frame_;
+     droppedFrames_.resize(objectNumber, 0);
+
+     // Compare squared values to avoid square roots: projected radius is r / sqrt(d^2 - r^2) * pixelScale_
+     const float keepRadius = minPixelRadius_ / pixelScale_;
+     const float returnRadius = minPixelRadius_ * (1.0f + hysteresis_) / pixelScale_;
+     const float keepRadiusSq = keepRadius * keepRadius;
+     const float returnRadiusSq = returnRadius * returnRadius;
+     const float returnDistanceScaleSq = (1.0f - hysteresis_) * (1.0f - hysteresis_);
+
+     std::size_t visibleNumber = 0;
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          const std::uint32_t index = indices[i];
+          const float dx = centerX[index] - eye_.x;
+          const float dy = centerY[index] - eye_.y;
+          const float dz = centerZ[index] - eye_.z;
+          const float distanceSq = dx * dx + dy * dy + dz * dz;
+          const float radiusSq = radius[index] * radius[index];
+          const bool wasDropped = 0 != droppedFrames_[index] && droppedFrames_[index] + 1 == frame_;
+
+          bool keep = distanceSq <= radiusSq;
+          if (!keep)
+          {
+               // r^2 / (d^2 - r^2) >= limit^2
+               const float limitSq = wasDropped ? returnRadiusSq : keepRadiusSq;
+               keep = radiusSq >= limitSq * (distanceSq - radiusSq);
+               if (keep && nullptr != maxDistance)
+               {
+                    const float maxDistanceSq = maxDistance[index] * maxDistance[index];
+                    keep = distanceSq <= (wasDropped ? maxDistanceSq * returnDistanceScaleSq : maxDistanceSq);
+               }
+          }
+
+          if (keep)
+               indices[visibleNumber++] = index;
+          else
+               droppedFrames_[index] = frame_;
+     }
+
+     return visibleNumber;
+}
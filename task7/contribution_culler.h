@@ -0,0 +1,40 @@
+#pragma once
+
+#include <directxmath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Drops objects whose bounding sphere projects smaller than given pixel radius or which are farther
+// than their max draw distance. Objects have to pass the limits with a margin to come back, so they
+// do not flicker at the threshold.
+class ContributionCuller
+{
+public:
+     ContributionCuller(const float minPixelRadius = defaultMinPixelRadius_, const float hysteresis = defaultHysteresis_);
+     void SetView(const DirectX::XMFLOAT3 &eye, const float fov, const unsigned viewportHeight);
+     // Keeps contributing entries of indices (of SoA spheres) in order, returns their number.
+     // maxDistance may be null, objectNumber is the size of sphere arrays. Call once per frame: hysteresis
+     // only applies to objects dropped by the previous call, objects that skipped it start over.
+     std::size_t Filter(
+          const float *centerX,
+          const float *centerY,
+          const float *centerZ,
+          const float *radius,
+          const float *maxDistance,
+          const std::size_t objectNumber,
+          std::uint32_t *indices,
+          const std::size_t count);
+
+private:
+     static constexpr const float defaultMinPixelRadius_ = 1.0f;
+     static constexpr const float defaultHysteresis_ = 0.2f;
+
+     const float minPixelRadius_;
+     const float hysteresis_;
+
+     DirectX::XMFLOAT3 eye_;
+     float pixelScale_; // pixels per unit of radius at unit distance
+     std::uint32_t frame_;
+     std::vector<std::uint32_t> droppedFrames_; // frame an object was last dropped in, 0 for never
+};
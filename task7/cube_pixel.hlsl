@@ -13,16 +13,17 @@ struct VSOutput
      float2 texCoord : TEXCOORD;
      float3 normal : NORMAL;
      float3 tangent : TANGENT;
-     nointerpolation uint instanceId : INST_ID;
+     nointerpolation uint material : MATERIAL;
+     nointerpolation uint2 lights : LIGHTS;
 };
 
 float4 main(VSOutput input) : SV_Target0
 {
-     float3 color = cubeTexture.Sample(cubeSampler, float3(input.texCoord, geomBuffer[input.instanceId].shineSpeedTexIdNmp.z)).xyz;
+     float3 color = cubeTexture.Sample(cubeSampler, float3(input.texCoord, GetTextureId(input.material))).xyz;
      float3 finalColor = ambientColor.xyz * color;
 
      float3 norm = float3(0, 0, 0);
-     if (lightCount.y > 0 && geomBuffer[input.instanceId].shineSpeedTexIdNmp.w > 0.0f)
+     if (lightCount.y > 0 && HasNormalMap(input.material))
      {
           float3 binorm = normalize(cross(input.normal, input.tangent));
           float3 localNorm = cubeNormalTexture.Sample(cubeNormalSampler, input.texCoord).xyz * 2.0 - 1.0;
@@ -33,5 +34,9 @@ float4 main(VSOutput input) : SV_Target0
           norm = input.normal;
      }
 
-     return float4(CalculateColor(color, norm, input.worldPos.xyz, geomBuffer[input.instanceId].shineSpeedTexIdNmp.x, false), 1.0);
+     if (lightCount.w > 0)
+     {
+          return float4(CalculateInstanceColor(color, norm, input.worldPos.xyz, GetShine(input.material), false, input.lights), 1.0);
+     }
+     return float4(CalculateColor(color, norm, input.worldPos.xyz, GetShine(input.material), false, input.position.xy), 1.0);
 }
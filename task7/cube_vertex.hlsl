@@ -7,7 +7,8 @@ struct VSInput
      float2 texCoord : TEXCOORD;
      float3 normal : NORMAL;
      float3 tangent : TANGENT;
-     uint instanceId : SV_InstanceID;
+     uint entry : INSTANCE_ENTRY;
+     uint2 lights : INSTANCE_LIGHTS;
 };
 
 struct VSOutput
@@ -17,20 +18,24 @@ struct VSOutput
      float2 texCoord : TEXCOORD;
      float3 normal : NORMAL;
      float3 tangent : TANGENT;
-     nointerpolation uint instanceId : INST_ID;
+     nointerpolation uint material : MATERIAL;
+     nointerpolation uint2 lights : LIGHTS;
 };
 
 VSOutput main(VSInput input)
 {
      VSOutput output;
 
-     unsigned int idx = input.instanceId;
-     output.worldPos = mul(geomBuffer[idx].world, float4(input.position, 1.0f));
+     GeomBuffer instance = instances[input.entry];
+     float3x4 world = GetWorldMatrix(instance, time.x);
+     output.worldPos = float4(mul(world, float4(input.position, 1.0f)), 1.0f);
      output.position = mul(viewProj, output.worldPos);
      output.texCoord = input.texCoord;
-     output.normal = mul(geomBuffer[idx].norm, float4(input.normal, 0.0f)).xyz;
-     output.tangent = mul(geomBuffer[idx].norm, float4(input.tangent, 0.0f)).xyz;
-     output.instanceId = idx;
+     // Spin keeps angles, so normals are transformed by the world matrix
+     output.normal = normalize(mul((float3x3)world, input.normal));
+     output.tangent = normalize(mul((float3x3)world, input.tangent));
+     output.material = instance.material;
+     output.lights = input.lights;
 
      return output;
 }
@@ -0,0 +1,74 @@
+#include "d3d_constant_buffer_device.h"
+#include "utils.h"
+
+D3DConstantBufferDevice::D3DConstantBufferDevice(ID3D11Device *device, ID3D11DeviceContext *deviceContext) :
+     device_(device), deviceContext_(deviceContext), pDeviceContext1_(nullptr)
+{
+     D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+     ZeroMemory(&options, sizeof(options));
+     HRESULT result = device_->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+     if (SUCCEEDED(result) && options.ConstantBufferPartialUpdate)
+     {
+          result = deviceContext_->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void **>(&pDeviceContext1_));
+          if (FAILED(result))
+               pDeviceContext1_ = nullptr;
+     }
+}
+
+D3DConstantBufferDevice::~D3DConstantBufferDevice()
+{
+     SafeRelease(pDeviceContext1_);
+}
+
+void *D3DConstantBufferDevice::CreateBuffer(const std::string &name, const unsigned size)
+{
+     D3D11_BUFFER_DESC desc;
+     ZeroMemory(&desc, sizeof(desc));
+     desc.ByteWidth = (size + 15) / 16 * 16;
+     desc.Usage = D3D11_USAGE_DEFAULT;
+     desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+     desc.CPUAccessFlags = 0;
+     desc.MiscFlags = 0;
+     desc.StructureByteStride = 0;
+
+     ID3D11Buffer *pBuffer = nullptr;
+     HRESULT result = device_->CreateBuffer(&desc, NULL, &pBuffer);
+     if (FAILED(result))
+          return nullptr;
+     result = pBuffer->SetPrivateData(WKPDID_D3DDebugObjectName, static_cast<UINT>(name.length()), name.c_str());
+     if (FAILED(result))
+     {
+          SafeRelease(pBuffer);
+          return nullptr;
+     }
+     return pBuffer;
+}
+
+void D3DConstantBufferDevice::ReleaseBuffer(void *buffer)
+{
+     SafeRelease(GetD3DBuffer(buffer));
+}
+
+bool D3DConstantBufferDevice::SupportsPartialUpdate() const
+{
+     return nullptr != pDeviceContext1_;
+}
+
+unsigned D3DConstantBufferDevice::UpdateBuffer(void *buffer, const void *data, const unsigned size, const unsigned begin, const unsigned end)
+{
+     if (nullptr == pDeviceContext1_ || (0 == begin && size == end))
+     {
+          deviceContext_->UpdateSubresource(GetD3DBuffer(buffer), 0, NULL, data, 0, 0);
+          return size;
+     }
+
+     // Source pointer addresses the first byte of the box
+     D3D11_BOX box = {begin, 0, 0, end, 1, 1};
+     pDeviceContext1_->UpdateSubresource1(GetD3DBuffer(buffer), 0, &box, static_cast<const char *>(data) + begin, 0, 0, 0);
+     return end - begin;
+}
+
+ID3D11Buffer *D3DConstantBufferDevice::GetD3DBuffer(void *buffer)
+{
+     return static_cast<ID3D11Buffer *>(buffer);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "constant_buffer_device.h"
+
+#include <d3d11.h>
+#include <d3d11_1.h>
+
+// Constant buffers in default usage. Dirty ranges are uploaded with UpdateSubresource1 when the driver
+// supports partial constant buffer updates, otherwise buffers are updated whole.
+class D3DConstantBufferDevice : public ConstantBufferDevice
+{
+public:
+     D3DConstantBufferDevice(ID3D11Device *device, ID3D11DeviceContext *deviceContext);
+     ~D3DConstantBufferDevice();
+
+     void *CreateBuffer(const std::string &name, const unsigned size) override;
+     void ReleaseBuffer(void *buffer) override;
+     bool SupportsPartialUpdate() const override;
+     unsigned UpdateBuffer(void *buffer, const void *data, const unsigned size, const unsigned begin, const unsigned end) override;
+
+     static ID3D11Buffer *GetD3DBuffer(void *buffer);
+
+private:
+     ID3D11Device *device_;
+     ID3D11DeviceContext *deviceContext_;
+     ID3D11DeviceContext1 *pDeviceContext1_;
+};
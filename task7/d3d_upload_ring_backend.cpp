@@ -0,0 +1,94 @@
+#include "d3d_upload_ring_backend.h"
+#include "utils.h"
+#include <exception>
+
+D3DUploadRingBackend::D3DUploadRingBackend(ID3D11Device *device, ID3D11DeviceContext *deviceContext, const UINT bindFlags, const unsigned capacity) :
+     deviceContext_(deviceContext), pBuffer_(nullptr), pQueries_{}, signaledFence_(0), completedFence_(0)
+{
+     D3D11_BUFFER_DESC desc;
+     ZeroMemory(&desc, sizeof(desc));
+     desc.ByteWidth = capacity;
+     desc.Usage = D3D11_USAGE_DYNAMIC;
+     desc.BindFlags = bindFlags;
+     desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+     desc.MiscFlags = 0;
+     desc.StructureByteStride = 0;
+
+     HRESULT result = device->CreateBuffer(&desc, NULL, &pBuffer_);
+     if (FAILED(result))
+          throw std::exception("Failed to create upload ring buffer");
+
+     D3D11_QUERY_DESC queryDesc;
+     queryDesc.Query = D3D11_QUERY_EVENT;
+     queryDesc.MiscFlags = 0;
+     for (auto &pQuery : pQueries_)
+     {
+          result = device->CreateQuery(&queryDesc, &pQuery);
+          if (FAILED(result))
+          {
+               for (auto &pCreated : pQueries_)
+                    SafeRelease(pCreated);
+               SafeRelease(pBuffer_);
+               throw std::exception("Failed to create upload ring fence");
+          }
+     }
+}
+
+D3DUploadRingBackend::~D3DUploadRingBackend()
+{
+     for (auto &pQuery : pQueries_)
+          SafeRelease(pQuery);
+     SafeRelease(pBuffer_);
+}
+
+void *D3DUploadRingBackend::Map(const bool discard)
+{
+     D3D11_MAPPED_SUBRESOURCE mappedResource;
+     HRESULT result = deviceContext_->Map(pBuffer_, 0, discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mappedResource);
+     if (FAILED(result))
+          return nullptr;
+     return mappedResource.pData;
+}
+
+void D3DUploadRingBackend::Unmap()
+{
+     deviceContext_->Unmap(pBuffer_, 0);
+}
+
+std::uint64_t D3DUploadRingBackend::SignalFence()
+{
+     // Queries are reused in a ring, the oldest one has to be finished before it is issued again
+     while (signaledFence_ - completedFence_ >= maxFramesInFlight_)
+          PollFence(true);
+
+     ++signaledFence_;
+     deviceContext_->End(pQueries_[signaledFence_ % maxFramesInFlight_]);
+     return signaledFence_;
+}
+
+std::uint64_t D3DUploadRingBackend::GetCompletedFence()
+{
+     while (completedFence_ < signaledFence_ && PollFence(false))
+     {
+     }
+     return completedFence_;
+}
+
+bool D3DUploadRingBackend::PollFence(const bool flush)
+{
+     BOOL done = FALSE;
+     HRESULT result = deviceContext_->GetData(
+          pQueries_[(completedFence_ + 1) % maxFramesInFlight_],
+          &done,
+          sizeof(done),
+          flush ? 0 : D3D11_ASYNC_GETDATA_DONOTFLUSH);
+     if (S_OK != result || !done)
+          return false;
+     ++completedFence_;
+     return true;
+}
+
+ID3D11Buffer *D3DUploadRingBackend::GetBuffer()
+{
+     return pBuffer_;
+}
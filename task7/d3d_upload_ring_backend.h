@@ -0,0 +1,32 @@
+#pragma once
+
+#include "upload_ring_backend.h"
+
+#include <d3d11.h>
+
+// Dynamic buffer with event queries as fences. Mapping constant buffers without overwrite
+// requires the driver to report MapNoOverwriteOnDynamicConstantBuffer.
+class D3DUploadRingBackend : public UploadRingBackend
+{
+public:
+     D3DUploadRingBackend(ID3D11Device *device, ID3D11DeviceContext *deviceContext, const UINT bindFlags, const unsigned capacity);
+     ~D3DUploadRingBackend();
+
+     void *Map(const bool discard) override;
+     void Unmap() override;
+     std::uint64_t SignalFence() override;
+     std::uint64_t GetCompletedFence() override;
+
+     ID3D11Buffer *GetBuffer();
+
+private:
+     static constexpr const unsigned maxFramesInFlight_ = 8;
+
+     bool PollFence(const bool flush);
+
+     ID3D11DeviceContext *deviceContext_;
+     ID3D11Buffer *pBuffer_;
+     ID3D11Query *pQueries_[maxFramesInFlight_];
+     std::uint64_t signaledFence_;
+     std::uint64_t completedFence_;
+};
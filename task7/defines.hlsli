@@ -1,2 +0,0 @@
-#define MAX_LIGHTS 10
-#define MAX_CUBES 100
@@ -0,0 +1,60 @@
+#include "frame_arena.h"
+
+#include <cstdint>
+
+namespace
+{
+
+     char *AlignUp(char *pointer, const std::size_t alignment)
+     {
+          const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(pointer);
+          return pointer + ((alignment - address % alignment) % alignment);
+     }
+
+}
+
+FrameArena::FrameArena(const std::size_t capacity) :
+     block_(new char[capacity]),
+     capacity_(capacity),
+     offset_(0),
+     overflowSize_(0)
+{
+}
+
+void FrameArena::Reset()
+{
+     if (!overflowBlocks_.empty())
+     {
+          capacity_ += overflowSize_;
+          block_.reset(new char[capacity_]);
+          overflowBlocks_.clear();
+     }
+     offset_ = 0;
+     overflowSize_ = 0;
+}
+
+void *FrameArena::Allocate(const std::size_t size, const std::size_t alignment)
+{
+     char *const begin = block_.get() + offset_;
+     char *const aligned = AlignUp(begin, alignment);
+     const std::size_t padding = static_cast<std::size_t>(aligned - begin);
+     if (padding + size <= capacity_ - offset_)
+     {
+          offset_ += padding + size;
+          return aligned;
+     }
+
+     overflowBlocks_.emplace_back(new char[size + alignment]);
+     overflowSize_ += size + alignment;
+     return AlignUp(overflowBlocks_.back().get(), alignment);
+}
+
+std::size_t FrameArena::GetCapacity() const
+{
+     return capacity_;
+}
+
+std::size_t FrameArena::GetUsed() const
+{
+     return offset_ + overflowSize_;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for data living until the end of frame, everything is released by Reset at frame start.
+// Allocations that do not fit get separate blocks, and the next Reset grows the main block to the frame's
+// total so steady state frames do not touch the heap.
+class FrameArena
+{
+public:
+     FrameArena(const std::size_t capacity);
+     FrameArena(const FrameArena &) = delete;
+     void Reset();
+     void *Allocate(const std::size_t size, const std::size_t alignment);
+     // Uninitialized array, only for types without destructors since nothing is destroyed on Reset
+     template <typename T>
+     T *Allocate(const std::size_t count)
+     {
+          static_assert(std::is_trivially_destructible<T>::value, "Frame arena does not call destructors");
+          return static_cast<T *>(Allocate(count * sizeof(T), alignof(T)));
+     }
+     std::size_t GetCapacity() const;
+     std::size_t GetUsed() const;
+
+private:
+     std::unique_ptr<char[]> block_;
+     std::size_t capacity_;
+     std::size_t offset_;
+     std::size_t overflowSize_;
+     std::vector<std::unique_ptr<char[]>> overflowBlocks_;
+};
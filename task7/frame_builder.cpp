@@ -0,0 +1,372 @@
+#include "frame_builder.h"
+#include "instance_transform.h"
+#include "parallel_culling.h"
+
+#include <algorithm>
+#include <cfloat>
+
+FrameBuilder::FrameBuilder(const Settings &settings, ThreadPool &threadPool, FrameArena &frameArena) :
+     settings_(settings),
+     threadPool_(threadPool),
+     frameArena_(frameArena),
+     usePvs_(settings.usePvs),
+     pvsBaked_(false),
+     pCubes_(nullptr),
+     cubeMeshBounds_{},
+     occluderVertices_(nullptr),
+     occluderVertexCount_(0),
+     occluderVertexStride_(0),
+     occluderIndices_(nullptr),
+     occluderIndexCount_(0),
+     frustum_(settings.nearZ),
+     cubeOctree_(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), settings.octreeHalfSize, settings.octreeDepth),
+     contributionCuller_(settings.minPixelRadius),
+     lightClusterer_(
+          settings.clusterTileNumberX,
+          settings.clusterTileNumberY,
+          settings.clusterSliceNumber,
+          settings.nearZ,
+          settings.farZ)
+{
+}
+
+void FrameBuilder::SetCubes(
+     const InstanceStorage &cubes,
+     const MeshBounds &meshBounds,
+     const void *vertices,
+     const std::size_t vertexCount,
+     const std::size_t vertexStride,
+     const unsigned short *indices,
+     const std::size_t indexCount)
+{
+     pCubes_ = &cubes;
+     cubeMeshBounds_ = meshBounds;
+     occluderVertices_ = vertices;
+     occluderVertexCount_ = vertexCount;
+     occluderVertexStride_ = vertexStride;
+     occluderIndices_ = indices;
+     occluderIndexCount_ = indexCount;
+
+     // The spin sphere bounds a cube at any angle, so bounds are not transformed every frame
+     const Sphere spinSphere = SpinSphere(meshBounds.sphere);
+     const std::size_t cubeNumber = cubes.GetSize();
+     for (auto &bounds : cubeBounds_)
+          bounds.resize(cubeNumber);
+     for (auto &spheres : cubeSpheres_)
+          spheres.resize(cubeNumber);
+     for (std::size_t i = 0; i < cubeNumber; ++i)
+     {
+          const Sphere sphere{
+               DirectX::XMFLOAT3(
+                    cubes.GetPositions(0)[i] + spinSphere.center.x,
+                    cubes.GetPositions(1)[i] + spinSphere.center.y,
+                    cubes.GetPositions(2)[i] + spinSphere.center.z),
+               spinSphere.radius};
+          const Aabb box = SphereToAabb(sphere);
+          cubeBounds_[0][i] = box.min.x;
+          cubeBounds_[1][i] = box.min.y;
+          cubeBounds_[2][i] = box.min.z;
+          cubeBounds_[3][i] = box.max.x;
+          cubeBounds_[4][i] = box.max.y;
+          cubeBounds_[5][i] = box.max.z;
+          cubeSpheres_[0][i] = sphere.center.x;
+          cubeSpheres_[1][i] = sphere.center.y;
+          cubeSpheres_[2][i] = sphere.center.z;
+          cubeSpheres_[3][i] = sphere.radius;
+     }
+
+     // Structures over the old cube set are rebuilt on the next frame
+     cubeBvh_ = Bvh();
+     visibilityCache_.Reset();
+     cubeOctree_.Clear();
+     for (std::size_t i = 0; i < cubeNumber; ++i)
+          cubeOctree_.Insert(DirectX::XMFLOAT3(cubeSpheres_[0][i], cubeSpheres_[1][i], cubeSpheres_[2][i]), cubeSpheres_[3][i]);
+
+     pvsBaked_ = false;
+     if (usePvs_)
+          BakePvs();
+}
+
+void FrameBuilder::BuildEntries(FramePacket &packet)
+{
+     const std::size_t cubeNumber = GetCubeNumber();
+     frustum_.Construct(DirectX::XMLoadFloat4x4(&packet.view), DirectX::XMLoadFloat4x4(&packet.proj));
+     std::uint32_t *visible = frameArena_.Allocate<std::uint32_t>(cubeNumber);
+     std::size_t visibleNumber = CullFrustum(packet.pov, visible);
+
+     if (usePvs_)
+          visibleNumber = cubePvs_.Filter(packet.pov, visible, visibleNumber);
+
+     if (settings_.useContributionCulling)
+     {
+          contributionCuller_.SetView(packet.pov, settings_.fovY, packet.height);
+          visibleNumber = contributionCuller_.Filter(
+               cubeSpheres_[0].data(),
+               cubeSpheres_[1].data(),
+               cubeSpheres_[2].data(),
+               cubeSpheres_[3].data(),
+               nullptr,
+               cubeNumber,
+               visible,
+               visibleNumber);
+     }
+
+     if (settings_.useOcclusionCulling)
+          visibleNumber = CullOccluded(packet, visible, visibleNumber);
+
+     packet.visibleEntries.assign(visible, visible + visibleNumber);
+}
+
+void FrameBuilder::BuildLights(FramePacket &packet, Lights &lights, const Sphere *planeSpheres, const std::size_t planeNumber)
+{
+     // Lights are evaluated straight into the packet, its arrays keep their capacity
+     packet.lightPositions.resize(lights.GetNumber());
+     packet.lightColors.resize(lights.GetNumber());
+     lights.Evaluate(packet.time, packet.lightPositions.data(), packet.lightColors.data());
+
+     const std::size_t lightNumber = packet.lightPositions.size();
+     if (lightBvh_.GetSize() != lightNumber || 0 == packet.frameIndex % settings_.lightBvhRebuildPeriod)
+          lightBvh_.Build(packet.lightPositions.data(), packet.lightColors.data(), lightNumber);
+     else
+          lightBvh_.Refit(packet.lightPositions.data(), packet.lightColors.data());
+
+     // Only lights whose influence sphere reaches the frustum are uploaded, sorted indices keep their order
+     // and let them be compacted in place
+     std::uint32_t *visibleLightIndices = frameArena_.Allocate<std::uint32_t>(lightNumber);
+     const std::size_t visibleLightNumber = lightBvh_.QueryFrustum(frustum_, visibleLightIndices);
+     std::sort(visibleLightIndices, visibleLightIndices + visibleLightNumber);
+     for (std::size_t i = 0; i < visibleLightNumber; ++i)
+     {
+          packet.lightPositions[i] = packet.lightPositions[visibleLightIndices[i]];
+          packet.lightColors[i] = packet.lightColors[visibleLightIndices[i]];
+     }
+     packet.lightPositions.resize(visibleLightNumber);
+     packet.lightColors.resize(visibleLightNumber);
+
+     // Instance lights shade every object, so clusters are only built without them
+     const std::size_t visibleNumber = packet.visibleEntries.size();
+     packet.visibleLights.resize(visibleNumber);
+     if (!settings_.useInstanceLights)
+     {
+          lightClusterer_.Build(
+               packet.view,
+               settings_.fovY,
+               packet.width / static_cast<float>(packet.height),
+               packet.lightPositions.data(),
+               packet.lightPositions.size(),
+               threadPool_,
+               packet.clusterRanges,
+               packet.clusterLightIndices);
+          return;
+     }
+
+     // Strongest lights of every visible cube and plane, ranked at its bounding sphere
+     // Cubes share one spin sphere radius
+     float maxRadius = 0 != GetCubeNumber() ? cubeSpheres_[3][0] : 0.0f;
+     for (std::size_t i = 0; i < planeNumber; ++i)
+          maxRadius = std::max(maxRadius, planeSpheres[i].radius);
+     lightAssigner_.Build(packet.lightPositions.data(), packet.lightColors.data(), packet.lightPositions.size(), maxRadius);
+     for (std::size_t i = 0; i < planeNumber; ++i)
+          packet.planeLights[i] = lightAssigner_.Assign(
+               planeSpheres[i].center.x,
+               planeSpheres[i].center.y,
+               planeSpheres[i].center.z,
+               planeSpheres[i].radius);
+     const std::uint32_t *visible = packet.visibleEntries.data();
+     PackedLightIndices *visibleLights = packet.visibleLights.data();
+     const std::size_t chunkSize = settings_.instanceChunkSize;
+     threadPool_.Run(
+          (visibleNumber + chunkSize - 1) / chunkSize,
+          [this, visibleNumber, chunkSize, visible, visibleLights](std::size_t chunk)
+          {
+               const std::size_t begin = chunk * chunkSize;
+               const std::size_t end = std::min(visibleNumber, begin + chunkSize);
+               lightAssigner_.Assign(
+                    cubeSpheres_[0].data(),
+                    cubeSpheres_[1].data(),
+                    cubeSpheres_[2].data(),
+                    cubeSpheres_[3].data(),
+                    visible + begin,
+                    end - begin,
+                    visibleLights + begin);
+          });
+}
+
+void FrameBuilder::SetPvsEnabled(const bool enabled)
+{
+     usePvs_ = enabled;
+     if (usePvs_ && !pvsBaked_ && nullptr != pCubes_)
+          BakePvs();
+}
+
+bool FrameBuilder::IsPvsEnabled() const
+{
+     return usePvs_;
+}
+
+const Frustum &FrameBuilder::GetFrustum() const
+{
+     return frustum_;
+}
+
+const LightClusterer &FrameBuilder::GetLightClusterer() const
+{
+     return lightClusterer_;
+}
+
+std::size_t FrameBuilder::GetCubeNumber() const
+{
+     return cubeSpheres_[0].size();
+}
+
+const float *FrameBuilder::GetCubeBounds(const int component) const
+{
+     return cubeBounds_[component].data();
+}
+
+const float *FrameBuilder::GetCubeSpheres(const int component) const
+{
+     return cubeSpheres_[component].data();
+}
+
+std::size_t FrameBuilder::CullFrustum(const DirectX::XMFLOAT3 &pov, std::uint32_t *visible)
+{
+     const std::size_t cubeNumber = GetCubeNumber();
+     if (CullingMode::Bvh == settings_.cullingMode)
+     {
+          // Cube bounds do not change with spin, so the hierarchy is only rebuilt when cubes are set
+          if (cubeBvh_.GetSize() != cubeNumber)
+               cubeBvh_.Build(
+                    cubeBounds_[0].data(),
+                    cubeBounds_[1].data(),
+                    cubeBounds_[2].data(),
+                    cubeBounds_[3].data(),
+                    cubeBounds_[4].data(),
+                    cubeBounds_[5].data(),
+                    cubeNumber);
+          return cubeBvh_.Cull(frustum_, visible);
+     }
+     if (CullingMode::Temporal == settings_.cullingMode)
+     {
+          return visibilityCache_.Cull(
+               frustum_,
+               pov,
+               cubeSpheres_[0].data(),
+               cubeSpheres_[1].data(),
+               cubeSpheres_[2].data(),
+               cubeSpheres_[3].data(),
+               cubeNumber,
+               visible);
+     }
+     if (CullingMode::Octree == settings_.cullingMode)
+     {
+          // Octree handles match cube indices since cubes are inserted in order into an empty tree
+          std::size_t visibleNumber = 0;
+          cubeOctree_.VisitFrustum(
+               frustum_,
+               [visible, &visibleNumber](std::uint32_t handle)
+               {
+                    visible[visibleNumber++] = handle;
+               });
+          return visibleNumber;
+     }
+     return CheckRectanglesParallel(
+          frustum_,
+          cubeBounds_[0].data(),
+          cubeBounds_[1].data(),
+          cubeBounds_[2].data(),
+          cubeBounds_[3].data(),
+          cubeBounds_[4].data(),
+          cubeBounds_[5].data(),
+          cubeNumber,
+          settings_.cullingChunkSize,
+          threadPool_,
+          frameArena_,
+          visible);
+}
+
+std::size_t FrameBuilder::CullOccluded(const FramePacket &packet, std::uint32_t *visible, const std::size_t visibleNumber)
+{
+     // Closest visible cubes are the best occluders
+     const DirectX::XMFLOAT3 &pov = packet.pov;
+     const float *posX = pCubes_->GetPositions(0);
+     const float *posY = pCubes_->GetPositions(1);
+     const float *posZ = pCubes_->GetPositions(2);
+     std::uint32_t *occluders = frameArena_.Allocate<std::uint32_t>(visibleNumber);
+     std::copy(visible, visible + visibleNumber, occluders);
+     const std::size_t occluderNumber = std::min(settings_.maxOccluderNumber, visibleNumber);
+     const auto distanceSq = [posX, posY, posZ, &pov](std::uint32_t i)
+     {
+          const float dx = posX[i] - pov.x;
+          const float dy = posY[i] - pov.y;
+          const float dz = posZ[i] - pov.z;
+          return dx * dx + dy * dy + dz * dz;
+     };
+     std::partial_sort(
+          occluders,
+          occluders + occluderNumber,
+          occluders + visibleNumber,
+          [&distanceSq](std::uint32_t a, std::uint32_t b) { return distanceSq(a) < distanceSq(b); });
+
+     DirectX::XMMATRIX *occluderWorldMatrices = frameArena_.Allocate<DirectX::XMMATRIX>(occluderNumber);
+     ComputeSpinWorldMatrices(
+          posX,
+          posY,
+          posZ,
+          pCubes_->GetRotationSpeeds(),
+          packet.time,
+          occluders,
+          occluderNumber,
+          occluderWorldMatrices,
+          sizeof(DirectX::XMMATRIX));
+
+     occlusionCuller_.Clear(DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&packet.view), DirectX::XMLoadFloat4x4(&packet.proj)));
+     for (std::size_t i = 0; i < occluderNumber; ++i)
+          occlusionCuller_.RenderOccluder(
+               occluderVertices_,
+               occluderVertexCount_,
+               occluderVertexStride_,
+               occluderIndices_,
+               occluderIndexCount_,
+               occluderWorldMatrices[i]);
+     occlusionCuller_.BuildHiZ();
+     return occlusionCuller_.Filter(
+          cubeBounds_[0].data(),
+          cubeBounds_[1].data(),
+          cubeBounds_[2].data(),
+          cubeBounds_[3].data(),
+          cubeBounds_[4].data(),
+          cubeBounds_[5].data(),
+          visible,
+          visibleNumber);
+}
+
+void FrameBuilder::BakePvs()
+{
+     // Cubes only spin in place, so their layout is static
+     const Aabb innerBox = SpinInnerAabb(cubeMeshBounds_.box);
+     const Aabb outerBox = SpinOuterAabb(cubeMeshBounds_.box);
+     std::vector<Aabb> occluders;
+     std::vector<Aabb> targets;
+     Aabb region{
+          DirectX::XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX),
+          DirectX::XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX)};
+     const float margin = settings_.pvsMargin;
+     for (std::size_t i = 0; i < pCubes_->GetSize(); ++i)
+     {
+          const DirectX::XMFLOAT3 pos(pCubes_->GetPositions(0)[i], pCubes_->GetPositions(1)[i], pCubes_->GetPositions(2)[i]);
+          const auto world = DirectX::XMMatrixTranslation(pos.x, pos.y, pos.z);
+          occluders.push_back(TransformAabb(innerBox, world));
+          targets.push_back(TransformAabb(outerBox, world));
+          region.min = DirectX::XMFLOAT3(
+               std::min(region.min.x, pos.x - margin),
+               std::min(region.min.y, pos.y - margin),
+               std::min(region.min.z, pos.z - margin));
+          region.max = DirectX::XMFLOAT3(
+               std::max(region.max.x, pos.x + margin),
+               std::max(region.max.y, pos.y + margin),
+               std::max(region.max.z, pos.z + margin));
+     }
+     cubePvs_.Bake(region, settings_.pvsCellSize, occluders, targets, threadPool_);
+     pvsBaked_ = true;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "bounding_volume.h"
+#include "bvh.h"
+#include "contribution_culler.h"
+#include "frame_arena.h"
+#include "frame_packet.h"
+#include "frustum.h"
+#include "instance_storage.h"
+#include "light_assigner.h"
+#include "light_bvh.h"
+#include "light_clusterer.h"
+#include "lights.h"
+#include "loose_octree.h"
+#include "occlusion_culler.h"
+#include "pvs.h"
+#include "thread_pool.h"
+#include "visibility_cache.h"
+
+#include <directxmath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU side of a frame, free of D3D so it runs in tests. Culls resident spinning cubes into the visible entry
+// list of a frame packet: frustum culling by the selected structure, then PVS, contribution and occlusion
+// culling, every stage keeping the order of the previous one. Then fills the packet lights for the same view.
+class FrameBuilder
+{
+public:
+     enum class CullingMode
+     {
+          Batch,
+          Bvh,
+          Temporal,
+          Octree
+     };
+
+     struct Settings
+     {
+          CullingMode cullingMode;
+          float nearZ;
+          float fovY;
+          std::size_t cullingChunkSize;
+          float octreeHalfSize;
+          unsigned octreeDepth;
+          bool useContributionCulling;
+          float minPixelRadius;
+          bool usePvs;
+          float pvsCellSize;
+          float pvsMargin;
+          bool useOcclusionCulling;
+          std::size_t maxOccluderNumber;
+          float farZ;
+          unsigned clusterTileNumberX;
+          unsigned clusterTileNumberY;
+          unsigned clusterSliceNumber;
+          bool useInstanceLights;
+          std::size_t instanceChunkSize;
+          std::uint64_t lightBvhRebuildPeriod;
+     };
+
+     FrameBuilder(const Settings &settings, ThreadPool &threadPool, FrameArena &frameArena);
+     FrameBuilder(const FrameBuilder &) = delete;
+     // Cubes spin in place around their vertical axis, so bounds covering the mesh at any angle are computed
+     // once here. The mesh is rasterized for occlusion culling, position must be the first field of vertex.
+     // Storage and mesh are referenced and must outlive the builder.
+     void SetCubes(
+          const InstanceStorage &cubes,
+          const MeshBounds &meshBounds,
+          const void *vertices,
+          const std::size_t vertexCount,
+          const std::size_t vertexStride,
+          const unsigned short *indices,
+          const std::size_t indexCount);
+     // Culls with view, proj, pov, height and time of the packet and writes its visibleEntries
+     void BuildEntries(FramePacket &packet);
+     // Evaluates lights at packet time and keeps those reaching the frustum of the last BuildEntries. With instance
+     // lights visible entries and planes (at most two) get their strongest lights, clusters are built otherwise.
+     void BuildLights(FramePacket &packet, Lights &lights, const Sphere *planeSpheres, const std::size_t planeNumber);
+     // Sets are baked on the first enable after cubes are set, which takes a while
+     void SetPvsEnabled(const bool enabled);
+     bool IsPvsEnabled() const;
+
+     const Frustum &GetFrustum() const;
+     const LightClusterer &GetLightClusterer() const;
+     std::size_t GetCubeNumber() const;
+     // Spin bounds of cubes: box min x, y, z, max x, y, z and sphere center x, y, z, radius
+     const float *GetCubeBounds(const int component) const;
+     const float *GetCubeSpheres(const int component) const;
+
+private:
+     std::size_t CullFrustum(const DirectX::XMFLOAT3 &pov, std::uint32_t *visible);
+     std::size_t CullOccluded(const FramePacket &packet, std::uint32_t *visible, const std::size_t visibleNumber);
+     void BakePvs();
+
+     const Settings settings_;
+     ThreadPool &threadPool_;
+     FrameArena &frameArena_;
+
+     bool usePvs_;
+     bool pvsBaked_;
+
+     const InstanceStorage *pCubes_;
+     MeshBounds cubeMeshBounds_;
+     const void *occluderVertices_;
+     std::size_t occluderVertexCount_;
+     std::size_t occluderVertexStride_;
+     const unsigned short *occluderIndices_;
+     std::size_t occluderIndexCount_;
+     std::vector<float> cubeBounds_[6];
+     std::vector<float> cubeSpheres_[4];
+
+     Frustum frustum_;
+     Bvh cubeBvh_;
+     VisibilityCache visibilityCache_;
+     LooseOctree cubeOctree_;
+     Pvs cubePvs_;
+     ContributionCuller contributionCuller_;
+     OcclusionCuller occlusionCuller_;
+     LightBvh lightBvh_;
+     LightClusterer lightClusterer_;
+     LightAssigner lightAssigner_;
+};
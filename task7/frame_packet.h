@@ -0,0 +1,29 @@
+#pragma once
+
+#include "light_assigner.h"
+#include "light_clusterer.h"
+
+#include <directxmath.h>
+#include <cstdint>
+#include <vector>
+
+// Everything Render needs to draw a frame. Update fills it on the simulation thread and it is only read
+// after publishing. Vectors keep their capacity between frames, so steady state frames do not allocate.
+struct FramePacket
+{
+     std::uint64_t frameIndex;
+     unsigned width;
+     unsigned height;
+     DirectX::XMFLOAT4X4 view;
+     DirectX::XMFLOAT4X4 proj;
+     DirectX::XMFLOAT3 pov;
+     double time; // animation time in seconds
+     std::vector<std::uint32_t> visibleEntries; // resident instance indices
+     std::vector<PackedLightIndices> visibleLights; // per visible entry
+     PackedLightIndices planeLights[2]; // per transparent plane
+     std::vector<DirectX::XMFLOAT4> lightPositions; // w - influence radius
+     std::vector<DirectX::XMFLOAT4> lightColors;
+     // Empty when instance lights are used
+     std::vector<ClusterRange> clusterRanges;
+     std::vector<std::uint32_t> clusterLightIndices;
+};
@@ -1,6 +1,9 @@
 #include "frustum.h"
+#include "box_planes.h"
 
 #include <cmath>
+#include <algorithm>
+#include <immintrin.h>
 
 namespace
 {
@@ -115,3 +118,89 @@ bool Frustum::CheckRectangle(float maxWidth, float maxHeight, float maxDepth, fl
 
      return true;
 }
+
+bool Frustum::CheckRectangleMasked(const float *min, const float *max, unsigned &planeMask) const
+{
+     for (int i = 0; i < 6; ++i)
+     {
+          if (0 == (planeMask & (1u << i)))
+               continue;
+
+          if (PVertexDistance(planes_[i], min[0], min[1], min[2], max[0], max[1], max[2]) < 0.0f)
+               return false;
+
+          const float nVertexDistance =
+               std::min(planes_[i][0] * min[0], planes_[i][0] * max[0]) +
+               std::min(planes_[i][1] * min[1], planes_[i][1] * max[1]) +
+               std::min(planes_[i][2] * min[2], planes_[i][2] * max[2]) +
+               planes_[i][3];
+          if (nVertexDistance >= 0.0f)
+               planeMask &= ~(1u << i);
+     }
+
+     return true;
+}
+
+bool Frustum::CheckSphere(const DirectX::XMFLOAT3 &center, float radius) const
+{
+     for (int i = 0; i < 6; ++i)
+     {
+          const float distance = planes_[i][0] * center.x + planes_[i][1] * center.y + planes_[i][2] * center.z + planes_[i][3];
+          if (distance < -radius)
+               return false;
+     }
+
+     return true;
+}
+
+const float *Frustum::GetPlane(const int index) const
+{
+     return planes_[index];
+}
+
+std::size_t Frustum::CheckRectangles(
+     const float *minX,
+     const float *minY,
+     const float *minZ,
+     const float *maxX,
+     const float *maxY,
+     const float *maxZ,
+     const std::size_t count,
+     std::uint32_t *visibleIndices) const
+{
+     std::size_t visibleNumber = 0;
+     std::size_t i = 0;
+
+#if defined(__AVX2__)
+     for (; i + 8 <= count; i += 8)
+     {
+          const int mask = _mm256_movemask_ps(CheckBoxPlanes8(LoadBoxBatch8(minX, minY, minZ, maxX, maxY, maxZ, i), planes_[0], 6));
+          for (int lane = 0; lane < 8; ++lane)
+          {
+               visibleIndices[visibleNumber] = static_cast<std::uint32_t>(i + lane);
+               visibleNumber += (mask >> lane) & 1;
+          }
+     }
+#endif
+
+     for (; i + 4 <= count; i += 4)
+     {
+          const int mask = _mm_movemask_ps(CheckBoxPlanes4(LoadBoxBatch4(minX, minY, minZ, maxX, maxY, maxZ, i), planes_[0], 6));
+          for (int lane = 0; lane < 4; ++lane)
+          {
+               visibleIndices[visibleNumber] = static_cast<std::uint32_t>(i + lane);
+               visibleNumber += (mask >> lane) & 1;
+          }
+     }
+
+     for (; i < count; ++i)
+     {
+          bool inside = true;
+          for (int p = 0; p < 6 && inside; ++p)
+               inside = PVertexDistance(planes_[p], minX[i], minY[i], minZ[i], maxX[i], maxY[i], maxZ[i]) >= 0.0f;
+          visibleIndices[visibleNumber] = static_cast<std::uint32_t>(i);
+          visibleNumber += inside;
+     }
+
+     return visibleNumber;
+}
@@ -1,15 +1,36 @@
 #pragma once
 
 #include <directxmath.h>
+#include <cstddef>
+#include <cstdint>
 
 class Frustum
 {
 public:
+     static constexpr const unsigned allPlanesMask = 0x3F;
+
      Frustum(const float screenDepth);
      void Construct(DirectX::XMMATRIX view, DirectX::XMMATRIX projection);
      bool CheckRectangle(float maxWidth, float maxHeight, float maxDepth, float minWidth, float minHeight, float minDepth);
+     // Batch version of CheckRectangle over structure-of-arrays boxes.
+     // Writes indices of visible boxes to visibleIndices (must hold count elements), returns their number.
+     std::size_t CheckRectangles(
+          const float *minX,
+          const float *minY,
+          const float *minZ,
+          const float *maxX,
+          const float *maxY,
+          const float *maxZ,
+          const std::size_t count,
+          std::uint32_t *visibleIndices) const;
+     // Tests box (min, max are xyz) against planes set in planeMask and clears bits of planes the box is fully inside.
+     // Returns false if the box is outside of one of tested planes.
+     bool CheckRectangleMasked(const float *min, const float *max, unsigned &planeMask) const;
+     bool CheckSphere(const DirectX::XMFLOAT3 &center, float radius) const;
+     // Normalized plane (normal xyz, offset w), inside is positive
+     const float *GetPlane(const int index) const;
 
 private:
      const float screenDepth_;
      float planes_[6][4];
-};
\ No newline at end of file
+};
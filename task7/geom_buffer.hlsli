@@ -1,13 +1,33 @@
-#include "defines.hlsli"
-
 struct GeomBuffer
 {
-     float4x4 world;
-     float4x4 norm;
-     float4 shineSpeedTexIdNmp; // x - specular power, y - rotation speed, z - texture id, w - normal map presence
+     float4 placement; // xyz - position, w - rotation speed around vertical axis in radians per second
+     uint material; // bits 0-14 - texture id, bit 15 - normal map presence, bits 16-31 - specular power as half
 };
 
-cbuffer GeomBufferInstancing : register (b0)
+StructuredBuffer<GeomBuffer> instances : register (t2);
+
+// Transposed affine world matrix RotationY(rotation speed * time) * Translation(position)
+float3x4 GetWorldMatrix(in GeomBuffer instance, in float animationTime)
 {
-     GeomBuffer geomBuffer[MAX_CUBES];
-};
+     float s, c;
+     sincos(instance.placement.w * animationTime, s, c);
+     return float3x4(
+          c, 0.0f, s, instance.placement.x,
+          0.0f, 1.0f, 0.0f, instance.placement.y,
+          -s, 0.0f, c, instance.placement.z);
+}
+
+float GetShine(in uint material)
+{
+     return f16tof32(material >> 16);
+}
+
+float GetTextureId(in uint material)
+{
+     return (float)(material & 0x7FFF);
+}
+
+bool HasNormalMap(in uint material)
+{
+     return (material & 0x8000) != 0;
+}
@@ -1,10 +1,13 @@
 #include "input.h"
+#include <algorithm>
 #include <stdexcept>
 
 Input::Input(const HINSTANCE hInstance, const HWND hWnd) :
      pDirectInput_(NULL),
      pKeyboard_(NULL),
      pMouse_(NULL),
+     keyboardState_{},
+     previousKeyboardState_{},
      mouseState_({})
 {
      auto result = DirectInput8Create(
@@ -67,6 +70,7 @@ Input::~Input()
 
 bool Input::ReadKeyboard()
 {
+     std::copy(keyboardState_, keyboardState_ + sizeof(keyboardState_), previousKeyboardState_);
      auto result = pKeyboard_->GetDeviceState(sizeof(keyboardState_), reinterpret_cast<void *>(&keyboardState_));
      if (SUCCEEDED(result))
           return true;
@@ -99,3 +103,13 @@ DirectX::XMFLOAT3 Input::GetMouseState()
                static_cast<float>(mouseState_.lZ));
      return DirectX::XMFLOAT3(0, 0, 0);
 }
+
+bool Input::IsKeyDown(const unsigned char key) const
+{
+     return 0 != (keyboardState_[key] & 0x80);
+}
+
+bool Input::IsKeyPressed(const unsigned char key) const
+{
+     return IsKeyDown(key) && 0 == (previousKeyboardState_[key] & 0x80);
+}
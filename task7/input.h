@@ -13,6 +13,9 @@ public:
      ~Input();
      bool Update();
      DirectX::XMFLOAT3 GetMouseState();
+     bool IsKeyDown(const unsigned char key) const;
+     // Key went down since the previous Update
+     bool IsKeyPressed(const unsigned char key) const;
 
 protected:
      bool ReadKeyboard();
@@ -23,5 +26,6 @@ protected:
      IDirectInputDevice8 *pMouse_;
 
      unsigned char keyboardState_[256];
+     unsigned char previousKeyboardState_[256];
      DIMOUSESTATE mouseState_;
 };
@@ -0,0 +1,86 @@
+#include "instance_buffer.h"
+#include "utils.h"
+#include <exception>
+
+InstanceBuffer::InstanceBuffer(ID3D11Device *device, const unsigned stride, const unsigned capacity) :
+     device_(device), stride_(stride), capacity_(0), pBuffer_(nullptr), pSRV_(nullptr)
+{
+     if (!Resize(capacity > 0 ? capacity : 1))
+          throw std::exception("Failed to create instance buffer");
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+     SafeRelease(pSRV_);
+     SafeRelease(pBuffer_);
+}
+
+bool InstanceBuffer::Resize(const unsigned capacity)
+{
+     SafeRelease(pSRV_);
+     SafeRelease(pBuffer_);
+     pSRV_ = nullptr;
+     pBuffer_ = nullptr;
+     capacity_ = 0;
+
+     D3D11_BUFFER_DESC desc;
+     ZeroMemory(&desc, sizeof(desc));
+     desc.ByteWidth = stride_ * capacity;
+     desc.Usage = D3D11_USAGE_DYNAMIC;
+     desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+     desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+     desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+     desc.StructureByteStride = stride_;
+
+     HRESULT result = device_->CreateBuffer(&desc, NULL, &pBuffer_);
+     if (FAILED(result))
+          return false;
+
+     D3D11_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc;
+     ZeroMemory(&shaderResourceViewDesc, sizeof(shaderResourceViewDesc));
+     shaderResourceViewDesc.Format = DXGI_FORMAT_UNKNOWN;
+     shaderResourceViewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+     shaderResourceViewDesc.Buffer.FirstElement = 0;
+     shaderResourceViewDesc.Buffer.NumElements = capacity;
+
+     result = device_->CreateShaderResourceView(pBuffer_, &shaderResourceViewDesc, &pSRV_);
+     if (FAILED(result))
+          return false;
+
+     capacity_ = capacity;
+     return true;
+}
+
+void *InstanceBuffer::Map(ID3D11DeviceContext *deviceContext, const unsigned count)
+{
+     if (count > capacity_)
+     {
+          unsigned capacity = capacity_ > 0 ? capacity_ : 1;
+          while (capacity < count)
+               capacity *= 2;
+          if (!Resize(capacity))
+               return nullptr;
+     }
+
+     D3D11_MAPPED_SUBRESOURCE mappedResource;
+     HRESULT result = deviceContext->Map(pBuffer_, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+     if (FAILED(result))
+          return nullptr;
+
+     return mappedResource.pData;
+}
+
+void InstanceBuffer::Unmap(ID3D11DeviceContext *deviceContext)
+{
+     deviceContext->Unmap(pBuffer_, 0);
+}
+
+unsigned InstanceBuffer::GetCapacity() const
+{
+     return capacity_;
+}
+
+ID3D11ShaderResourceView *InstanceBuffer::GetSRV()
+{
+     return pSRV_;
+}
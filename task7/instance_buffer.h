@@ -0,0 +1,26 @@
+#pragma once
+
+#include <d3d11.h>
+
+// Dynamic structured buffer of per instance data read by shaders through SRV.
+// Grows by doubling, so instance number is not limited by constant buffer size.
+class InstanceBuffer
+{
+public:
+     InstanceBuffer(ID3D11Device *device, const unsigned stride, const unsigned capacity);
+     ~InstanceBuffer();
+     // Maps buffer for writing of count instances discarding previous content, returns nullptr on failure
+     void *Map(ID3D11DeviceContext *deviceContext, const unsigned count);
+     void Unmap(ID3D11DeviceContext *deviceContext);
+     unsigned GetCapacity() const;
+     ID3D11ShaderResourceView *GetSRV();
+
+private:
+     bool Resize(const unsigned capacity);
+
+     ID3D11Device *device_;
+     const unsigned stride_;
+     unsigned capacity_;
+     ID3D11Buffer *pBuffer_;
+     ID3D11ShaderResourceView *pSRV_;
+};
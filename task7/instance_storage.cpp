@@ -0,0 +1,120 @@
+#include "instance_storage.h"
+
+namespace
+{
+
+     template <typename T>
+     void MoveLast(std::vector<T> &component, const std::size_t index)
+     {
+          component[index] = component.back();
+          component.pop_back();
+     }
+
+}
+
+InstanceStorage::InstanceStorage() :
+     freeHandle_(invalidHandle)
+{
+}
+
+std::uint32_t InstanceStorage::Add(
+     const DirectX::XMFLOAT3 &position,
+     const float rotationSpeed,
+     const float shininess,
+     const std::uint32_t textureId,
+     const bool normalMap)
+{
+     const std::uint32_t index = static_cast<std::uint32_t>(handles_.size());
+     std::uint32_t handle;
+     if (invalidHandle != freeHandle_)
+     {
+          handle = freeHandle_;
+          freeHandle_ = indices_[handle];
+          indices_[handle] = index;
+     }
+     else
+     {
+          handle = static_cast<std::uint32_t>(indices_.size());
+          indices_.push_back(index);
+     }
+
+     positions_[0].push_back(position.x);
+     positions_[1].push_back(position.y);
+     positions_[2].push_back(position.z);
+     rotationSpeeds_.push_back(rotationSpeed);
+     shininess_.push_back(shininess);
+     textureIds_.push_back(textureId);
+     normalMaps_.push_back(normalMap ? 1 : 0);
+     handles_.push_back(handle);
+     return handle;
+}
+
+void InstanceStorage::Remove(const std::uint32_t handle)
+{
+     const std::uint32_t index = indices_[handle];
+     for (auto &position : positions_)
+          MoveLast(position, index);
+     MoveLast(rotationSpeeds_, index);
+     MoveLast(shininess_, index);
+     MoveLast(textureIds_, index);
+     MoveLast(normalMaps_, index);
+     MoveLast(handles_, index);
+     if (index < handles_.size())
+          indices_[handles_[index]] = index;
+
+     indices_[handle] = freeHandle_;
+     freeHandle_ = handle;
+}
+
+void InstanceStorage::Clear()
+{
+     for (auto &position : positions_)
+          position.clear();
+     rotationSpeeds_.clear();
+     shininess_.clear();
+     textureIds_.clear();
+     normalMaps_.clear();
+     handles_.clear();
+     indices_.clear();
+     freeHandle_ = invalidHandle;
+}
+
+std::size_t InstanceStorage::GetSize() const
+{
+     return handles_.size();
+}
+
+std::uint32_t InstanceStorage::GetIndex(const std::uint32_t handle) const
+{
+     return indices_[handle];
+}
+
+std::uint32_t InstanceStorage::GetHandle(const std::size_t index) const
+{
+     return handles_[index];
+}
+
+const float *InstanceStorage::GetPositions(const int axis) const
+{
+     return positions_[axis].data();
+}
+
+const float *InstanceStorage::GetRotationSpeeds() const
+{
+     return rotationSpeeds_.data();
+}
+
+const float *InstanceStorage::GetShininess() const
+{
+     return shininess_.data();
+}
+
+const std::uint32_t *InstanceStorage::GetTextureIds() const
+{
+     return textureIds_.data();
+}
+
+const std::uint8_t *InstanceStorage::GetNormalMaps() const
+{
+     return normalMaps_.data();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <directxmath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Instance state as structure of arrays. Components are densely packed and indexed by position in
+// the arrays, removal moves the last instance into the hole. Handles stay valid until removal.
+class InstanceStorage
+{
+public:
+     static constexpr const std::uint32_t invalidHandle = 0xFFFFFFFF;
+
+     InstanceStorage();
+     std::uint32_t Add(
+          const DirectX::XMFLOAT3 &position,
+          const float rotationSpeed,
+          const float shininess,
+          const std::uint32_t textureId,
+          const bool normalMap);
+     void Remove(const std::uint32_t handle);
+     void Clear();
+     std::size_t GetSize() const;
+     std::uint32_t GetIndex(const std::uint32_t handle) const;
+     std::uint32_t GetHandle(const std::size_t index) const;
+
+     // Component arrays hold GetSize() elements and are invalidated by Add and Remove
+     const float *GetPositions(const int axis) const;
+     const float *GetRotationSpeeds() const;
+     const float *GetShininess() const;
+     const std::uint32_t *GetTextureIds() const;
+     const std::uint8_t *GetNormalMaps() const;
+
+private:
+     std::vector<float> positions_[3];
+     std::vector<float> rotationSpeeds_;
+     std::vector<float> shininess_;
+     std::vector<std::uint32_t> textureIds_;
+     std::vector<std::uint8_t> normalMaps_;
+
+     std::vector<std::uint32_t> handles_; // index to handle
+     std::vector<std::uint32_t> indices_; // handle to index, next free handle for removed one
+     std::uint32_t freeHandle_;
+};
@@ -0,0 +1,176 @@
+#include "instance_transform.h"
+#include "simd_sincos.h"
+
+#include <directxpackedvector.h>
+#include <immintrin.h>
+
+namespace
+{
+
+     // Transposes 4 instances into rows (c, 0, -s, 0), (0, 1, 0, 0), (s, 0, c, 0), (x, y, z, 1)
+     void StoreMatrices4(
+          const __m128 sin,
+          const __m128 cos,
+          __m128 x,
+          __m128 y,
+          __m128 z,
+          char *worldMatrices,
+          const std::size_t stride,
+          const std::size_t count)
+     {
+          const __m128 zero = _mm_setzero_ps();
+          __m128 row0[] = {cos, zero, _mm_sub_ps(zero, sin), zero};
+          _MM_TRANSPOSE4_PS(row0[0], row0[1], row0[2], row0[3]);
+          __m128 row2[] = {sin, zero, cos, zero};
+          _MM_TRANSPOSE4_PS(row2[0], row2[1], row2[2], row2[3]);
+          const __m128 row1 = _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f);
+          __m128 one = _mm_set1_ps(1.0f);
+          _MM_TRANSPOSE4_PS(x, y, z, one);
+          const __m128 row3[] = {x, y, z, one};
+
+          for (std::size_t lane = 0; lane < count; ++lane)
+          {
+               float *world = reinterpret_cast<float *>(worldMatrices + lane * stride);
+               _mm_storeu_ps(world, row0[lane]);
+               _mm_storeu_ps(world + 4, row1);
+               _mm_storeu_ps(world + 8, row2[lane]);
+               _mm_storeu_ps(world + 12, row3[lane]);
+          }
+     }
+
+     // speed * time reduced to [-pi, pi] in double, so SinCos stays accurate however long the session runs.
+     // Adding and subtracting 1.5 * 2^52 rounds to the nearest integer with SSE2 only.
+     __m128 ComputeAngles4(const __m128 speed, const double time)
+     {
+          const __m128d time2 = _mm_set1_pd(time);
+          const __m128d twoPi = _mm_set1_pd(6.283185307179586);
+          const __m128d inverseTwoPi = _mm_set1_pd(0.15915494309189535);
+          const __m128d roundMagic = _mm_set1_pd(6755399441055744.0);
+          __m128d low = _mm_mul_pd(_mm_cvtps_pd(speed), time2);
+          __m128d high = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(speed, speed)), time2);
+          const __m128d lowTurns = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(low, inverseTwoPi), roundMagic), roundMagic);
+          const __m128d highTurns = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(high, inverseTwoPi), roundMagic), roundMagic);
+          low = _mm_sub_pd(low, _mm_mul_pd(lowTurns, twoPi));
+          high = _mm_sub_pd(high, _mm_mul_pd(highTurns, twoPi));
+          return _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high));
+     }
+
+     __m128 Load4(const float *values, const std::uint32_t *indices, const std::size_t first, const std::size_t count)
+     {
+          if (nullptr == indices && 4 == count)
+               return _mm_loadu_ps(values + first);
+          float lanes[4] = {};
+          for (std::size_t lane = 0; lane < count; ++lane)
+               lanes[lane] = values[nullptr == indices ? first + lane : indices[first + lane]];
+          return _mm_loadu_ps(lanes);
+     }
+
+     // Calls store(sin, cos, x, y, z, first, laneNumber) for groups of up to 4 instances
+     template <typename Store>
+     void ComputeSpin(
+          const float *posX,
+          const float *posY,
+          const float *posZ,
+          const float *rotationSpeeds,
+          const double time,
+          const std::uint32_t *indices,
+          const std::size_t count,
+          const Store &store)
+     {
+          std::size_t i = 0;
+
+#if defined(__AVX2__)
+          for (; i + 8 <= count; i += 8)
+          {
+               __m256 x, y, z, speed;
+               if (nullptr == indices)
+               {
+                    x = _mm256_loadu_ps(posX + i);
+                    y = _mm256_loadu_ps(posY + i);
+                    z = _mm256_loadu_ps(posZ + i);
+                    speed = _mm256_loadu_ps(rotationSpeeds + i);
+               }
+               else
+               {
+                    const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices + i));
+                    x = _mm256_i32gather_ps(posX, index, 4);
+                    y = _mm256_i32gather_ps(posY, index, 4);
+                    z = _mm256_i32gather_ps(posZ, index, 4);
+                    speed = _mm256_i32gather_ps(rotationSpeeds, index, 4);
+               }
+               __m256 sin, cos;
+               const __m256 angle = _mm256_set_m128(
+                    ComputeAngles4(_mm256_extractf128_ps(speed, 1), time),
+                    ComputeAngles4(_mm256_castps256_ps128(speed), time));
+               SinCos8(angle, sin, cos);
+
+               store(
+                    _mm256_castps256_ps128(sin),
+                    _mm256_castps256_ps128(cos),
+                    _mm256_castps256_ps128(x),
+                    _mm256_castps256_ps128(y),
+                    _mm256_castps256_ps128(z),
+                    i,
+                    4);
+               store(
+                    _mm256_extractf128_ps(sin, 1),
+                    _mm256_extractf128_ps(cos, 1),
+                    _mm256_extractf128_ps(x, 1),
+                    _mm256_extractf128_ps(y, 1),
+                    _mm256_extractf128_ps(z, 1),
+                    i + 4,
+                    4);
+          }
+#endif
+
+          // Tail shorter than 4 goes through the same path with unused lanes
+          for (; i < count; i += 4)
+          {
+               const std::size_t laneNumber = count - i < 4 ? count - i : 4;
+               __m128 sin, cos;
+               SinCos4(ComputeAngles4(Load4(rotationSpeeds, indices, i, laneNumber), time), sin, cos);
+               store(
+                    sin,
+                    cos,
+                    Load4(posX, indices, i, laneNumber),
+                    Load4(posY, indices, i, laneNumber),
+                    Load4(posZ, indices, i, laneNumber),
+                    i,
+                    laneNumber);
+          }
+     }
+
+}
+
+void ComputeSpinWorldMatrices(
+     const float *posX,
+     const float *posY,
+     const float *posZ,
+     const float *rotationSpeeds,
+     const double time,
+     const std::uint32_t *indices,
+     const std::size_t count,
+     void *worldMatrices,
+     const std::size_t stride)
+{
+     char *world = static_cast<char *>(worldMatrices);
+     ComputeSpin(
+          posX,
+          posY,
+          posZ,
+          rotationSpeeds,
+          time,
+          indices,
+          count,
+          [world, stride](__m128 sin, __m128 cos, __m128 x, __m128 y, __m128 z, std::size_t first, std::size_t laneNumber)
+          {
+               StoreMatrices4(sin, cos, x, y, z, world + first * stride, stride, laneNumber);
+          });
+}
+
+std::uint32_t PackMaterial(const std::uint32_t textureId, const bool normalMap, const float shininess)
+{
+     return (textureId & 0x7FFF) |
+          (normalMap ? 0x8000u : 0u) |
+          (static_cast<std::uint32_t>(DirectX::PackedVector::XMConvertFloatToHalf(shininess)) << 16);
+}
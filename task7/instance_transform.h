@@ -0,0 +1,30 @@
+#pragma once
+
+#include <directxmath.h>
+#include <cstddef>
+#include <cstdint>
+
+// Instance layout of geom_buffer.hlsli, its world matrix is RotationY(rotation speed * time) * Translation(position)
+struct SpinInstance
+{
+     DirectX::XMFLOAT4 placement; // position xyz, rotation speed w
+     std::uint32_t material;
+};
+
+// Writes world matrices RotationY(rotationSpeed * time) * Translation(position) in DirectX::XMMATRIX
+// layout for count instances, 8 (AVX2) or 4 (SSE) at a time with vectorized sine and cosine.
+// Angles are reduced to one turn in double precision, so time may grow without bound.
+// Instance k takes components at indices[k] (or k if indices is null), its matrix goes to
+// worldMatrices + k * stride bytes.
+void ComputeSpinWorldMatrices(
+     const float *posX,
+     const float *posY,
+     const float *posZ,
+     const float *rotationSpeeds,
+     const double time,
+     const std::uint32_t *indices,
+     const std::size_t count,
+     void *worldMatrices,
+     const std::size_t stride);
+// Texture id in bits 0-14, normal map flag in bit 15, shininess as half in bits 16-31
+std::uint32_t PackMaterial(const std::uint32_t textureId, const bool normalMap, const float shininess);
@@ -0,0 +1,217 @@
+#include "light_assigner.h"
+#include "light_falloff.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+     struct RankedLight
+     {
+          float score;
+          std::uint32_t light;
+     };
+
+     // Keeps the strongest lights sorted by descending score, a light reached through several slots is ranked once
+     void RankLight(RankedLight *ranked, unsigned &rankedNumber, const float score, const std::uint32_t light)
+     {
+          if (rankedNumber == LightAssigner::lightsPerInstance && score <= ranked[rankedNumber - 1].score)
+               return;
+          for (unsigned i = 0; i < rankedNumber; ++i)
+               if (ranked[i].light == light)
+                    return;
+
+          unsigned position = std::min(rankedNumber, LightAssigner::lightsPerInstance - 1);
+          while (position > 0 && ranked[position - 1].score < score)
+          {
+               ranked[position] = ranked[position - 1];
+               --position;
+          }
+          ranked[position] = {score, light};
+          rankedNumber = std::min(rankedNumber + 1, LightAssigner::lightsPerInstance);
+     }
+
+}
+
+LightAssigner::LightAssigner() :
+     cellSize_(1.0f),
+     maxInstanceRadius_(0.0f),
+     slotMask_(0)
+{
+}
+
+void LightAssigner::Build(const DirectX::XMFLOAT4 *lights, const DirectX::XMFLOAT4 *colors, const std::size_t lightNumber, const float maxInstanceRadius)
+{
+     const std::size_t number = std::min(lightNumber, maxAssignedLightNumber);
+     maxInstanceRadius_ = maxInstanceRadius;
+     lightX_.resize(number);
+     lightY_.resize(number);
+     lightZ_.resize(number);
+     lightRadius_.resize(number);
+     lightIntensity_.resize(number);
+     float radiusSum = 0.0f;
+     std::size_t activeNumber = 0;
+     for (std::size_t i = 0; i < number; ++i)
+     {
+          lightX_[i] = lights[i].x;
+          lightY_[i] = lights[i].y;
+          lightZ_[i] = lights[i].z;
+          lightRadius_[i] = lights[i].w;
+          lightIntensity_[i] = std::max(std::max(std::abs(colors[i].x), std::abs(colors[i].y)), std::abs(colors[i].z));
+          if (lights[i].w > 0.0f)
+          {
+               radiusSum += lights[i].w + maxInstanceRadius;
+               ++activeNumber;
+          }
+     }
+
+     // Cells of the average reach keep every light within three or four cells per axis
+     cellSize_ = activeNumber > 0 ? radiusSum / activeNumber : 1.0f;
+     std::size_t slotNumber = 64;
+     while (slotNumber < number * 8)
+          slotNumber *= 2;
+     slotMask_ = static_cast<std::uint32_t>(slotNumber - 1);
+
+     intensityOrder_.resize(number);
+     for (std::size_t i = 0; i < number; ++i)
+          intensityOrder_[i] = static_cast<std::uint32_t>(i);
+     std::sort(
+          intensityOrder_.begin(),
+          intensityOrder_.end(),
+          [this](std::uint32_t a, std::uint32_t b) { return lightIntensity_[a] > lightIntensity_[b]; });
+
+     // Counting sort of (slot, light) pairs: count into slot starts, turn them into offsets, fill while moving
+     // every offset to the slot end, then shift offsets back by one slot
+     slotOffsets_.assign(slotNumber + 1, 0);
+     globalLights_.clear();
+     for (const std::uint32_t i : intensityOrder_)
+     {
+          if (lightRadius_[i] <= 0.0f)
+               continue;
+          const float reach = lightRadius_[i] + maxInstanceRadius_;
+          const double cellNumber =
+               (GetCell(lightX_[i] + reach) - GetCell(lightX_[i] - reach) + 1.0) *
+               (GetCell(lightY_[i] + reach) - GetCell(lightY_[i] - reach) + 1.0) *
+               (GetCell(lightZ_[i] + reach) - GetCell(lightZ_[i] - reach) + 1.0);
+          if (cellNumber > slotNumber)
+               globalLights_.push_back(i);
+          else
+               VisitLightSlots(i, [this](std::uint32_t slot) { ++slotOffsets_[slot]; });
+     }
+     std::uint32_t offset = 0;
+     for (std::size_t slot = 0; slot < slotNumber; ++slot)
+     {
+          const std::uint32_t count = slotOffsets_[slot];
+          slotOffsets_[slot] = offset;
+          offset += count;
+     }
+     slotOffsets_[slotNumber] = offset;
+     slotLights_.resize(offset);
+     std::size_t globalIndex = 0;
+     for (const std::uint32_t i : intensityOrder_)
+     {
+          if (lightRadius_[i] <= 0.0f)
+               continue;
+          if (globalIndex < globalLights_.size() && globalLights_[globalIndex] == i)
+          {
+               ++globalIndex;
+               continue;
+          }
+          VisitLightSlots(i, [this, i](std::uint32_t slot) { slotLights_[slotOffsets_[slot]++] = i; });
+     }
+     for (std::size_t slot = slotNumber; slot > 0; --slot)
+          slotOffsets_[slot] = slotOffsets_[slot - 1];
+     slotOffsets_[0] = 0;
+}
+
+PackedLightIndices LightAssigner::Assign(const float x, const float y, const float z, const float radius) const
+{
+     RankedLight ranked[lightsPerInstance];
+     unsigned rankedNumber = 0;
+     // Returns false once the light and all following ones are too weak to be kept
+     const auto rank = [&](std::uint32_t light)
+     {
+          if (rankedNumber == lightsPerInstance && lightIntensity_[light] <= ranked[lightsPerInstance - 1].score)
+               return false;
+          const float dx = lightX_[light] - x;
+          const float dy = lightY_[light] - y;
+          const float dz = lightZ_[light] - z;
+          const float reach = lightRadius_[light] + radius;
+          const float distanceSq = dx * dx + dy * dy + dz * dz;
+          if (distanceSq >= reach * reach)
+               return true;
+          const float distance = std::max(std::sqrt(distanceSq) - radius, 0.0f);
+          const float score = lightIntensity_[light] * ComputeLightAttenuation(distance, lightRadius_[light]);
+          if (score > 0.0f)
+               RankLight(ranked, rankedNumber, score, light);
+          return true;
+     };
+
+     if (0 != slotMask_)
+     {
+          const std::uint32_t slot = GetSlot(GetCell(x), GetCell(y), GetCell(z));
+          for (std::uint32_t i = slotOffsets_[slot]; i < slotOffsets_[slot + 1]; ++i)
+               if (!rank(slotLights_[i]))
+                    break;
+     }
+     for (const std::uint32_t light : globalLights_)
+          if (!rank(light))
+               break;
+
+     std::uint32_t indices[lightsPerInstance];
+     for (unsigned i = 0; i < lightsPerInstance; ++i)
+          indices[i] = i < rankedNumber ? ranked[i].light : noLight;
+     return {{indices[0] | (indices[1] << 16), indices[2] | (indices[3] << 16)}};
+}
+
+void LightAssigner::Assign(
+     const float *x,
+     const float *y,
+     const float *z,
+     const float *radius,
+     const std::uint32_t *indices,
+     const std::size_t count,
+     PackedLightIndices *assigned) const
+{
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          const std::uint32_t index = indices[i];
+          assigned[i] = Assign(x[index], y[index], z[index], radius[index]);
+     }
+}
+
+std::size_t LightAssigner::GetEntryNumber() const
+{
+     return slotLights_.size();
+}
+
+std::uint32_t LightAssigner::GetSlot(const int x, const int y, const int z) const
+{
+     const std::uint32_t hash =
+          static_cast<std::uint32_t>(x) * 73856093u ^
+          static_cast<std::uint32_t>(y) * 19349663u ^
+          static_cast<std::uint32_t>(z) * 83492791u;
+     return hash & slotMask_;
+}
+
+int LightAssigner::GetCell(const float coordinate) const
+{
+     return static_cast<int>(std::floor(coordinate / cellSize_));
+}
+
+template <typename Visitor>
+void LightAssigner::VisitLightSlots(const std::size_t light, const Visitor &visitor) const
+{
+     const float reach = lightRadius_[light] + maxInstanceRadius_;
+     const int minX = GetCell(lightX_[light] - reach);
+     const int maxX = GetCell(lightX_[light] + reach);
+     const int minY = GetCell(lightY_[light] - reach);
+     const int maxY = GetCell(lightY_[light] + reach);
+     const int minZ = GetCell(lightZ_[light] - reach);
+     const int maxZ = GetCell(lightZ_[light] + reach);
+     for (int cz = minZ; cz <= maxZ; ++cz)
+          for (int cy = minY; cy <= maxY; ++cy)
+               for (int cx = minX; cx <= maxX; ++cx)
+                    visitor(GetSlot(cx, cy, cz));
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <directxmath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Light indices of an instance, 16 bits each: light 0 and 1 in the first word, 2 and 3 in the second,
+// strongest light in the low half of the first word. Unused halves are LightAssigner::noLight.
+struct PackedLightIndices
+{
+     std::uint32_t words[2];
+};
+
+// Picks for every instance sphere the lights with the largest attenuated intensity at its closest point.
+// Lights are binned into a hashed uniform grid by their influence spheres grown by the largest instance
+// radius, so an instance only ranks the lights of the cell holding its center. Slots list lights by descending
+// intensity, and attenuation never exceeds one, so ranking stops at the first light weaker than the last kept one.
+class LightAssigner
+{
+public:
+     static constexpr const unsigned lightsPerInstance = 4;
+     static constexpr const std::uint32_t noLight = 0xFFFF;
+     // Lights beyond this index are not assigned
+     static constexpr const std::size_t maxAssignedLightNumber = noLight;
+
+     LightAssigner();
+     // Lights are spheres (xyz position, w influence radius), intensity is the largest magnitude of color xyz
+     void Build(const DirectX::XMFLOAT4 *lights, const DirectX::XMFLOAT4 *colors, const std::size_t lightNumber, const float maxInstanceRadius);
+     PackedLightIndices Assign(const float x, const float y, const float z, const float radius) const;
+     // Assigns lights to spheres taken at indices of structure-of-arrays components
+     void Assign(
+          const float *x,
+          const float *y,
+          const float *z,
+          const float *radius,
+          const std::uint32_t *indices,
+          const std::size_t count,
+          PackedLightIndices *assigned) const;
+     std::size_t GetEntryNumber() const;
+
+private:
+     std::uint32_t GetSlot(const int x, const int y, const int z) const;
+     int GetCell(const float coordinate) const;
+     template <typename Visitor>
+     void VisitLightSlots(const std::size_t light, const Visitor &visitor) const;
+
+     float cellSize_;
+     float maxInstanceRadius_;
+     std::uint32_t slotMask_;
+     std::vector<float> lightX_;
+     std::vector<float> lightY_;
+     std::vector<float> lightZ_;
+     std::vector<float> lightRadius_;
+     std::vector<float> lightIntensity_;
+     std::vector<std::uint32_t> intensityOrder_;
+     // Lights of a slot are slotLights_[slotOffsets_[slot], slotOffsets_[slot + 1])
+     std::vector<std::uint32_t> slotOffsets_;
+     std::vector<std::uint32_t> slotLights_;
+     // Lights covering more cells than there are slots, ranked for every instance
+     std::vector<std::uint32_t> globalLights_;
+};
@@ -1,10 +1,28 @@
-#include "defines.hlsli"
-
 cbuffer LightBuffer : register (b2)
 {
      float4 cameraPos;
-     int4 lightCount;  // x - count, y - use normals, z - show normals
-     float4 lightPos[MAX_LIGHTS];
-     float4 lightColor[MAX_LIGHTS];
+     int4 lightCount;  // x - count, y - use normals, z - show normals, w - cubes use instance lights
+     float4 viewDepth; // third column of view matrix, view space depth is dot(float4(pos, 1), viewDepth)
+     uint4 clusterSize; // x, y - tile number, z - slice number
+     float4 clusterScale; // x, y - tiles per pixel, z - slice scale, w - slice bias
      float4 ambientColor;
 };
+
+struct Light
+{
+     float4 position; // w - influence radius
+     float4 color;
+};
+
+StructuredBuffer<Light> lights : register(t5);
+StructuredBuffer<uint2> clusterRanges : register(t6); // offset and count in clusterLightIndices
+StructuredBuffer<uint> clusterLightIndices : register(t7);
+
+// Light index range of the froxel containing the pixel
+uint2 GetClusterRange(in float2 screenPos, in float3 pos)
+{
+     float depth = dot(float4(pos, 1.0), viewDepth);
+     uint2 tile = min(uint2(screenPos * clusterScale.xy), clusterSize.xy - 1);
+     uint slice = uint(clamp(floor(log(depth) * clusterScale.z + clusterScale.w), 0.0, float(clusterSize.z - 1)));
+     return clusterRanges[(slice * clusterSize.y + tile.y) * clusterSize.x + tile.x];
+}
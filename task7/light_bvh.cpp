@@ -0,0 +1,357 @@
+#include "light_bvh.h"
+#include "light_falloff.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+     float GetIntensity(const DirectX::XMFLOAT4 &color)
+     {
+          return std::max(std::max(std::abs(color.x), std::abs(color.y)), std::abs(color.z));
+     }
+
+     float BoxDistanceSq(const float *min, const float *max, const float x, const float y, const float z)
+     {
+          const float dx = std::max(std::max(min[0] - x, x - max[0]), 0.0f);
+          const float dy = std::max(std::max(min[1] - y, y - max[1]), 0.0f);
+          const float dz = std::max(std::max(min[2] - z, z - max[2]), 0.0f);
+          return dx * dx + dy * dy + dz * dz;
+     }
+
+     bool ContainsPoint(const float *min, const float *max, const float x, const float y, const float z)
+     {
+          return x >= min[0] && x <= max[0] && y >= min[1] && y <= max[1] && z >= min[2] && z <= max[2];
+     }
+
+}
+
+void LightBvh::Build(const DirectX::XMFLOAT4 *lights, const DirectX::XMFLOAT4 *colors, const std::size_t count)
+{
+     nodes_.clear();
+     indices_.resize(count);
+     spheres_.assign(lights, lights + count);
+     intensities_.resize(count);
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          indices_[i] = static_cast<std::uint32_t>(i);
+          intensities_[i] = GetIntensity(colors[i]);
+     }
+     if (0 == count)
+          return;
+
+     // Binary tree over count leaves never has more than 2 * count - 1 nodes, so nodes_ is not reallocated while building
+     nodes_.reserve(2 * count);
+     nodes_.emplace_back();
+     nodes_[0].first = 0;
+     nodes_[0].count = static_cast<std::uint32_t>(count);
+     BuildNode(0, 0);
+
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          spheres_[i] = lights[indices_[i]];
+          intensities_[i] = GetIntensity(colors[indices_[i]]);
+     }
+}
+
+void LightBvh::BuildNode(const std::uint32_t nodeIndex, const std::size_t depth)
+{
+     Node &node = nodes_[nodeIndex];
+     const std::uint32_t first = node.first;
+     const std::uint32_t count = node.count;
+
+     // Light data is still in source order while building
+     for (int axis = 0; axis < 3; ++axis)
+     {
+          node.min[axis] = node.centerMin[axis] = std::numeric_limits<float>::max();
+          node.max[axis] = node.centerMax[axis] = std::numeric_limits<float>::lowest();
+     }
+     node.intensity = 0.0f;
+     for (std::uint32_t i = first; i < first + count; ++i)
+     {
+          const DirectX::XMFLOAT4 &sphere = spheres_[indices_[i]];
+          const float center[] = {sphere.x, sphere.y, sphere.z};
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               node.min[axis] = std::min(node.min[axis], center[axis] - sphere.w);
+               node.max[axis] = std::max(node.max[axis], center[axis] + sphere.w);
+               node.centerMin[axis] = std::min(node.centerMin[axis], center[axis]);
+               node.centerMax[axis] = std::max(node.centerMax[axis], center[axis]);
+          }
+          node.intensity += intensities_[indices_[i]];
+     }
+     if (count <= maxLeafSize_ || depth >= maxDepth_)
+          return;
+
+     int axis = 0;
+     for (int i = 1; i < 3; ++i)
+          if (node.centerMax[i] - node.centerMin[i] > node.centerMax[axis] - node.centerMin[axis])
+               axis = i;
+     const std::uint32_t leftCount = count / 2;
+     std::nth_element(
+          indices_.begin() + first,
+          indices_.begin() + first + leftCount,
+          indices_.begin() + first + count,
+          [this, axis](std::uint32_t a, std::uint32_t b) { return (&spheres_[a].x)[axis] < (&spheres_[b].x)[axis]; });
+
+     const std::uint32_t leftIndex = static_cast<std::uint32_t>(nodes_.size());
+     nodes_.emplace_back();
+     nodes_.emplace_back();
+     nodes_[leftIndex].first = first;
+     nodes_[leftIndex].count = leftCount;
+     nodes_[leftIndex + 1].first = first + leftCount;
+     nodes_[leftIndex + 1].count = count - leftCount;
+     node.first = leftIndex;
+     node.count = 0;
+
+     BuildNode(leftIndex, depth + 1);
+     BuildNode(leftIndex + 1, depth + 1);
+}
+
+void LightBvh::UpdateLeaf(Node &node) const
+{
+     for (int axis = 0; axis < 3; ++axis)
+     {
+          node.min[axis] = node.centerMin[axis] = std::numeric_limits<float>::max();
+          node.max[axis] = node.centerMax[axis] = std::numeric_limits<float>::lowest();
+     }
+     node.intensity = 0.0f;
+     for (std::uint32_t i = node.first; i < node.first + node.count; ++i)
+     {
+          const DirectX::XMFLOAT4 &sphere = spheres_[i];
+          const float center[] = {sphere.x, sphere.y, sphere.z};
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               node.min[axis] = std::min(node.min[axis], center[axis] - sphere.w);
+               node.max[axis] = std::max(node.max[axis], center[axis] + sphere.w);
+               node.centerMin[axis] = std::min(node.centerMin[axis], center[axis]);
+               node.centerMax[axis] = std::max(node.centerMax[axis], center[axis]);
+          }
+          node.intensity += intensities_[i];
+     }
+}
+
+void LightBvh::Refit(const DirectX::XMFLOAT4 *lights, const DirectX::XMFLOAT4 *colors)
+{
+     for (std::size_t i = 0; i < indices_.size(); ++i)
+     {
+          spheres_[i] = lights[indices_[i]];
+          intensities_[i] = GetIntensity(colors[indices_[i]]);
+     }
+
+     // Children are always stored after their parent
+     for (std::size_t i = nodes_.size(); i-- > 0;)
+     {
+          Node &node = nodes_[i];
+          if (node.count > 0)
+          {
+               UpdateLeaf(node);
+               continue;
+          }
+
+          const Node &left = nodes_[node.first];
+          const Node &right = nodes_[node.first + 1];
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               node.min[axis] = std::min(left.min[axis], right.min[axis]);
+               node.max[axis] = std::max(left.max[axis], right.max[axis]);
+               node.centerMin[axis] = std::min(left.centerMin[axis], right.centerMin[axis]);
+               node.centerMax[axis] = std::max(left.centerMax[axis], right.centerMax[axis]);
+          }
+          node.intensity = left.intensity + right.intensity;
+     }
+}
+
+std::size_t LightBvh::GetSize() const
+{
+     return indices_.size();
+}
+
+template <typename NodeTest, typename LightTest>
+std::size_t LightBvh::Query(const NodeTest &nodeTest, const LightTest &lightTest, std::uint32_t *lights) const
+{
+     if (nodes_.empty())
+          return 0;
+
+     // Depth first order keeps at most one pending sibling per level
+     std::uint32_t stack[maxDepth_ + 2];
+     std::size_t stackSize = 0;
+     stack[stackSize++] = 0;
+
+     std::size_t lightNumber = 0;
+     while (stackSize > 0)
+     {
+          const Node &node = nodes_[stack[--stackSize]];
+          if (!nodeTest(node))
+               continue;
+
+          if (0 == node.count)
+          {
+               stack[stackSize++] = node.first + 1;
+               stack[stackSize++] = node.first;
+               continue;
+          }
+
+          for (std::uint32_t i = node.first; i < node.first + node.count; ++i)
+          {
+               lights[lightNumber] = indices_[i];
+               lightNumber += spheres_[i].w > 0.0f && lightTest(spheres_[i]);
+          }
+     }
+     return lightNumber;
+}
+
+std::size_t LightBvh::QueryBox(const float *min, const float *max, std::uint32_t *lights) const
+{
+     return Query(
+          [min, max](const Node &node)
+          {
+               return node.min[0] <= max[0] && node.max[0] >= min[0] &&
+                    node.min[1] <= max[1] && node.max[1] >= min[1] &&
+                    node.min[2] <= max[2] && node.max[2] >= min[2];
+          },
+          [min, max](const DirectX::XMFLOAT4 &sphere) { return BoxDistanceSq(min, max, sphere.x, sphere.y, sphere.z) <= sphere.w * sphere.w; },
+          lights);
+}
+
+std::size_t LightBvh::QueryPoint(const float x, const float y, const float z, std::uint32_t *lights) const
+{
+     return Query(
+          [x, y, z](const Node &node) { return ContainsPoint(node.min, node.max, x, y, z); },
+          [x, y, z](const DirectX::XMFLOAT4 &sphere)
+          {
+               const float dx = sphere.x - x;
+               const float dy = sphere.y - y;
+               const float dz = sphere.z - z;
+               return dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w;
+          },
+          lights);
+}
+
+std::size_t LightBvh::QueryFrustum(const Frustum &frustum, std::uint32_t *lights) const
+{
+     if (nodes_.empty())
+          return 0;
+
+     struct StackEntry
+     {
+          std::uint32_t node;
+          unsigned planeMask;
+     };
+     StackEntry stack[maxDepth_ + 2];
+     std::size_t stackSize = 0;
+     stack[stackSize++] = {0, Frustum::allPlanesMask};
+
+     std::size_t lightNumber = 0;
+     while (stackSize > 0)
+     {
+          const StackEntry entry = stack[--stackSize];
+          const Node &node = nodes_[entry.node];
+          unsigned planeMask = entry.planeMask;
+          if (!frustum.CheckRectangleMasked(node.min, node.max, planeMask))
+               continue;
+
+          if (0 == node.count)
+          {
+               stack[stackSize++] = {node.first + 1, planeMask};
+               stack[stackSize++] = {node.first, planeMask};
+               continue;
+          }
+
+          // Spheres of a box fully inside are inside too
+          for (std::uint32_t i = node.first; i < node.first + node.count; ++i)
+          {
+               const DirectX::XMFLOAT4 &sphere = spheres_[i];
+               lights[lightNumber] = indices_[i];
+               lightNumber += sphere.w > 0.0f &&
+                    (0 == planeMask || frustum.CheckSphere(DirectX::XMFLOAT3(sphere.x, sphere.y, sphere.z), sphere.w));
+          }
+     }
+     return lightNumber;
+}
+
+std::size_t LightBvh::GetNodeNumber() const
+{
+     return nodes_.size();
+}
+
+float LightBvh::GetNodeIntensity(const std::uint32_t node) const
+{
+     return nodes_[node].intensity;
+}
+
+float LightBvh::EstimateImportance(const std::uint32_t nodeIndex, const float x, const float y, const float z) const
+{
+     const Node &node = nodes_[nodeIndex];
+     if (!ContainsPoint(node.min, node.max, x, y, z))
+          return 0.0f;
+     const float distanceSq = BoxDistanceSq(node.centerMin, node.centerMax, x, y, z);
+     return node.intensity * (distanceSq > 1.0f ? 1.0f / distanceSq : 1.0f);
+}
+
+float LightBvh::GetLightImportance(const std::uint32_t slot, const float x, const float y, const float z) const
+{
+     const DirectX::XMFLOAT4 &sphere = spheres_[slot];
+     const float dx = sphere.x - x;
+     const float dy = sphere.y - y;
+     const float dz = sphere.z - z;
+     return intensities_[slot] * ComputeLightAttenuation(std::sqrt(dx * dx + dy * dy + dz * dz), sphere.w);
+}
+
+std::uint32_t LightBvh::SampleLight(const float x, const float y, const float z, float u, float &probability) const
+{
+     probability = 0.0f;
+     if (nodes_.empty() || EstimateImportance(0, x, y, z) <= 0.0f)
+          return invalidLight;
+
+     // Every light reaching the point has all its ancestors' boxes around the point, so it can be picked
+     const float maxU = std::nextafter(1.0f, 0.0f);
+     float pathProbability = 1.0f;
+     std::uint32_t nodeIndex = 0;
+     while (0 == nodes_[nodeIndex].count)
+     {
+          const std::uint32_t left = nodes_[nodeIndex].first;
+          const float leftImportance = EstimateImportance(left, x, y, z);
+          const float rightImportance = EstimateImportance(left + 1, x, y, z);
+          const float total = leftImportance + rightImportance;
+          if (total <= 0.0f)
+               return invalidLight;
+          const float leftProbability = leftImportance / total;
+          if (u < leftProbability)
+          {
+               u = std::min(u / leftProbability, maxU);
+               pathProbability *= leftProbability;
+               nodeIndex = left;
+          }
+          else
+          {
+               u = std::min((u - leftProbability) / (1.0f - leftProbability), maxU);
+               pathProbability *= 1.0f - leftProbability;
+               nodeIndex = left + 1;
+          }
+     }
+
+     const Node &leaf = nodes_[nodeIndex];
+     float total = 0.0f;
+     for (std::uint32_t i = leaf.first; i < leaf.first + leaf.count; ++i)
+          total += GetLightImportance(i, x, y, z);
+     if (total <= 0.0f)
+          return invalidLight;
+
+     float threshold = u * total;
+     std::uint32_t picked = leaf.first;
+     for (std::uint32_t i = leaf.first; i < leaf.first + leaf.count; ++i)
+     {
+          const float importance = GetLightImportance(i, x, y, z);
+          if (importance <= 0.0f)
+               continue;
+          picked = i;
+          if (threshold < importance)
+               break;
+          threshold -= importance;
+     }
+     probability = pathProbability * GetLightImportance(picked, x, y, z) / total;
+     return indices_[picked];
+}
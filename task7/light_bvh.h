@@ -0,0 +1,64 @@
+#pragma once
+
+#include "frustum.h"
+
+#include <directxmath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounding volume hierarchy over light influence spheres (xyz position, w radius). Nodes keep the box of the
+// spheres, the box of the light positions and the summed intensity (largest magnitude of color xyz), which give
+// an importance estimate of the subtree at a point. Built by median splits, refitted in place for animated lights.
+class LightBvh
+{
+public:
+     static constexpr const std::uint32_t invalidLight = 0xFFFFFFFF;
+
+     void Build(const DirectX::XMFLOAT4 *lights, const DirectX::XMFLOAT4 *colors, const std::size_t count);
+     // Same lights at new positions, radii and colors, topology is kept
+     void Refit(const DirectX::XMFLOAT4 *lights, const DirectX::XMFLOAT4 *colors);
+     std::size_t GetSize() const;
+
+     // Queries write indices of lights whose sphere touches the volume in tree order to lights
+     // (must hold GetSize() elements) and return their number
+     std::size_t QueryBox(const float *min, const float *max, std::uint32_t *lights) const;
+     std::size_t QueryPoint(const float x, const float y, const float z, std::uint32_t *lights) const;
+     std::size_t QueryFrustum(const Frustum &frustum, std::uint32_t *lights) const;
+
+     std::size_t GetNodeNumber() const;
+     float GetNodeIntensity(const std::uint32_t node) const;
+     // Upper estimate of light the subtree sends to the point: intensity * min(1, 1 / d^2) with d the distance
+     // to the light position box, 0 when the point is outside of all spheres' box
+     float EstimateImportance(const std::uint32_t node, const float x, const float y, const float z) const;
+     // Picks a light reaching the point with probability following node importance, u is uniform in [0, 1).
+     // Returns invalidLight when nothing reaches the point.
+     std::uint32_t SampleLight(const float x, const float y, const float z, float u, float &probability) const;
+
+private:
+     static constexpr const std::size_t maxLeafSize_ = 4;
+     static constexpr const std::size_t maxDepth_ = 63;
+
+     struct Node
+     {
+          float min[3];
+          float max[3];
+          float centerMin[3];
+          float centerMax[3];
+          float intensity;
+          std::uint32_t first; // first light for leaf, left child for inner node (right one is next)
+          std::uint32_t count; // 0 for inner node
+     };
+
+     void BuildNode(const std::uint32_t nodeIndex, const std::size_t depth);
+     void UpdateLeaf(Node &node) const;
+     float GetLightImportance(const std::uint32_t slot, const float x, const float y, const float z) const;
+     template <typename NodeTest, typename LightTest>
+     std::size_t Query(const NodeTest &nodeTest, const LightTest &lightTest, std::uint32_t *lights) const;
+
+     std::vector<Node> nodes_;
+     std::vector<std::uint32_t> indices_;
+     // Light data reordered by indices_
+     std::vector<DirectX::XMFLOAT4> spheres_;
+     std::vector<float> intensities_;
+};
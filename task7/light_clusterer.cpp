@@ -0,0 +1,189 @@
+#include "light_clusterer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+LightClusterer::LightClusterer(
+     const unsigned tileNumberX,
+     const unsigned tileNumberY,
+     const unsigned sliceNumber,
+     const float nearZ,
+     const float farZ) :
+     tileNumberX_(tileNumberX),
+     tileNumberY_(tileNumberY),
+     sliceNumber_(sliceNumber),
+     near_(nearZ),
+     far_(farZ),
+     tanHalfX_(1.0f),
+     tanHalfY_(1.0f),
+     slices_(sliceNumber)
+{
+}
+
+void LightClusterer::Build(
+     const DirectX::XMFLOAT4X4 &view,
+     const float fovY,
+     const float aspect,
+     const DirectX::XMFLOAT4 *lights,
+     const std::size_t lightNumber,
+     ThreadPool &threadPool,
+     std::vector<ClusterRange> &ranges,
+     std::vector<std::uint32_t> &indices)
+{
+     tanHalfY_ = std::tan(fovY * 0.5f);
+     tanHalfX_ = tanHalfY_ * aspect;
+
+     viewX_.resize(lightNumber);
+     viewY_.resize(lightNumber);
+     viewZ_.resize(lightNumber);
+     radius_.resize(lightNumber);
+     for (std::size_t i = 0; i < lightNumber; ++i)
+     {
+          const DirectX::XMFLOAT4 &light = lights[i];
+          viewX_[i] = light.x * view._11 + light.y * view._21 + light.z * view._31 + view._41;
+          viewY_[i] = light.x * view._12 + light.y * view._22 + light.z * view._32 + view._42;
+          viewZ_[i] = light.x * view._13 + light.y * view._23 + light.z * view._33 + view._43;
+          radius_[i] = light.w;
+     }
+
+     threadPool.Run(sliceNumber_, [this](std::size_t slice) { BuildSlice(static_cast<unsigned>(slice)); });
+
+     // Slices are concatenated in order, so the result does not depend on scheduling
+     const std::size_t tileNumber = static_cast<std::size_t>(tileNumberX_) * tileNumberY_;
+     ranges.resize(GetClusterNumber());
+     indices.clear();
+     for (unsigned s = 0; s < sliceNumber_; ++s)
+     {
+          const Slice &slice = slices_[s];
+          const std::uint32_t base = static_cast<std::uint32_t>(indices.size());
+          for (std::size_t tile = 0; tile < tileNumber; ++tile)
+               ranges[s * tileNumber + tile] = {base + slice.ranges[tile].offset, slice.ranges[tile].count};
+          indices.insert(indices.end(), slice.indices.begin(), slice.indices.end());
+     }
+}
+
+void LightClusterer::BuildSlice(const unsigned sliceIndex)
+{
+     Slice &slice = slices_[sliceIndex];
+     const float sliceNear = GetSliceNear(sliceIndex);
+     const float sliceFar = GetSliceNear(sliceIndex + 1);
+
+     slice.x.clear();
+     slice.y.clear();
+     slice.z.clear();
+     slice.radiusSq.clear();
+     slice.lights.clear();
+     for (std::size_t i = 0; i < viewZ_.size(); ++i)
+     {
+          if (viewZ_[i] + radius_[i] < sliceNear || viewZ_[i] - radius_[i] > sliceFar)
+               continue;
+          slice.x.push_back(viewX_[i]);
+          slice.y.push_back(viewY_[i]);
+          slice.z.push_back(viewZ_[i]);
+          slice.radiusSq.push_back(radius_[i] * radius_[i]);
+          slice.lights.push_back(static_cast<std::uint32_t>(i));
+     }
+     // Negative squared radius never passes the distance test
+     while (0 != slice.x.size() % 4)
+     {
+          slice.x.push_back(0.0f);
+          slice.y.push_back(0.0f);
+          slice.z.push_back(0.0f);
+          slice.radiusSq.push_back(-1.0f);
+          slice.lights.push_back(0);
+     }
+
+     const std::size_t candidateNumber = slice.x.size();
+     slice.ranges.resize(static_cast<std::size_t>(tileNumberX_) * tileNumberY_);
+     slice.indices.clear();
+     for (unsigned tileY = 0; tileY < tileNumberY_; ++tileY)
+          for (unsigned tileX = 0; tileX < tileNumberX_; ++tileX)
+          {
+               float min[3];
+               float max[3];
+               GetClusterBox(tileX, tileY, sliceIndex, min, max);
+               const __m128 minX = _mm_set1_ps(min[0]);
+               const __m128 minY = _mm_set1_ps(min[1]);
+               const __m128 minZ = _mm_set1_ps(min[2]);
+               const __m128 maxX = _mm_set1_ps(max[0]);
+               const __m128 maxY = _mm_set1_ps(max[1]);
+               const __m128 maxZ = _mm_set1_ps(max[2]);
+               const __m128 zero = _mm_setzero_ps();
+
+               ClusterRange &range = slice.ranges[tileY * tileNumberX_ + tileX];
+               range.offset = static_cast<std::uint32_t>(slice.indices.size());
+               for (std::size_t i = 0; i < candidateNumber; i += 4)
+               {
+                    // Squared distance from sphere center to the box
+                    const __m128 x = _mm_loadu_ps(slice.x.data() + i);
+                    const __m128 y = _mm_loadu_ps(slice.y.data() + i);
+                    const __m128 z = _mm_loadu_ps(slice.z.data() + i);
+                    const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, x), _mm_sub_ps(x, maxX)), zero);
+                    const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, y), _mm_sub_ps(y, maxY)), zero);
+                    const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, z), _mm_sub_ps(z, maxZ)), zero);
+                    const __m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                    int mask = _mm_movemask_ps(_mm_cmple_ps(distanceSq, _mm_loadu_ps(slice.radiusSq.data() + i)));
+                    for (int lane = 0; 0 != mask; ++lane, mask >>= 1)
+                         if (0 != (mask & 1))
+                              slice.indices.push_back(slice.lights[i + lane]);
+               }
+               range.count = static_cast<std::uint32_t>(slice.indices.size()) - range.offset;
+          }
+}
+
+unsigned LightClusterer::GetTileNumberX() const
+{
+     return tileNumberX_;
+}
+
+unsigned LightClusterer::GetTileNumberY() const
+{
+     return tileNumberY_;
+}
+
+unsigned LightClusterer::GetSliceNumber() const
+{
+     return sliceNumber_;
+}
+
+std::size_t LightClusterer::GetClusterNumber() const
+{
+     return static_cast<std::size_t>(tileNumberX_) * tileNumberY_ * sliceNumber_;
+}
+
+float LightClusterer::GetSliceScale() const
+{
+     return sliceNumber_ / std::log(far_ / near_);
+}
+
+float LightClusterer::GetSliceBias() const
+{
+     return -std::log(near_) * GetSliceScale();
+}
+
+float LightClusterer::GetSliceNear(const unsigned slice) const
+{
+     if (slice >= sliceNumber_)
+          return far_;
+     return near_ * std::pow(far_ / near_, static_cast<float>(slice) / sliceNumber_);
+}
+
+void LightClusterer::GetClusterBox(const unsigned tileX, const unsigned tileY, const unsigned slice, float *min, float *max) const
+{
+     const float sliceNear = GetSliceNear(slice);
+     const float sliceFar = GetSliceNear(slice + 1);
+
+     // Tile edges in NDC, the box covers the frustum piece between both slice depths
+     const float left = -1.0f + 2.0f * tileX / tileNumberX_;
+     const float right = -1.0f + 2.0f * (tileX + 1) / tileNumberX_;
+     const float top = 1.0f - 2.0f * tileY / tileNumberY_;
+     const float bottom = 1.0f - 2.0f * (tileY + 1) / tileNumberY_;
+
+     min[0] = std::min(left * sliceNear, left * sliceFar) * tanHalfX_;
+     max[0] = std::max(right * sliceNear, right * sliceFar) * tanHalfX_;
+     min[1] = std::min(bottom * sliceNear, bottom * sliceFar) * tanHalfY_;
+     max[1] = std::max(top * sliceNear, top * sliceFar) * tanHalfY_;
+     min[2] = sliceNear;
+     max[2] = sliceFar;
+}
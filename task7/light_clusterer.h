@@ -0,0 +1,80 @@
+#pragma once
+
+#include "thread_pool.h"
+
+#include <directxmath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Range of a cluster in the light index list
+struct ClusterRange
+{
+     std::uint32_t offset;
+     std::uint32_t count;
+};
+
+// Clustered light assignment. View space is split into a froxel grid of screen tiles and exponential depth
+// slices, every light sphere is binned into all clusters whose bounding box it touches. Cluster index is
+// (slice * tileNumberY + tileY) * tileNumberX + tileX, tile y grows down the screen.
+class LightClusterer
+{
+public:
+     LightClusterer(
+          const unsigned tileNumberX,
+          const unsigned tileNumberY,
+          const unsigned sliceNumber,
+          const float nearZ,
+          const float farZ);
+     // Lights are world space spheres (center xyz, radius w). Slices run on the pool, results are written to
+     // ranges (one per cluster) and indices (light indices of all clusters, back to back).
+     void Build(
+          const DirectX::XMFLOAT4X4 &view,
+          const float fovY,
+          const float aspect,
+          const DirectX::XMFLOAT4 *lights,
+          const std::size_t lightNumber,
+          ThreadPool &threadPool,
+          std::vector<ClusterRange> &ranges,
+          std::vector<std::uint32_t> &indices);
+
+     unsigned GetTileNumberX() const;
+     unsigned GetTileNumberY() const;
+     unsigned GetSliceNumber() const;
+     std::size_t GetClusterNumber() const;
+     // slice = floor(log(viewZ) * scale + bias)
+     float GetSliceScale() const;
+     float GetSliceBias() const;
+     float GetSliceNear(const unsigned slice) const;
+     // View space bounding box of a cluster, min and max are xyz
+     void GetClusterBox(const unsigned tileX, const unsigned tileY, const unsigned slice, float *min, float *max) const;
+
+private:
+     // Light spheres in view space overlapping a slice in depth, padded to a multiple of 4 with empty spheres
+     struct Slice
+     {
+          std::vector<float> x;
+          std::vector<float> y;
+          std::vector<float> z;
+          std::vector<float> radiusSq;
+          std::vector<std::uint32_t> lights;
+          std::vector<ClusterRange> ranges;
+          std::vector<std::uint32_t> indices;
+     };
+
+     void BuildSlice(const unsigned slice);
+
+     const unsigned tileNumberX_;
+     const unsigned tileNumberY_;
+     const unsigned sliceNumber_;
+     const float near_;
+     const float far_;
+     float tanHalfX_;
+     float tanHalfY_;
+
+     std::vector<float> viewX_;
+     std::vector<float> viewY_;
+     std::vector<float> viewZ_;
+     std::vector<float> radius_;
+     std::vector<Slice> slices_;
+};
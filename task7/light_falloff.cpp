@@ -0,0 +1,27 @@
+#include "light_falloff.h"
+
+#include <algorithm>
+#include <cmath>
+
+float ComputeLightRadius(const float intensity, const float cutoff)
+{
+     if (intensity <= 0.0f || cutoff <= 0.0f)
+          return 0.0f;
+     return std::sqrt(intensity / cutoff);
+}
+
+float ComputeLightWindow(const float distance, const float radius)
+{
+     if (radius <= 0.0f)
+          return 0.0f;
+     const float ratio = distance / radius;
+     const float ratioSq = ratio * ratio;
+     const float window = std::min(std::max(1.0f - ratioSq * ratioSq, 0.0f), 1.0f);
+     return window * window;
+}
+
+float ComputeLightAttenuation(const float distance, const float radius)
+{
+     const float inverseSquare = std::min(1.0f / (distance * distance), 1.0f);
+     return inverseSquare * ComputeLightWindow(distance, radius);
+}
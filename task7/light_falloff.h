@@ -0,0 +1,9 @@
+#pragma once
+
+// CPU side of the light falloff in calculate_light.hlsli. Attenuation is min(1, 1 / d^2) multiplied by the window
+// (1 - (d / radius)^4)^2 clamped to [0, 1], which reaches zero smoothly at the influence radius.
+
+// Distance where intensity / d^2 drops to cutoff, 0 for lights without intensity
+float ComputeLightRadius(const float intensity, const float cutoff);
+float ComputeLightWindow(const float distance, const float radius);
+float ComputeLightAttenuation(const float distance, const float radius);
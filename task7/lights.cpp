@@ -1,37 +1,159 @@
 #include "lights.h"
+#include "light_falloff.h"
+#include "simd_sincos.h"
+
 #include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+namespace
+{
+
+     constexpr const double twoPi = 6.283185307179586;
 
-bool Lights::Add(const LightInfo &info)
+}
+
+Lights::Lights(const std::size_t capacity, const float cutoff) :
+     capacity_(capacity),
+     cutoff_(cutoff)
 {
-     if (lights.size() >= maxLightNumber)
+}
+
+std::uint32_t Lights::Add(const DirectX::XMFLOAT4 &position, const DirectX::XMFLOAT4 &color)
+{
+     if (basePositions_.size() >= capacity_)
+          return invalidLight;
+     basePositions_.push_back(position);
+     baseColors_.push_back(color);
+     return static_cast<std::uint32_t>(basePositions_.size() - 1);
+}
+
+bool Lights::AddSinusoid(const std::uint32_t light, const Channel channel, const float amplitude, const float frequency, const float phase)
+{
+     if (light >= basePositions_.size())
           return false;
-     lights.push_back(info);
+     sinTargets_.push_back(GetTarget(light, channel));
+     sinAmplitudes_.push_back(amplitude);
+     sinFrequencies_.push_back(frequency);
+     sinPhases_.push_back(phase);
+     sinValues_.push_back(0.0f);
      return true;
 }
 
-std::size_t Lights::GetNumber()
+bool Lights::AddOrbit(const std::uint32_t light, const float radius, const float frequency, const float phase)
+{
+     // cos(x) is evaluated as sin(x + pi / 2) so the whole pass stays a single function
+     return AddSinusoid(light, Channel::PositionX, radius, frequency, phase) &&
+          AddSinusoid(light, Channel::PositionZ, radius, frequency, phase + DirectX::XM_PIDIV2);
+}
+
+bool Lights::AddKeyframes(
+     const std::uint32_t light,
+     const Channel channel,
+     const float *times,
+     const float *values,
+     const std::size_t keyNumber,
+     const float period)
 {
-     return lights.size();
+     if (light >= basePositions_.size() || 0 == keyNumber || period < 0.0f)
+          return false;
+     if (!std::is_sorted(times, times + keyNumber))
+          return false;
+     curveTargets_.push_back(GetTarget(light, channel));
+     curveFirstKeys_.push_back(static_cast<std::uint32_t>(keyTimes_.size()));
+     curveKeyNumbers_.push_back(static_cast<std::uint32_t>(keyNumber));
+     curvePeriods_.push_back(period);
+     keyTimes_.insert(keyTimes_.end(), times, times + keyNumber);
+     keyValues_.insert(keyValues_.end(), values, values + keyNumber);
+     return true;
+}
+
+std::size_t Lights::GetNumber() const
+{
+     return basePositions_.size();
+}
+
+void Lights::Evaluate(const double seconds, DirectX::XMFLOAT4 *positions, DirectX::XMFLOAT4 *colors)
+{
+     std::copy(basePositions_.begin(), basePositions_.end(), positions);
+     std::copy(baseColors_.begin(), baseColors_.end(), colors);
+
+     // Arguments are formed and reduced to one period in double so long sessions keep precision,
+     // then sines are evaluated by the SIMD polynomial shared with instance transforms
+     const std::size_t sinNumber = sinTargets_.size();
+     const float *frequencies = sinFrequencies_.data();
+     const float *phases = sinPhases_.data();
+     const float *amplitudes = sinAmplitudes_.data();
+     float *sinValues = sinValues_.data();
+     for (std::size_t i = 0; i < sinNumber; ++i)
+          sinValues[i] = static_cast<float>(std::fmod(frequencies[i] * seconds + phases[i], twoPi));
+
+     std::size_t i = 0;
+#if defined(__AVX2__)
+     for (; i + 8 <= sinNumber; i += 8)
+     {
+          __m256 sin, cos;
+          SinCos8(_mm256_loadu_ps(sinValues + i), sin, cos);
+          _mm256_storeu_ps(sinValues + i, _mm256_mul_ps(sin, _mm256_loadu_ps(amplitudes + i)));
+     }
+#endif
+     for (; i + 4 <= sinNumber; i += 4)
+     {
+          __m128 sin, cos;
+          SinCos4(_mm_loadu_ps(sinValues + i), sin, cos);
+          _mm_storeu_ps(sinValues + i, _mm_mul_ps(sin, _mm_loadu_ps(amplitudes + i)));
+     }
+     if (i < sinNumber)
+     {
+          float tail[4] = {};
+          std::copy(sinValues + i, sinValues + sinNumber, tail);
+          __m128 sin, cos;
+          SinCos4(_mm_loadu_ps(tail), sin, cos);
+          _mm_storeu_ps(tail, sin);
+          for (std::size_t j = 0; i + j < sinNumber; ++j)
+               sinValues[i + j] = amplitudes[i + j] * tail[j];
+     }
+     for (std::size_t i = 0; i < sinNumber; ++i)
+          AddToTarget(sinTargets_[i], sinValues[i], positions, colors);
+
+     for (std::size_t i = 0; i < curveTargets_.size(); ++i)
+     {
+          const float *times = keyTimes_.data() + curveFirstKeys_[i];
+          const float *values = keyValues_.data() + curveFirstKeys_[i];
+          const std::size_t keyNumber = curveKeyNumbers_[i];
+          const float period = curvePeriods_[i];
+
+          float time = static_cast<float>(period > 0.0f ? std::fmod(seconds, static_cast<double>(period)) : seconds);
+          float value = values[keyNumber - 1];
+          if (time <= times[0])
+               value = values[0];
+          else if (time < times[keyNumber - 1])
+          {
+               const std::size_t next = std::upper_bound(times, times + keyNumber, time) - times;
+               const float t = (time - times[next - 1]) / (times[next] - times[next - 1]);
+               value = values[next - 1] + (values[next] - values[next - 1]) * t;
+          }
+          AddToTarget(curveTargets_[i], value, positions, colors);
+     }
+
+     // Negative colors darken, so they reach as far as positive ones
+     for (std::size_t i = 0; i < basePositions_.size(); ++i)
+     {
+          const DirectX::XMFLOAT4 &color = colors[i];
+          const float intensity = std::max(std::max(std::abs(color.x), std::abs(color.y)), std::abs(color.z));
+          positions[i].w = ComputeLightRadius(intensity, cutoff_);
+     }
 }
 
-std::vector<DirectX::XMFLOAT4> Lights::GetPositions(std::size_t milliseconds)
+std::uint32_t Lights::GetTarget(const std::uint32_t light, const Channel channel) const
 {
-     std::vector<DirectX::XMFLOAT4> res;
-     res.reserve(lights.size());
-     std::for_each(
-          lights.begin(),
-          lights.end(),
-          [milliseconds, &res](auto &lightInfo) {res.push_back(lightInfo.positionGetter(milliseconds)); });
-     return res;
+     return light * 8 + static_cast<std::uint32_t>(channel);
 }
 
-std::vector<DirectX::XMFLOAT4> Lights::GetColors(std::size_t milliseconds)
+void Lights::AddToTarget(const std::uint32_t target, const float value, DirectX::XMFLOAT4 *positions, DirectX::XMFLOAT4 *colors)
 {
-     std::vector<DirectX::XMFLOAT4> res;
-     res.reserve(lights.size());
-     std::for_each(
-          lights.begin(),
-          lights.end(),
-          [milliseconds, &res](auto &lightInfo) {res.push_back(lightInfo.colorGetter(milliseconds)); });
-     return res;
+     const std::uint32_t light = target / 8;
+     const std::uint32_t component = target % 8;
+     float *destination = component < 4 ? &positions[light].x : &colors[light].x;
+     destination[component % 4] += value;
 }
@@ -1,25 +1,74 @@
 #pragma once
 
 #include <directxmath.h>
-#include <stdint.h>
-#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
-static const constexpr std::size_t maxLightNumber = 10;
-
-struct LightInfo
-{
-     std::function<DirectX::XMFLOAT4(std::size_t milliseconds)> positionGetter;
-     std::function<DirectX::XMFLOAT4(std::size_t milliseconds)> colorGetter;
-};
+// Lights are culled per cluster, so the number is only limited by the cost of clustering
+static const constexpr std::size_t maxLightNumber = 1024;
 
+// Animated point lights described by data. Every light has a base position and color, animation terms are
+// added on top of single components. Terms are kept as structure of arrays and evaluated in one pass.
+// Influence radius follows the evaluated color, see light_falloff.h.
 class Lights
 {
 public:
-     bool Add(const LightInfo& info);
-     std::size_t GetNumber();
-     std::vector<DirectX::XMFLOAT4> GetPositions(std::size_t milliseconds);
-     std::vector<DirectX::XMFLOAT4> GetColors(std::size_t milliseconds);
+     static constexpr const std::uint32_t invalidLight = 0xFFFFFFFF;
+
+     // Animated component, position w is overwritten by the influence radius
+     enum class Channel : std::uint32_t
+     {
+          PositionX,
+          PositionY,
+          PositionZ,
+          PositionW,
+          ColorR,
+          ColorG,
+          ColorB,
+          ColorA
+     };
+
+     Lights(const std::size_t capacity, const float cutoff);
+     // Returns the light index or invalidLight when the capacity is reached
+     std::uint32_t Add(const DirectX::XMFLOAT4 &position, const DirectX::XMFLOAT4 &color);
+     // amplitude * sin(frequency * seconds + phase)
+     bool AddSinusoid(const std::uint32_t light, const Channel channel, const float amplitude, const float frequency, const float phase);
+     // Circle of the given radius around the base position in XZ plane, starts at +z
+     bool AddOrbit(const std::uint32_t light, const float radius, const float frequency, const float phase);
+     // Piecewise linear curve over keyframes with increasing times, repeats with the given period (0 holds the last key)
+     bool AddKeyframes(
+          const std::uint32_t light,
+          const Channel channel,
+          const float *times,
+          const float *values,
+          const std::size_t keyNumber,
+          const float period);
+     std::size_t GetNumber() const;
+     // Writes GetNumber() positions with influence radius in w and colors
+     void Evaluate(const double seconds, DirectX::XMFLOAT4 *positions, DirectX::XMFLOAT4 *colors);
 
 private:
-     std::vector<LightInfo> lights;
+     std::uint32_t GetTarget(const std::uint32_t light, const Channel channel) const;
+     static void AddToTarget(const std::uint32_t target, const float value, DirectX::XMFLOAT4 *positions, DirectX::XMFLOAT4 *colors);
+
+     std::size_t capacity_;
+     float cutoff_;
+     std::vector<DirectX::XMFLOAT4> basePositions_;
+     std::vector<DirectX::XMFLOAT4> baseColors_;
+
+     // Sinusoid terms, target is light * 8 + channel
+     std::vector<std::uint32_t> sinTargets_;
+     std::vector<float> sinAmplitudes_;
+     std::vector<float> sinFrequencies_;
+     std::vector<float> sinPhases_;
+     std::vector<float> sinValues_;
+
+     // Keyframe curves, keys of a curve are a range in the shared key arrays
+     std::vector<std::uint32_t> curveTargets_;
+     std::vector<std::uint32_t> curveFirstKeys_;
+     std::vector<std::uint32_t> curveKeyNumbers_;
+     std::vector<float> curvePeriods_;
+     std::vector<float> keyTimes_;
+     std::vector<float> keyValues_;
 };
@@ -0,0 +1,148 @@
+#include "loose_octree.h"
+
+LooseOctree::LooseOctree(const DirectX::XMFLOAT3 &center, const float halfSize, const unsigned depth) :
+     origin_{center.x - halfSize, center.y - halfSize, center.z - halfSize},
+     depth_(std::min(depth, maxDepth_)),
+     freeHandle_(invalidHandle),
+     size_(0)
+{
+     levelOffsets_[0] = 0;
+     for (unsigned level = 0; level <= depth_; ++level)
+     {
+          cellSizes_[level] = 2.0f * halfSize / static_cast<float>(1u << level);
+          levelOffsets_[level + 1] = levelOffsets_[level] + (1u << (3 * level));
+     }
+     nodes_.resize(levelOffsets_[depth_ + 1]);
+     for (auto &node : nodes_)
+          node.subtreeSize = 0;
+}
+
+void LooseOctree::Clear()
+{
+     // Entry arrays keep their capacity for the next filling
+     for (auto &node : nodes_)
+     {
+          node.entries.clear();
+          node.subtreeSize = 0;
+     }
+     objects_.clear();
+     freeHandle_ = invalidHandle;
+     size_ = 0;
+}
+
+std::uint32_t LooseOctree::Insert(const DirectX::XMFLOAT3 &center, const float radius)
+{
+     std::uint32_t handle;
+     if (invalidHandle != freeHandle_)
+     {
+          handle = freeHandle_;
+          freeHandle_ = objects_[handle].slot;
+     }
+     else
+     {
+          handle = static_cast<std::uint32_t>(objects_.size());
+          objects_.push_back(Object{});
+     }
+
+     Link(handle, FindNode(center, radius), center, radius);
+     ++size_;
+     return handle;
+}
+
+void LooseOctree::Update(const std::uint32_t handle, const DirectX::XMFLOAT3 &center, const float radius)
+{
+     const Object &object = objects_[handle];
+     const std::uint32_t node = FindNode(center, radius);
+     if (node == object.node)
+     {
+          Entry &entry = nodes_[node].entries[object.slot];
+          entry.center = center;
+          entry.radius = radius;
+          return;
+     }
+
+     Unlink(handle);
+     Link(handle, node, center, radius);
+}
+
+void LooseOctree::Remove(const std::uint32_t handle)
+{
+     Unlink(handle);
+     objects_[handle].node = invalidHandle;
+     objects_[handle].slot = freeHandle_;
+     freeHandle_ = handle;
+     --size_;
+}
+
+std::size_t LooseOctree::GetSize() const
+{
+     return size_;
+}
+
+std::uint32_t LooseOctree::FindNode(const DirectX::XMFLOAT3 &center, const float radius) const
+{
+     const float local[] = {center.x - origin_[0], center.y - origin_[1], center.z - origin_[2]};
+     const float rootSize = cellSizes_[0];
+     // Negated comparison also sends NaN to root
+     if (!(local[0] >= 0.0f && local[0] < rootSize && local[1] >= 0.0f && local[1] < rootSize && local[2] >= 0.0f && local[2] < rootSize))
+          return 0;
+
+     // Loose cell extends by half of the cell size around the cell
+     unsigned level = depth_;
+     while (level > 0 && radius > 0.5f * cellSizes_[level])
+          --level;
+
+     const std::uint32_t cellNumber = 1u << level;
+     std::uint32_t cell[3];
+     for (int axis = 0; axis < 3; ++axis)
+          cell[axis] = std::min(cellNumber - 1, static_cast<std::uint32_t>(local[axis] / cellSizes_[level]));
+     return levelOffsets_[level] + (cell[2] << (2 * level)) + (cell[1] << level) + cell[0];
+}
+
+void LooseOctree::Link(const std::uint32_t handle, const std::uint32_t node, const DirectX::XMFLOAT3 &center, const float radius)
+{
+     auto &entries = nodes_[node].entries;
+     objects_[handle] = Object{node, static_cast<std::uint32_t>(entries.size())};
+     entries.push_back(Entry{center, radius, handle});
+     AddSubtreeSize(node, 1);
+}
+
+void LooseOctree::Unlink(const std::uint32_t handle)
+{
+     const Object &object = objects_[handle];
+     auto &entries = nodes_[object.node].entries;
+     if (object.slot + 1 != entries.size())
+     {
+          entries[object.slot] = entries.back();
+          objects_[entries[object.slot].handle].slot = object.slot;
+     }
+     entries.pop_back();
+     AddSubtreeSize(object.node, -1);
+}
+
+void LooseOctree::AddSubtreeSize(std::uint32_t node, const std::int32_t delta)
+{
+     unsigned level = GetLevel(node);
+     const std::uint32_t cell = node - levelOffsets_[level];
+     std::uint32_t x = cell & ((1u << level) - 1);
+     std::uint32_t y = (cell >> level) & ((1u << level) - 1);
+     std::uint32_t z = cell >> (2 * level);
+     while (true)
+     {
+          nodes_[levelOffsets_[level] + (z << (2 * level)) + (y << level) + x].subtreeSize += delta;
+          if (0 == level)
+               break;
+          --level;
+          x >>= 1;
+          y >>= 1;
+          z >>= 1;
+     }
+}
+
+std::uint32_t LooseOctree::GetLevel(const std::uint32_t node) const
+{
+     std::uint32_t level = 0;
+     while (node >= levelOffsets_[level + 1])
+          ++level;
+     return level;
+}
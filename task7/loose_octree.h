@@ -0,0 +1,239 @@
+#pragma once
+
+#include "frustum.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Loose octree over bounding spheres stored as dense levels of nodes. Object goes straight to the
+// deepest level where it fits into loose cell (twice the cell size) around its center, so insertion
+// and moving are O(depth) without searching. Objects outside of root or too large stay in root.
+// Nodes keep spheres of their objects contiguously, removal swaps the last one into the hole.
+// Queries walk the tree with fixed size stack and call visitor(handle) for each hit, ray query
+// calls visitor(handle, distance).
+class LooseOctree
+{
+public:
+     static constexpr const std::uint32_t invalidHandle = 0xFFFFFFFF;
+
+     LooseOctree(const DirectX::XMFLOAT3 &center, const float halfSize, const unsigned depth = 5);
+     void Clear();
+     std::uint32_t Insert(const DirectX::XMFLOAT3 &center, const float radius);
+     void Update(const std::uint32_t handle, const DirectX::XMFLOAT3 &center, const float radius);
+     void Remove(const std::uint32_t handle);
+     // Number of live objects
+     std::size_t GetSize() const;
+
+     template <typename Visitor>
+     void VisitFrustum(const Frustum &frustum, Visitor &&visitor) const
+     {
+          Traverse(
+               Frustum::allPlanesMask,
+               [&frustum](const float *min, const float *max, unsigned &planeMask)
+               {
+                    return frustum.CheckRectangleMasked(min, max, planeMask);
+               },
+               [&frustum, &visitor](const std::uint32_t handle, const Entry &object, const unsigned planeMask)
+               {
+                    if (0 == planeMask || frustum.CheckSphere(object.center, object.radius))
+                         visitor(handle);
+               });
+     }
+
+     template <typename Visitor>
+     void VisitSphere(const DirectX::XMFLOAT3 &center, const float radius, Visitor &&visitor) const
+     {
+          const float c[] = {center.x, center.y, center.z};
+          Traverse(
+               1,
+               [&c, radius](const float *min, const float *max, unsigned &)
+               {
+                    float distanceSq = 0.0f;
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                         const float d = std::max({min[axis] - c[axis], c[axis] - max[axis], 0.0f});
+                         distanceSq += d * d;
+                    }
+                    return distanceSq <= radius * radius;
+               },
+               [&center, radius, &visitor](const std::uint32_t handle, const Entry &object, const unsigned)
+               {
+                    const float dx = object.center.x - center.x;
+                    const float dy = object.center.y - center.y;
+                    const float dz = object.center.z - center.z;
+                    const float r = object.radius + radius;
+                    if (dx * dx + dy * dy + dz * dz <= r * r)
+                         visitor(handle);
+               });
+     }
+
+     template <typename Visitor>
+     void VisitAabb(const DirectX::XMFLOAT3 &boxMin, const DirectX::XMFLOAT3 &boxMax, Visitor &&visitor) const
+     {
+          const float bMin[] = {boxMin.x, boxMin.y, boxMin.z};
+          const float bMax[] = {boxMax.x, boxMax.y, boxMax.z};
+          Traverse(
+               1,
+               [&bMin, &bMax](const float *min, const float *max, unsigned &)
+               {
+                    return min[0] <= bMax[0] && max[0] >= bMin[0] &&
+                         min[1] <= bMax[1] && max[1] >= bMin[1] &&
+                         min[2] <= bMax[2] && max[2] >= bMin[2];
+               },
+               [&bMin, &bMax, &visitor](const std::uint32_t handle, const Entry &object, const unsigned)
+               {
+                    const float c[] = {object.center.x, object.center.y, object.center.z};
+                    float distanceSq = 0.0f;
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                         const float d = std::max({bMin[axis] - c[axis], c[axis] - bMax[axis], 0.0f});
+                         distanceSq += d * d;
+                    }
+                    if (distanceSq <= object.radius * object.radius)
+                         visitor(handle);
+               });
+     }
+
+     // Hits of segment origin + t * direction, t in [0, maxDistance]; direction must be normalized
+     template <typename Visitor>
+     void VisitRay(const DirectX::XMFLOAT3 &origin, const DirectX::XMFLOAT3 &direction, const float maxDistance, Visitor &&visitor) const
+     {
+          const float o[] = {origin.x, origin.y, origin.z};
+          const float d[] = {direction.x, direction.y, direction.z};
+          Traverse(
+               1,
+               [&o, &d, maxDistance](const float *min, const float *max, unsigned &)
+               {
+                    float tMin = 0.0f;
+                    float tMax = maxDistance;
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                         if (std::abs(d[axis]) < 1e-8f)
+                         {
+                              if (o[axis] < min[axis] || o[axis] > max[axis])
+                                   return false;
+                              continue;
+                         }
+                         const float invDir = 1.0f / d[axis];
+                         const float t0 = (min[axis] - o[axis]) * invDir;
+                         const float t1 = (max[axis] - o[axis]) * invDir;
+                         tMin = std::max(tMin, std::min(t0, t1));
+                         tMax = std::min(tMax, std::max(t0, t1));
+                         if (tMin > tMax)
+                              return false;
+                    }
+                    return true;
+               },
+               [&origin, &direction, maxDistance, &visitor](const std::uint32_t handle, const Entry &object, const unsigned)
+               {
+                    const float mx = origin.x - object.center.x;
+                    const float my = origin.y - object.center.y;
+                    const float mz = origin.z - object.center.z;
+                    const float b = mx * direction.x + my * direction.y + mz * direction.z;
+                    const float c = mx * mx + my * my + mz * mz - object.radius * object.radius;
+                    const float discriminant = b * b - c;
+                    if (discriminant < 0.0f)
+                         return;
+                    // Origin inside sphere counts as hit at 0
+                    const float t = std::max(0.0f, -b - std::sqrt(discriminant));
+                    if (t <= maxDistance && (c <= 0.0f || b < 0.0f))
+                         visitor(handle, t);
+               });
+     }
+
+private:
+     static constexpr const unsigned maxDepth_ = 6;
+
+     struct Entry
+     {
+          DirectX::XMFLOAT3 center;
+          float radius;
+          std::uint32_t handle;
+     };
+     struct Node
+     {
+          std::vector<Entry> entries;
+          std::uint32_t subtreeSize;
+     };
+     struct Object
+     {
+          std::uint32_t node; // invalidHandle for removed object
+          std::uint32_t slot; // next free handle for removed object
+     };
+     struct StackEntry
+     {
+          std::uint32_t level;
+          std::uint32_t x;
+          std::uint32_t y;
+          std::uint32_t z;
+          unsigned mask;
+     };
+
+     std::uint32_t FindNode(const DirectX::XMFLOAT3 &center, const float radius) const;
+     void Link(const std::uint32_t handle, const std::uint32_t node, const DirectX::XMFLOAT3 &center, const float radius);
+     void Unlink(const std::uint32_t handle);
+     void AddSubtreeSize(std::uint32_t node, const std::int32_t delta);
+     std::uint32_t GetLevel(const std::uint32_t node) const;
+
+     // nodeTest(min, max, mask) checks loose bounds and may narrow mask passed to children,
+     // objectVisitor(handle, object, mask) tests and reports objects of accepted nodes
+     template <typename NodeTest, typename ObjectVisitor>
+     void Traverse(const unsigned rootMask, NodeTest &&nodeTest, ObjectVisitor &&objectVisitor) const
+     {
+          if (0 == nodes_[0].subtreeSize)
+               return;
+
+          StackEntry stack[7 * maxDepth_ + 1];
+          std::size_t stackSize = 0;
+          // Root bounds are unlimited because it keeps objects outside of the tree
+          stack[stackSize++] = {0, 0, 0, 0, rootMask};
+          while (stackSize > 0)
+          {
+               const StackEntry entry = stack[--stackSize];
+               const std::uint32_t nodeIndex = levelOffsets_[entry.level] +
+                    (entry.z << (2 * entry.level)) + (entry.y << entry.level) + entry.x;
+               unsigned mask = entry.mask;
+               if (entry.level > 0)
+               {
+                    const float cellSize = cellSizes_[entry.level];
+                    const float min[] = {
+                         origin_[0] + (entry.x - 0.5f) * cellSize,
+                         origin_[1] + (entry.y - 0.5f) * cellSize,
+                         origin_[2] + (entry.z - 0.5f) * cellSize};
+                    const float max[] = {min[0] + 2.0f * cellSize, min[1] + 2.0f * cellSize, min[2] + 2.0f * cellSize};
+                    if (!nodeTest(min, max, mask))
+                         continue;
+               }
+
+               for (const auto &object : nodes_[nodeIndex].entries)
+                    objectVisitor(object.handle, object, mask);
+
+               if (entry.level == depth_)
+                    continue;
+               const std::uint32_t childLevel = entry.level + 1;
+               for (std::uint32_t child = 0; child < 8; ++child)
+               {
+                    const std::uint32_t x = 2 * entry.x + (child & 1);
+                    const std::uint32_t y = 2 * entry.y + ((child >> 1) & 1);
+                    const std::uint32_t z = 2 * entry.z + (child >> 2);
+                    const std::uint32_t childIndex = levelOffsets_[childLevel] + (z << (2 * childLevel)) + (y << childLevel) + x;
+                    if (nodes_[childIndex].subtreeSize > 0)
+                         stack[stackSize++] = {childLevel, x, y, z, mask};
+               }
+          }
+     }
+
+     float origin_[3]; // root cell min corner
+     float cellSizes_[maxDepth_ + 1];
+     std::uint32_t levelOffsets_[maxDepth_ + 2];
+     unsigned depth_;
+
+     std::vector<Node> nodes_;
+     std::vector<Object> objects_;
+     std::uint32_t freeHandle_;
+     std::size_t size_;
+};
@@ -2,7 +2,9 @@
 #include "camera.h"
 #include "input.h"
 #include <windows.h>
+#include <atomic>
 #include <filesystem>
+#include <thread>
 #include <xstring>
 
 #define __CRTDBG_MAP_ALLOC
@@ -95,6 +97,15 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
      if (!renderer.Init(hWnd, std::make_shared<Camera>(), std::make_shared<Input>(hInstance, hWnd)))
           return EXIT_FAILURE;
 
+     // Simulation runs on its own thread and hands frames over to the render loop below
+     std::atomic<bool> simulate(true);
+     std::thread simulationThread(
+          [&renderer, &simulate]()
+          {
+               while (simulate.load(std::memory_order_relaxed))
+                    renderer.Update();
+          });
+
      // Run the message loop
      MSG msg = {};
      HACCEL hAccelTable = LoadAccelerators(hInstance, L"");
@@ -111,9 +122,11 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
                if (WM_QUIT == msg.message)
                     exit = true;
           }
-          renderer.Update();
           renderer.Render();
      }
 
+     simulate.store(false, std::memory_order_relaxed);
+     simulationThread.join();
+
      return 0;
 }
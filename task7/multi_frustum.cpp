@@ -0,0 +1,82 @@
+#include "multi_frustum.h"
+#include "box_planes.h"
+
+#include <immintrin.h>
+
+void MultiFrustum::Clear()
+{
+     planes_.clear();
+}
+
+bool MultiFrustum::Add(const Frustum &frustum)
+{
+     if (GetNumber() >= maxFrustumNumber)
+          return false;
+
+     for (int i = 0; i < 6; ++i)
+          planes_.insert(planes_.end(), frustum.GetPlane(i), frustum.GetPlane(i) + 4);
+     return true;
+}
+
+std::size_t MultiFrustum::GetNumber() const
+{
+     return planes_.size() / 24;
+}
+
+void MultiFrustum::CheckRectangles(
+     const float *minX,
+     const float *minY,
+     const float *minZ,
+     const float *maxX,
+     const float *maxY,
+     const float *maxZ,
+     const std::size_t count,
+     std::uint32_t *masks) const
+{
+     const std::size_t frustumNumber = GetNumber();
+     std::size_t i = 0;
+
+#if defined(__AVX2__)
+     for (; i + 8 <= count; i += 8)
+     {
+          const BoxBatch8 boxes = LoadBoxBatch8(minX, minY, minZ, maxX, maxY, maxZ, i);
+          __m256i result = _mm256_setzero_si256();
+          for (std::size_t k = 0; k < frustumNumber; ++k)
+          {
+               const __m256 inside = CheckBoxPlanes8(boxes, planes_.data() + k * 24, 6);
+               result = _mm256_or_si256(
+                    result,
+                    _mm256_and_si256(_mm256_castps_si256(inside), _mm256_set1_epi32(static_cast<int>(1u << k))));
+          }
+          _mm256_storeu_si256(reinterpret_cast<__m256i *>(masks + i), result);
+     }
+#endif
+
+     for (; i + 4 <= count; i += 4)
+     {
+          const BoxBatch4 boxes = LoadBoxBatch4(minX, minY, minZ, maxX, maxY, maxZ, i);
+          __m128i result = _mm_setzero_si128();
+          for (std::size_t k = 0; k < frustumNumber; ++k)
+          {
+               const __m128 inside = CheckBoxPlanes4(boxes, planes_.data() + k * 24, 6);
+               result = _mm_or_si128(
+                    result,
+                    _mm_and_si128(_mm_castps_si128(inside), _mm_set1_epi32(static_cast<int>(1u << k))));
+          }
+          _mm_storeu_si128(reinterpret_cast<__m128i *>(masks + i), result);
+     }
+
+     for (; i < count; ++i)
+     {
+          std::uint32_t mask = 0;
+          for (std::size_t k = 0; k < frustumNumber; ++k)
+          {
+               const float *planes = planes_.data() + k * 24;
+               bool inside = true;
+               for (int p = 0; p < 6 && inside; ++p)
+                    inside = PVertexDistance(planes + p * 4, minX[i], minY[i], minZ[i], maxX[i], maxY[i], maxZ[i]) >= 0.0f;
+               mask |= static_cast<std::uint32_t>(inside) << k;
+          }
+          masks[i] = mask;
+     }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "frustum.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Culls boxes against several frusta at once (cube map faces, split views, shadow cascades),
+// each box is loaded once and gets a bit mask of frusta it is visible in.
+class MultiFrustum
+{
+public:
+     static constexpr const std::size_t maxFrustumNumber = 32;
+
+     void Clear();
+     bool Add(const Frustum &frustum);
+     std::size_t GetNumber() const;
+     // Bit k of masks[i] is set if box i is visible in k-th added frustum
+     void CheckRectangles(
+          const float *minX,
+          const float *minY,
+          const float *minZ,
+          const float *maxX,
+          const float *maxY,
+          const float *maxZ,
+          const std::size_t count,
+          std::uint32_t *masks) const;
+
+private:
+     std::vector<float> planes_; // 6 planes of 4 floats per frustum
+};
@@ -0,0 +1,288 @@
+#include "occlusion_culler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <immintrin.h>
+
+OcclusionCuller::OcclusionCuller(const unsigned width, const unsigned height) :
+     width_(width),
+     height_(height),
+     tilesX_((width + tileSize_ - 1) / tileSize_),
+     tilesY_((height + tileSize_ - 1) / tileSize_),
+     viewProj_(DirectX::XMMatrixIdentity()),
+     depth_(static_cast<std::size_t>(tilesX_) * tilesY_ * tileSize_ * tileSize_, 0.0f),
+     cornerMinX_(0),
+     cornerMinY_(0),
+     cornerMaxX_(0),
+     cornerMaxY_(0),
+     cornerStride_(0)
+{
+     unsigned levelWidth = tilesX_;
+     unsigned levelHeight = tilesY_;
+     while (true)
+     {
+          hiZ_.emplace_back(static_cast<std::size_t>(levelWidth) * levelHeight, 0.0f);
+          hiZWidths_.push_back(levelWidth);
+          hiZHeights_.push_back(levelHeight);
+          if (1 == levelWidth && 1 == levelHeight)
+               break;
+          levelWidth = (levelWidth + 1) / 2;
+          levelHeight = (levelHeight + 1) / 2;
+     }
+}
+
+void OcclusionCuller::Clear(DirectX::FXMMATRIX viewProj)
+{
+     viewProj_ = viewProj;
+     std::fill(depth_.begin(), depth_.end(), 0.0f);
+}
+
+OcclusionCuller::ScreenVertex OcclusionCuller::Project(DirectX::FXMVECTOR pos, DirectX::CXMMATRIX transform) const
+{
+     DirectX::XMFLOAT4 clip;
+     DirectX::XMStoreFloat4(&clip, DirectX::XMVector4Transform(pos, transform));
+
+     ScreenVertex res;
+     res.w = clip.w;
+     if (clip.w < minW_)
+          return res;
+     const float invW = 1.0f / clip.w;
+     res.x = (clip.x * invW * 0.5f + 0.5f) * width_;
+     res.y = (0.5f - clip.y * invW * 0.5f) * height_;
+     res.z = clip.z * invW;
+     return res;
+}
+
+void OcclusionCuller::RenderOccluder(
+     const void *vertices,
+     const std::size_t vertexCount,
+     const std::size_t vertexStride,
+     const unsigned short *indices,
+     const std::size_t indexCount,
+     DirectX::FXMMATRIX world)
+{
+     const DirectX::XMMATRIX worldViewProj = DirectX::XMMatrixMultiply(world, viewProj_);
+     transformed_.resize(vertexCount);
+     float rectMinX = FLT_MAX;
+     float rectMinY = FLT_MAX;
+     float rectMaxX = -FLT_MAX;
+     float rectMaxY = -FLT_MAX;
+     const char *pVertex = static_cast<const char *>(vertices);
+     for (std::size_t i = 0; i < vertexCount; ++i)
+     {
+          const auto &pos = *reinterpret_cast<const DirectX::XMFLOAT3 *>(pVertex + i * vertexStride);
+          const ScreenVertex v = Project(DirectX::XMVectorSet(pos.x, pos.y, pos.z, 1.0f), worldViewProj);
+          // Part in front of the near plane is clipped on GPU and hides nothing, skipping occluder is always safe
+          if (v.w < minW_ || v.z > 1.0f)
+               return;
+          transformed_[i] = v;
+          rectMinX = std::min(rectMinX, v.x);
+          rectMinY = std::min(rectMinY, v.y);
+          rectMaxX = std::max(rectMaxX, v.x);
+          rectMaxY = std::max(rectMaxY, v.y);
+     }
+
+     // Corners of pixels which the occluder can cover entirely
+     cornerMinX_ = std::max(0, static_cast<int>(std::ceil(rectMinX))) & ~3;
+     cornerMinY_ = std::max(0, static_cast<int>(std::ceil(rectMinY)));
+     cornerMaxX_ = std::min(static_cast<int>(width_), static_cast<int>(std::floor(rectMaxX)));
+     cornerMaxY_ = std::min(static_cast<int>(height_), static_cast<int>(std::floor(rectMaxY)));
+     if (cornerMaxX_ - cornerMinX_ < 1 || cornerMaxY_ - cornerMinY_ < 1)
+          return;
+     // Quad of pixels reads one corner past its last pixel
+     cornerStride_ = ((cornerMaxX_ - cornerMinX_ + 4) & ~3) + 4;
+     corners_.assign(static_cast<std::size_t>(cornerStride_) * (cornerMaxY_ - cornerMinY_ + 1), -FLT_MAX);
+
+     for (std::size_t i = 0; i + 2 < indexCount; i += 3)
+          RasterizeTriangle(transformed_[indices[i]], transformed_[indices[i + 1]], transformed_[indices[i + 2]]);
+     ResolveCorners();
+}
+
+void OcclusionCuller::RasterizeTriangle(const ScreenVertex &v0, const ScreenVertex &v1, const ScreenVertex &v2)
+{
+     // Edge functions are positive inside of clockwise (in screen space with y down) triangle
+     const float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+     if (area <= 0.0f)
+          return;
+
+     const int minX = std::max(cornerMinX_, static_cast<int>(std::ceil(std::min({v0.x, v1.x, v2.x}))));
+     const int maxX = std::min(cornerMaxX_, static_cast<int>(std::floor(std::max({v0.x, v1.x, v2.x}))));
+     const int minY = std::max(cornerMinY_, static_cast<int>(std::ceil(std::min({v0.y, v1.y, v2.y}))));
+     const int maxY = std::min(cornerMaxY_, static_cast<int>(std::floor(std::max({v0.y, v1.y, v2.y}))));
+     if (minX > maxX || minY > maxY)
+          return;
+
+     // e(px, py) = a * px + b * py + c for edge from p to q
+     const ScreenVertex *edges[3][2] = {{&v1, &v2}, {&v2, &v0}, {&v0, &v1}};
+     float a[3], b[3], c[3];
+     for (int i = 0; i < 3; ++i)
+     {
+          const ScreenVertex &p = *edges[i][0];
+          const ScreenVertex &q = *edges[i][1];
+          a[i] = -(q.y - p.y);
+          b[i] = q.x - p.x;
+          c[i] = (q.y - p.y) * p.x - (q.x - p.x) * p.y;
+     }
+     const float invArea = 1.0f / area;
+     const float zA = (a[0] * v0.z + a[1] * v1.z + a[2] * v2.z) * invArea;
+     const float zB = (b[0] * v0.z + b[1] * v1.z + b[2] * v2.z) * invArea;
+     const float zC = (c[0] * v0.z + c[1] * v1.z + c[2] * v2.z) * invArea;
+
+     // Corners on shared edges are covered by both triangles, so the inside test is inclusive
+     const __m128 laneOffset = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+     const __m128 zero = _mm_setzero_ps();
+     const int quadBegin = cornerMinX_ + ((minX - cornerMinX_) & ~3);
+     for (int y = minY; y <= maxY; ++y)
+     {
+          const float py = static_cast<float>(y);
+          float *row = corners_.data() + static_cast<std::size_t>(y - cornerMinY_) * cornerStride_;
+          for (int x = quadBegin; x <= maxX; x += 4)
+          {
+               const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffset);
+               __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+               for (int i = 0; i < 3; ++i)
+               {
+                    const __m128 e = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[i]), px), _mm_set1_ps(b[i] * py + c[i]));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(e, zero));
+               }
+               if (0 == _mm_movemask_ps(inside))
+                    continue;
+               const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(zA), px), _mm_set1_ps(zB * py + zC));
+               const __m128 old = _mm_loadu_ps(row + x - cornerMinX_);
+               const __m128 closest = _mm_max_ps(old, z);
+               _mm_storeu_ps(row + x - cornerMinX_, _mm_or_ps(_mm_and_ps(inside, closest), _mm_andnot_ps(inside, old)));
+          }
+     }
+}
+
+void OcclusionCuller::ResolveCorners()
+{
+     // Front surface depth of convex mesh is concave in screen space, so its minimum over a pixel is at
+     // a corner. Pixel is inside the convex silhouette when its corners are, uncovered corner keeps it
+     // at -FLT_MAX which never wins over the buffer.
+     for (int y = cornerMinY_; y < cornerMaxY_; ++y)
+     {
+          const float *top = corners_.data() + static_cast<std::size_t>(y - cornerMinY_) * cornerStride_;
+          const float *bottom = top + cornerStride_;
+          float *tileRow = depth_.data() +
+               (static_cast<std::size_t>(y / tileSize_) * tilesX_ * tileSize_ + y % tileSize_) * tileSize_;
+          for (int x = cornerMinX_; x < cornerMaxX_; x += 4)
+          {
+               const int column = x - cornerMinX_;
+               const __m128 farthest = _mm_min_ps(
+                    _mm_min_ps(_mm_loadu_ps(top + column), _mm_loadu_ps(top + column + 1)),
+                    _mm_min_ps(_mm_loadu_ps(bottom + column), _mm_loadu_ps(bottom + column + 1)));
+               float *pixels = tileRow + (x / tileSize_) * tileSize_ * tileSize_ + x % tileSize_;
+               _mm_storeu_ps(pixels, _mm_max_ps(_mm_loadu_ps(pixels), farthest));
+          }
+     }
+}
+
+void OcclusionCuller::BuildHiZ()
+{
+     std::vector<float> &level0 = hiZ_[0];
+     for (std::size_t tile = 0; tile < level0.size(); ++tile)
+     {
+          const float *values = depth_.data() + tile * tileSize_ * tileSize_;
+          __m128 farthest = _mm_loadu_ps(values);
+          for (unsigned i = 4; i < tileSize_ * tileSize_; i += 4)
+               farthest = _mm_min_ps(farthest, _mm_loadu_ps(values + i));
+          farthest = _mm_min_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(1, 0, 3, 2)));
+          farthest = _mm_min_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(2, 3, 0, 1)));
+          level0[tile] = _mm_cvtss_f32(farthest);
+     }
+
+     for (std::size_t level = 1; level < hiZ_.size(); ++level)
+     {
+          const std::vector<float> &src = hiZ_[level - 1];
+          const unsigned srcWidth = hiZWidths_[level - 1];
+          const unsigned srcHeight = hiZHeights_[level - 1];
+          for (unsigned y = 0; y < hiZHeights_[level]; ++y)
+               for (unsigned x = 0; x < hiZWidths_[level]; ++x)
+               {
+                    const unsigned x1 = std::min(2 * x + 1, srcWidth - 1);
+                    const unsigned y1 = std::min(2 * y + 1, srcHeight - 1);
+                    hiZ_[level][y * hiZWidths_[level] + x] = std::min(
+                         std::min(src[2 * y * srcWidth + 2 * x], src[2 * y * srcWidth + x1]),
+                         std::min(src[y1 * srcWidth + 2 * x], src[y1 * srcWidth + x1]));
+               }
+     }
+}
+
+bool OcclusionCuller::CheckRectangle(const float *min, const float *max) const
+{
+     float rectMinX = static_cast<float>(width_);
+     float rectMinY = static_cast<float>(height_);
+     float rectMaxX = 0.0f;
+     float rectMaxY = 0.0f;
+     float nearest = 0.0f;
+     for (int corner = 0; corner < 8; ++corner)
+     {
+          const ScreenVertex v = Project(DirectX::XMVectorSet(
+               corner & 1 ? max[0] : min[0],
+               corner & 2 ? max[1] : min[1],
+               corner & 4 ? max[2] : min[2],
+               1.0f),
+               viewProj_);
+          // Box reaches the camera plane
+          if (v.w < minW_)
+               return true;
+          rectMinX = std::min(rectMinX, v.x);
+          rectMinY = std::min(rectMinY, v.y);
+          rectMaxX = std::max(rectMaxX, v.x);
+          rectMaxY = std::max(rectMaxY, v.y);
+          nearest = std::max(nearest, v.z);
+     }
+     if (rectMinX >= width_ || rectMinY >= height_ || rectMaxX <= 0.0f || rectMaxY <= 0.0f)
+          return true;
+
+     const unsigned pixelMinX = static_cast<unsigned>(std::max(0.0f, rectMinX));
+     const unsigned pixelMinY = static_cast<unsigned>(std::max(0.0f, rectMinY));
+     const unsigned pixelMaxX = static_cast<unsigned>(std::min(static_cast<float>(width_ - 1), rectMaxX));
+     const unsigned pixelMaxY = static_cast<unsigned>(std::min(static_cast<float>(height_ - 1), rectMaxY));
+
+     // Choose the finest level where rectangle covers at most 2x2 texels
+     std::size_t level = 0;
+     unsigned minX = pixelMinX / tileSize_;
+     unsigned minY = pixelMinY / tileSize_;
+     unsigned maxX = pixelMaxX / tileSize_;
+     unsigned maxY = pixelMaxY / tileSize_;
+     while (level + 1 < hiZ_.size() && (maxX - minX > 1 || maxY - minY > 1))
+     {
+          ++level;
+          minX /= 2;
+          minY /= 2;
+          maxX /= 2;
+          maxY /= 2;
+     }
+
+     float farthest = 1.0f;
+     for (unsigned y = minY; y <= maxY; ++y)
+          for (unsigned x = minX; x <= maxX; ++x)
+               farthest = std::min(farthest, hiZ_[level][y * hiZWidths_[level] + x]);
+
+     return nearest * depthBias_ >= farthest;
+}
+
+std::size_t OcclusionCuller::Filter(
+     const float *minX,
+     const float *minY,
+     const float *minZ,
+     const float *maxX,
+     const float *maxY,
+     const float *maxZ,
+     std::uint32_t *indices,
+     const std::size_t count) const
+{
+     std::size_t visibleNumber = 0;
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          const std::uint32_t index = indices[i];
+          const float min[] = {minX[index], minY[index], minZ[index]};
+          const float max[] = {maxX[index], maxY[index], maxZ[index]};
+          if (CheckRectangle(min, max))
+               indices[visibleNumber++] = index;
+     }
+     return visibleNumber;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <directxmath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU occlusion culling: occluders are rasterized into a low resolution tiled depth buffer,
+// candidates are tested by screen space rectangle against hierarchical depth built from it.
+// Depth follows renderer's reversed Z convention: greater value is closer, buffer is cleared to 0.
+class OcclusionCuller
+{
+public:
+     OcclusionCuller(const unsigned width = defaultWidth_, const unsigned height = defaultHeight_);
+     void Clear(DirectX::FXMMATRIX viewProj);
+     // Vertex position must be the first field of vertex of given stride, triangles use clockwise front faces.
+     // Mesh must be closed and convex: only pixels which it covers entirely are written, with the farthest
+     // depth it has inside them. Occluders reaching the near plane are skipped.
+     void RenderOccluder(
+          const void *vertices,
+          const std::size_t vertexCount,
+          const std::size_t vertexStride,
+          const unsigned short *indices,
+          const std::size_t indexCount,
+          DirectX::FXMMATRIX world);
+     void BuildHiZ();
+     // Returns false only if the world space box is surely hidden by occluders
+     bool CheckRectangle(const float *min, const float *max) const;
+     // Keeps visible entries of indices (of SoA boxes) in order, returns their number
+     std::size_t Filter(
+          const float *minX,
+          const float *minY,
+          const float *minZ,
+          const float *maxX,
+          const float *maxY,
+          const float *maxZ,
+          std::uint32_t *indices,
+          const std::size_t count) const;
+
+private:
+     static constexpr const unsigned defaultWidth_ = 256;
+     static constexpr const unsigned defaultHeight_ = 128;
+     static constexpr const unsigned tileSize_ = 8;
+     static constexpr const float minW_ = 1e-5f;
+     // Relative depth tolerance so that occluder does not hide its own bounding box
+     static constexpr const float depthBias_ = 1.001f;
+
+     struct ScreenVertex
+     {
+          float x, y, z, w;
+     };
+
+     // Samples front surface depth at pixel corners of occluder rectangle
+     void RasterizeTriangle(const ScreenVertex &v0, const ScreenVertex &v1, const ScreenVertex &v2);
+     // Writes pixels whose four corners are covered with the farthest corner depth
+     void ResolveCorners();
+     ScreenVertex Project(DirectX::FXMVECTOR pos, DirectX::CXMMATRIX transform) const;
+
+     const unsigned width_;
+     const unsigned height_;
+     const unsigned tilesX_;
+     const unsigned tilesY_;
+
+     DirectX::XMMATRIX viewProj_;
+     std::vector<float> depth_; // tileSize_ x tileSize_ tiles, row major inside tile
+     std::vector<std::vector<float>> hiZ_; // level 0 holds one farthest depth per tile
+     std::vector<unsigned> hiZWidths_;
+     std::vector<unsigned> hiZHeights_;
+     std::vector<ScreenVertex> transformed_;
+     // Corner depths of current occluder, -FLT_MAX where it is not covered. Column 0 is corner cornerMinX_,
+     // which is a multiple of 4 so that quads of pixels stay inside tile rows.
+     std::vector<float> corners_;
+     int cornerMinX_;
+     int cornerMinY_;
+     int cornerMaxX_;
+     int cornerMaxY_;
+     int cornerStride_;
+};
@@ -0,0 +1,50 @@
+#include "parallel_culling.h"
+
+#include <algorithm>
+
+std::size_t CheckRectanglesParallel(
+     const Frustum &frustum,
+     const float *minX,
+     const float *minY,
+     const float *minZ,
+     const float *maxX,
+     const float *maxY,
+     const float *maxZ,
+     const std::size_t count,
+     const std::size_t chunkSize,
+     ThreadPool &threadPool,
+     FrameArena &arena,
+     std::uint32_t *visibleIndices)
+{
+     const std::size_t chunkNumber = (count + chunkSize - 1) / chunkSize;
+     std::size_t *chunkVisibleNumbers = arena.Allocate<std::size_t>(chunkNumber);
+     threadPool.Run(
+          chunkNumber,
+          [&](std::size_t chunk)
+          {
+               const std::size_t begin = chunk * chunkSize;
+               const std::size_t end = std::min(count, begin + chunkSize);
+               std::uint32_t *chunkVisible = visibleIndices + begin;
+               chunkVisibleNumbers[chunk] = frustum.CheckRectangles(
+                    minX + begin,
+                    minY + begin,
+                    minZ + begin,
+                    maxX + begin,
+                    maxY + begin,
+                    maxZ + begin,
+                    end - begin,
+                    chunkVisible);
+               for (std::size_t i = 0; i < chunkVisibleNumbers[chunk]; ++i)
+                    chunkVisible[i] += static_cast<std::uint32_t>(begin);
+          });
+
+     std::size_t visibleNumber = 0;
+     for (std::size_t chunk = 0; chunk < chunkNumber; ++chunk)
+     {
+          const std::uint32_t *chunkVisible = visibleIndices + chunk * chunkSize;
+          if (chunkVisible != visibleIndices + visibleNumber)
+               std::copy(chunkVisible, chunkVisible + chunkVisibleNumbers[chunk], visibleIndices + visibleNumber);
+          visibleNumber += chunkVisibleNumbers[chunk];
+     }
+     return visibleNumber;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "frame_arena.h"
+#include "frustum.h"
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Frustum::CheckRectangles over chunks of chunkSize boxes run on the pool. Chunks write visible indices to
+// their own ranges of visibleIndices (must hold count elements) and are compacted in chunk order, so the
+// result is the same as of one serial call. Per chunk counts live in the frame arena.
+std::size_t CheckRectanglesParallel(
+     const Frustum &frustum,
+     const float *minX,
+     const float *minY,
+     const float *minZ,
+     const float *maxX,
+     const float *maxY,
+     const float *maxZ,
+     const std::size_t count,
+     const std::size_t chunkSize,
+     ThreadPool &threadPool,
+     FrameArena &arena,
+     std::uint32_t *visibleIndices);
@@ -1,4 +1,5 @@
 #include "post_effect.h"
+#include "d3d_constant_buffer_device.h"
 #include "utils.h"
 
 #include <directxmath.h>
@@ -15,7 +16,7 @@ namespace
 
 }
 
-PostEffect::PostEffect(ID3D11Device *device, HWND hwnd, const unsigned width, const unsigned height) :
+PostEffect::PostEffect(ID3D11Device *device, ConstantBufferManager &constantBuffers, HWND hwnd, const unsigned width, const unsigned height) :
      width_(width),
      height_(height),
      useSobel_(defaultUseSobel_),
@@ -23,7 +24,8 @@ PostEffect::PostEffect(ID3D11Device *device, HWND hwnd, const unsigned width, co
      pVertexShader_(nullptr),
      pPixelShader_(nullptr),
      pSamplerState_(nullptr),
-     pConstBuffer_(nullptr)
+     constantBuffers_(constantBuffers),
+     constBlock_(ConstantBufferManager::invalidBlock)
 {
      ID3DBlob *pVertexShaderBlob = NULL;
      auto result = CompileShaderFromFile(L"post_effect_vertex.hlsl", "main", "vs_5_0", &pVertexShaderBlob);
@@ -67,26 +69,10 @@ PostEffect::PostEffect(ID3D11Device *device, HWND hwnd, const unsigned width, co
      if (FAILED(result))
           throw std::exception("Failed to create sampler state");
 
-     D3D11_BUFFER_DESC desc = {};
-     desc.ByteWidth = sizeof(ConstBuffer);
-     desc.Usage = D3D11_USAGE_DEFAULT;
-     desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-     desc.CPUAccessFlags = 0;
-     desc.MiscFlags = 0;
-     desc.StructureByteStride = 0;
-
-     ConstBuffer constBuffer_;
-     constBuffer_.params = DirectX::XMINT4(useSobel_, useGray_, 0, 0);
-     constBuffer_.size = DirectX::XMFLOAT4(1 / static_cast<float>(width_), 1 / static_cast<float>(height_), 0, 0);
-
-     D3D11_SUBRESOURCE_DATA data;
-     data.pSysMem = &constBuffer_;
-     data.SysMemPitch = sizeof(constBuffer_);
-     data.SysMemSlicePitch = 0;
-
-     result = device->CreateBuffer(&desc, &data, &pConstBuffer_);
-     if (FAILED(result))
+     constBlock_ = constantBuffers_.Register("PostEffectBuffer", sizeof(ConstBuffer));
+     if (ConstantBufferManager::invalidBlock == constBlock_)
           throw std::exception("Failed to create constant buffer");
+     WriteConstants();
 }
 
 PostEffect::~PostEffect()
@@ -94,13 +80,22 @@ PostEffect::~PostEffect()
      SafeRelease(pVertexShader_);
      SafeRelease(pPixelShader_);
      SafeRelease(pSamplerState_);
-     SafeRelease(pConstBuffer_);
 }
 
 void PostEffect::Resize(const unsigned width, const unsigned height)
 {
      width_ = width;
      height_ = height;
+     WriteConstants();
+}
+
+void PostEffect::WriteConstants()
+{
+     // Constants only change on resize and are uploaded with the next flush
+     ConstBuffer constBuffer;
+     constBuffer.params = DirectX::XMINT4(useSobel_, useGray_, 0, 0);
+     constBuffer.size = DirectX::XMFLOAT4(1 / static_cast<float>(width_), 1 / static_cast<float>(height_), 0, 0);
+     constantBuffers_.Write(constBlock_, constBuffer);
 }
 
 void PostEffect::Process(
@@ -109,10 +104,7 @@ void PostEffect::Process(
      ID3D11RenderTargetView *renderTarget,
      D3D11_VIEWPORT viewport)
 {
-     ConstBuffer constBuffer_;
-     constBuffer_.params = DirectX::XMINT4(useSobel_, useGray_, 0, 0);
-     constBuffer_.size = DirectX::XMFLOAT4(1 / static_cast<float>(width_), 1 / static_cast<float>(height_), 0, 0);
-     deviceContext->UpdateSubresource(pConstBuffer_, 0, NULL, &constBuffer_, 0, 0);
+     ID3D11Buffer *pConstBuffer = D3DConstantBufferDevice::GetD3DBuffer(constantBuffers_.GetBuffer(constBlock_));
 
      deviceContext->OMSetRenderTargets(1, &renderTarget, nullptr);
      deviceContext->RSSetViewports(1, &viewport);
@@ -122,7 +114,7 @@ void PostEffect::Process(
 
      deviceContext->VSSetShader(pVertexShader_, nullptr, 0);
      deviceContext->PSSetShader(pPixelShader_, nullptr, 0);
-     deviceContext->PSSetConstantBuffers(0, 1, &pConstBuffer_);
+     deviceContext->PSSetConstantBuffers(0, 1, &pConstBuffer);
      deviceContext->PSSetShaderResources(0, 1, &sourceTexture);
      deviceContext->PSSetSamplers(0, 1, &pSamplerState_);
 
@@ -1,11 +1,13 @@
 #pragma once
 
+#include "constant_buffer_manager.h"
+
 #include <d3d11.h>
 
 class PostEffect
 {
 public:
-     PostEffect(ID3D11Device *device, HWND hwnd, const unsigned width, const unsigned height);
+     PostEffect(ID3D11Device *device, ConstantBufferManager &constantBuffers, HWND hwnd, const unsigned width, const unsigned height);
      ~PostEffect();
      void Resize(const unsigned width, const unsigned height);
      void Process(
@@ -15,6 +17,8 @@ public:
           D3D11_VIEWPORT viewport);
 
 private:
+     void WriteConstants();
+
      static constexpr const bool defaultUseSobel_ = true;
      static constexpr const bool defaultUseGray_ = false;
 
@@ -27,5 +31,6 @@ private:
      ID3D11VertexShader *pVertexShader_;
      ID3D11PixelShader *pPixelShader_;
      ID3D11SamplerState *pSamplerState_;
-     ID3D11Buffer *pConstBuffer_;
+     ConstantBufferManager &constantBuffers_;
+     ConstantBufferManager::Block constBlock_;
 };
@@ -0,0 +1,259 @@
+#include "pvs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+
+namespace
+{
+
+     // Box corner i takes max along x, y, z for bits 0, 1, 2, triangles are clockwise from outside
+     constexpr const unsigned short boxIndices[] = {
+          4, 1, 5, 4, 0, 1,
+          2, 7, 3, 2, 6, 7,
+          1, 7, 5, 1, 3, 7,
+          4, 2, 0, 4, 6, 2,
+          5, 6, 4, 5, 7, 6,
+          0, 3, 1, 0, 2, 3};
+
+     Aabb Inflate(const Aabb &box, const float offset)
+     {
+          return Aabb{
+               DirectX::XMFLOAT3(box.min.x - offset, box.min.y - offset, box.min.z - offset),
+               DirectX::XMFLOAT3(box.max.x + offset, box.max.y + offset, box.max.z + offset)};
+     }
+
+     bool IsEmpty(const Aabb &box)
+     {
+          return box.min.x >= box.max.x || box.min.y >= box.max.y || box.min.z >= box.max.z;
+     }
+
+     bool Intersects(const Aabb &a, const Aabb &b)
+     {
+          return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+               a.min.y <= b.max.y && a.max.y >= b.min.y &&
+               a.min.z <= b.max.z && a.max.z >= b.min.z;
+     }
+
+     bool Contains(const Aabb &box, const DirectX::XMFLOAT3 &p)
+     {
+          return p.x >= box.min.x && p.x <= box.max.x &&
+               p.y >= box.min.y && p.y <= box.max.y &&
+               p.z >= box.min.z && p.z <= box.max.z;
+     }
+
+}
+
+Pvs::Pvs() :
+     region_{},
+     cellSize_(1.0f),
+     cellsX_(0),
+     cellsY_(0),
+     cellsZ_(0),
+     objectNumber_(0),
+     wordNumber_(0),
+     currentCell_(std::numeric_limits<std::size_t>::max())
+{
+}
+
+void Pvs::Bake(
+     const Aabb &region,
+     const float cellSize,
+     const std::vector<Aabb> &occluders,
+     const std::vector<Aabb> &targets,
+     ThreadPool &threadPool)
+{
+     region_ = region;
+     cellSize_ = cellSize;
+     cellsX_ = std::max(1u, static_cast<unsigned>(std::ceil((region.max.x - region.min.x) / cellSize)));
+     cellsY_ = std::max(1u, static_cast<unsigned>(std::ceil((region.max.y - region.min.y) / cellSize)));
+     cellsZ_ = std::max(1u, static_cast<unsigned>(std::ceil((region.max.z - region.min.z) / cellSize)));
+     objectNumber_ = targets.size();
+     wordNumber_ = (objectNumber_ + 63) / 64;
+     currentCell_ = std::numeric_limits<std::size_t>::max();
+
+     // Eye at offset d from the cell center, |d| <= half size along every axis, is blocked by occluder o
+     // wherever the center is blocked by o - d, which contains o shrunk by half size. Target seen from
+     // the eye moves by -d, so it stays inside the grown target.
+     const float halfSize = 0.5f * cellSize;
+     std::vector<Aabb> shrunkOccluders;
+     for (const auto &occluder : occluders)
+     {
+          const Aabb box = Inflate(occluder, -halfSize);
+          if (!IsEmpty(box))
+               shrunkOccluders.push_back(box);
+     }
+     std::vector<Aabb> grownTargets(targets.size());
+     for (std::size_t i = 0; i < targets.size(); ++i)
+          grownTargets[i] = Inflate(targets[i], halfSize);
+     const float faceFar = 2.0f * (std::abs(region.max.x - region.min.x) + std::abs(region.max.y - region.min.y) + std::abs(region.max.z - region.min.z));
+
+     const std::size_t cellNumber = static_cast<std::size_t>(cellsX_) * cellsY_ * cellsZ_;
+     std::vector<std::uint64_t> bits(cellNumber * wordNumber_, 0);
+     threadPool.Run(
+          (cellNumber + cellChunkSize_ - 1) / cellChunkSize_,
+          [&](std::size_t chunk)
+          {
+               OcclusionCuller culler(faceSize_, faceSize_);
+               const std::size_t end = std::min(cellNumber, (chunk + 1) * cellChunkSize_);
+               for (std::size_t cell = chunk * cellChunkSize_; cell < end; ++cell)
+                    BakeCell(cell, shrunkOccluders, grownTargets, faceFar, culler, bits.data() + cell * wordNumber_);
+          });
+
+     // Neighbouring cells often see the same objects, so equal sets are stored once
+     std::map<std::vector<std::uint64_t>, std::uint32_t> sets;
+     cellSets_.resize(cellNumber);
+     setOffsets_.clear();
+     data_.clear();
+     for (std::size_t cell = 0; cell < cellNumber; ++cell)
+     {
+          std::vector<std::uint64_t> cellBits(bits.begin() + cell * wordNumber_, bits.begin() + (cell + 1) * wordNumber_);
+          const auto inserted = sets.emplace(std::move(cellBits), static_cast<std::uint32_t>(setOffsets_.size()));
+          cellSets_[cell] = inserted.first->second;
+          if (!inserted.second)
+               continue;
+
+          setOffsets_.push_back(data_.size());
+          std::uint64_t zeroWords = 0;
+          for (const auto word : inserted.first->first)
+          {
+               if (0 == word)
+               {
+                    ++zeroWords;
+                    continue;
+               }
+               data_.push_back(zeroWords);
+               data_.push_back(word);
+               zeroWords = 0;
+          }
+     }
+     setOffsets_.push_back(data_.size());
+}
+
+void Pvs::BakeCell(
+     const std::size_t cell,
+     const std::vector<Aabb> &occluders,
+     const std::vector<Aabb> &targets,
+     const float faceFar,
+     OcclusionCuller &culler,
+     std::uint64_t *bits) const
+{
+     const unsigned x = static_cast<unsigned>(cell % cellsX_);
+     const unsigned y = static_cast<unsigned>(cell / cellsX_ % cellsY_);
+     const unsigned z = static_cast<unsigned>(cell / cellsX_ / cellsY_);
+     const float eye[] = {
+          region_.min.x + (x + 0.5f) * cellSize_,
+          region_.min.y + (y + 0.5f) * cellSize_,
+          region_.min.z + (z + 0.5f) * cellSize_};
+     const auto setVisible = [bits](std::size_t target) { bits[target / 64] |= std::uint64_t(1) << (target % 64); };
+     const auto isVisible = [bits](std::size_t target) { return 0 != (bits[target / 64] & (std::uint64_t(1) << (target % 64))); };
+
+     // Faces start at the near plane, targets closer to the eye are kept
+     const Aabb nearBox{
+          DirectX::XMFLOAT3(eye[0] - faceNear_, eye[1] - faceNear_, eye[2] - faceNear_),
+          DirectX::XMFLOAT3(eye[0] + faceNear_, eye[1] + faceNear_, eye[2] + faceNear_)};
+     for (std::size_t target = 0; target < targets.size(); ++target)
+          if (Intersects(targets[target], nearBox))
+               setVisible(target);
+
+     std::vector<DirectX::XMFLOAT3> corners(8 * occluders.size());
+     for (std::size_t i = 0; i < occluders.size(); ++i)
+          for (unsigned corner = 0; corner < 8; ++corner)
+               corners[i * 8 + corner] = DirectX::XMFLOAT3(
+                    corner & 1 ? occluders[i].max.x : occluders[i].min.x,
+                    corner & 2 ? occluders[i].max.y : occluders[i].min.y,
+                    corner & 4 ? occluders[i].max.z : occluders[i].min.z);
+
+     const DirectX::XMVECTOR eyePosition = DirectX::XMVectorSet(eye[0], eye[1], eye[2], 1.0f);
+     const DirectX::XMMATRIX proj = DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV2, 1.0f, faceFar, faceNear_);
+     for (int face = 0; face < 6; ++face)
+     {
+          // Face looks along sign of axis, 90 degree frustum holds points farther along it than aside
+          const int axis = face / 2;
+          const float sign = 0 == face % 2 ? 1.0f : -1.0f;
+          float direction[] = {0.0f, 0.0f, 0.0f};
+          direction[axis] = sign;
+          const DirectX::XMVECTOR up = 1 == axis ? DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+          const DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(
+               eyePosition,
+               DirectX::XMVectorAdd(eyePosition, DirectX::XMVectorSet(direction[0], direction[1], direction[2], 0.0f)),
+               up);
+
+          culler.Clear(DirectX::XMMatrixMultiply(view, proj));
+          for (std::size_t i = 0; i < occluders.size(); ++i)
+               culler.RenderOccluder(corners.data() + i * 8, 8, sizeof(DirectX::XMFLOAT3), boxIndices, 36, DirectX::XMMatrixIdentity());
+          culler.BuildHiZ();
+
+          for (std::size_t target = 0; target < targets.size(); ++target)
+          {
+               if (isVisible(target))
+                    continue;
+
+               // Part of target in front of the face near plane
+               float min[] = {targets[target].min.x, targets[target].min.y, targets[target].min.z};
+               float max[] = {targets[target].max.x, targets[target].max.y, targets[target].max.z};
+               if (sign > 0.0f)
+                    min[axis] = std::max(min[axis], eye[axis] + faceNear_);
+               else
+                    max[axis] = std::min(max[axis], eye[axis] - faceNear_);
+               if (min[axis] > max[axis])
+                    continue;
+
+               const float depth = sign > 0.0f ? max[axis] - eye[axis] : eye[axis] - min[axis];
+               bool inside = true;
+               for (int other = 0; other < 3 && inside; ++other)
+               {
+                    const float offset = std::max({0.0f, min[other] - eye[other], eye[other] - max[other]});
+                    inside = other == axis || offset <= depth;
+               }
+               if (inside && culler.CheckRectangle(min, max))
+                    setVisible(target);
+          }
+     }
+}
+
+std::size_t Pvs::GetObjectNumber() const
+{
+     return objectNumber_;
+}
+
+bool Pvs::DecodeCell(const DirectX::XMFLOAT3 &eye)
+{
+     if (cellSets_.empty() || !Contains(region_, eye))
+          return false;
+
+     const unsigned x = std::min(cellsX_ - 1, static_cast<unsigned>((eye.x - region_.min.x) / cellSize_));
+     const unsigned y = std::min(cellsY_ - 1, static_cast<unsigned>((eye.y - region_.min.y) / cellSize_));
+     const unsigned z = std::min(cellsZ_ - 1, static_cast<unsigned>((eye.z - region_.min.z) / cellSize_));
+     const std::size_t cell = (static_cast<std::size_t>(z) * cellsY_ + y) * cellsX_ + x;
+     if (cell == currentCell_)
+          return true;
+
+     currentCell_ = cell;
+     currentBits_.assign(wordNumber_, 0);
+     const std::uint32_t set = cellSets_[cell];
+     std::size_t word = 0;
+     for (std::size_t i = setOffsets_[set]; i < setOffsets_[set + 1]; i += 2)
+     {
+          word += static_cast<std::size_t>(data_[i]);
+          currentBits_[word++] = data_[i + 1];
+     }
+     return true;
+}
+
+std::size_t Pvs::Filter(const DirectX::XMFLOAT3 &eye, std::uint32_t *indices, const std::size_t count)
+{
+     if (!DecodeCell(eye))
+          return count;
+
+     std::size_t visibleNumber = 0;
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          const std::uint32_t index = indices[i];
+          if (index < objectNumber_ && 0 == (currentBits_[index / 64] & (std::uint64_t(1) << (index % 64))))
+               continue;
+          indices[visibleNumber++] = index;
+     }
+     return visibleNumber;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "bounding_volume.h"
+#include "occlusion_culler.h"
+#include "thread_pool.h"
+
+#include <directxmath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Potentially visible sets of static objects for a grid of camera cells. Visibility is baked
+// conservatively: occluders shrunk and targets grown by the cell half size are tested from the cell
+// center with a cube of conservative occlusion buffers, so occluders fuse and an object is removed
+// only if it is hidden from every point of the cell. Per cell bitsets are deduplicated and stored
+// with zero word run length encoding.
+class Pvs
+{
+public:
+     Pvs();
+     // occluders[i] must lie inside targets[i]: it is the part of object that always blocks view,
+     // while target is everything the object may ever cover. Occluders thinner than the cell are lost.
+     void Bake(
+          const Aabb &region,
+          const float cellSize,
+          const std::vector<Aabb> &occluders,
+          const std::vector<Aabb> &targets,
+          ThreadPool &threadPool);
+     std::size_t GetObjectNumber() const;
+     // Keeps entries of indices visible from the cell containing eye, returns their number.
+     // Nothing is removed when eye is outside of baked region.
+     std::size_t Filter(const DirectX::XMFLOAT3 &eye, std::uint32_t *indices, const std::size_t count);
+
+private:
+     static constexpr const unsigned faceSize_ = 128;
+     static constexpr const float faceNear_ = 0.01f;
+     static constexpr const std::size_t cellChunkSize_ = 16;
+
+     void BakeCell(
+          const std::size_t cell,
+          const std::vector<Aabb> &occluders,
+          const std::vector<Aabb> &targets,
+          const float faceFar,
+          OcclusionCuller &culler,
+          std::uint64_t *bits) const;
+     bool DecodeCell(const DirectX::XMFLOAT3 &eye);
+
+     Aabb region_;
+     float cellSize_;
+     unsigned cellsX_;
+     unsigned cellsY_;
+     unsigned cellsZ_;
+     std::size_t objectNumber_;
+     std::size_t wordNumber_;
+
+     std::vector<std::uint32_t> cellSets_;
+     std::vector<std::size_t> setOffsets_; // set i is encoded in data_[setOffsets_[i], setOffsets_[i + 1])
+     std::vector<std::uint64_t> data_; // pairs of zero words count and non zero word
+
+     std::size_t currentCell_;
+     std::vector<std::uint64_t> currentBits_;
+};
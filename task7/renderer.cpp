@@ -3,14 +3,14 @@
 
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
-#include <chrono>
 #include <string>
 #include <cmath>
+#include <algorithm>
+#include <thread>
 
 namespace
 {
 
-     constexpr const std::size_t maxCubeNumber = 100;
 
      struct Vertex
      {
@@ -29,28 +29,30 @@ namespace
      {
           DirectX::XMMATRIX viewProjMatrix;
           DirectX::XMINT4 indexBuffer;
-     };
-
-     struct GeomBuffer
-     {
-          DirectX::XMMATRIX worldMatrix;
-          DirectX::XMMATRIX norm;
-          DirectX::XMFLOAT4 shineSpeedTexIdNm;
+          DirectX::XMFLOAT4 time;
      };
 
      struct LightBuffer
      {
           DirectX::XMFLOAT4 cameraPosition;
           DirectX::XMINT4 lightCount;
-          DirectX::XMFLOAT4 lightPositions[maxLightNumber];
-          DirectX::XMFLOAT4 lightColors[maxLightNumber];
+          DirectX::XMFLOAT4 viewDepth;
+          DirectX::XMUINT4 clusterSize;
+          DirectX::XMFLOAT4 clusterScale;
           DirectX::XMFLOAT4 ambientColor;
      };
 
+     struct LightData
+     {
+          DirectX::XMFLOAT4 position;
+          DirectX::XMFLOAT4 color;
+     };
+
      struct TransparentWorldBuffer
      {
           DirectX::XMMATRIX worldMatrix;
           DirectX::XMFLOAT4 color;
+          DirectX::XMUINT4 packedLights;
      };
 
      HRESULT SetResourceName(ID3D11DeviceChild *pResource, const std::string &name)
@@ -91,12 +93,6 @@ namespace
           Vertex{{-0.5, 0.5, -0.5}, {0, 0}, {0, 0, -1}, {1, 0, 0}}
      };
 
-     const DirectX::XMFLOAT4 cubeAabb[] =
-     {
-          {-1.0f, -1.0f, -1.0f, 1.0f},
-          {1.0f, 1.0f, 1.0f, 1.0f}
-     };
-
      const std::array<USHORT, 36> cubeIndices =
      {
           0, 2, 1, 0, 3, 2,
@@ -120,6 +116,12 @@ namespace
           0, 2, 1, 0, 3, 2,
      };
 
+     const std::array<DirectX::XMFLOAT3, 2> coloredPlaneOffsets =
+     {
+          DirectX::XMFLOAT3{0.0f, 0.0f, -0.1f},
+          DirectX::XMFLOAT3{0.0f, 0.0f, 0.1f},
+     };
+
 }
 
 Renderer &Renderer::GetInstance() {
@@ -139,9 +141,6 @@ Renderer::Renderer() :
      pInputLayout_(NULL),
      pVertexBuffer_(NULL),
      pIndexBuffer_(NULL),
-     pGeomBuffer_(NULL),
-     pLightBuffer_(NULL),
-     pSceneBuffer_(NULL),
      pRasterizerState_(NULL),
      pDepthState_(NULL),
      pTransparentVertexShader_(NULL),
@@ -149,10 +148,6 @@ Renderer::Renderer() :
      pTransparentInputLayout_(NULL),
      pTransparentVertexBuffer_(NULL),
      pTransparentIndexBuffer_(NULL),
-     pTransparentWorldBuffer_(NULL),
-     pTransparentWorldBuffer1_(NULL),
-     pTransparentSceneBuffer_(NULL),
-     pTransparentLightBuffer_(NULL),
      pTransparentRasterizerState_(NULL),
      pTransparentDepthState_(NULL),
      pTransparentBlendState_(NULL),
@@ -162,12 +157,32 @@ Renderer::Renderer() :
      pLights_(nullptr),
      pRenderTexture_(nullptr),
      pPostEffect_(nullptr),
-     pFrustum_(nullptr),
+     pConstantBufferDevice_(nullptr),
+     pConstantBuffers_(nullptr),
+     pUploadRingBackend_(nullptr),
+     pUploadRing_(nullptr),
+     pStaticInstanceBuffer_(nullptr),
+     pLightDataBuffer_(nullptr),
+     pClusterRangeBuffer_(nullptr),
+     pClusterLightIndexBuffer_(nullptr),
+     pThreadPool_(nullptr),
+     pFrameBuilder_(nullptr),
      pCamera_(nullptr),
      pInput_(nullptr),
      width_(defaultWidth),
      height_(defaultHeight),
-     start_(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count())
+     simulationWidth_(defaultWidth),
+     simulationHeight_(defaultHeight),
+     simulatedFrameNumber_(0),
+     clock_(timeSource_, simulationStep_),
+     renderedCubeNumber_(0),
+     visibleEntryOffset_(0),
+     visibleLightOffset_(0),
+     sceneBlock_(ConstantBufferManager::invalidBlock),
+     lightBlock_(ConstantBufferManager::invalidBlock),
+     transparentWorldBlock_(ConstantBufferManager::invalidBlock),
+     transparentWorldBlock1_(ConstantBufferManager::invalidBlock),
+     frameArena_(frameArenaCapacity_)
 {
 }
 
@@ -184,10 +199,6 @@ void Renderer::CleanAll()
      SafeRelease(pTransparentBlendState_);
      SafeRelease(pTransparentDepthState_);
      SafeRelease(pTransparentRasterizerState_);
-     SafeRelease(pTransparentLightBuffer_);
-     SafeRelease(pTransparentSceneBuffer_);
-     SafeRelease(pTransparentWorldBuffer1_);
-     SafeRelease(pTransparentWorldBuffer_);
      SafeRelease(pTransparentIndexBuffer_);
      SafeRelease(pTransparentVertexBuffer_);
      SafeRelease(pTransparentInputLayout_);
@@ -195,9 +206,6 @@ void Renderer::CleanAll()
      SafeRelease(pTransparentVertexShader_);
      SafeRelease(pDepthState_);
      SafeRelease(pRasterizerState_);
-     SafeRelease(pSceneBuffer_);
-     SafeRelease(pLightBuffer_);
-     SafeRelease(pGeomBuffer_);
      SafeRelease(pIndexBuffer_);
      SafeRelease(pVertexBuffer_);
      SafeRelease(pInputLayout_);
@@ -215,6 +223,7 @@ bool Renderer::Init(const HWND hWnd, std::shared_ptr<Camera> pCamera, std::share
 {
      pCamera_ = pCamera;
      pInput_ = pInput;
+     clock_.SetVirtualFrameTime(virtualFrameTime_);
 
      // Create a DirectX graphics interface factory.​
      IDXGIFactory *pFactory = nullptr;
@@ -346,6 +355,8 @@ bool Renderer::Init(const HWND hWnd, std::shared_ptr<Camera> pCamera, std::share
           {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
           {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0},
           {"TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 32, D3D11_INPUT_PER_VERTEX_DATA, 0},
+          {"INSTANCE_ENTRY", 0, DXGI_FORMAT_R32_UINT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+          {"INSTANCE_LIGHTS", 0, DXGI_FORMAT_R32G32_UINT, 2, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1},
      };
      UINT numElements = ARRAYSIZE(layout);
 
@@ -426,34 +437,24 @@ bool Renderer::Init(const HWND hWnd, std::shared_ptr<Camera> pCamera, std::share
      if (FAILED(result))
           return false;
 
-     // Create const buffers
-     ZeroMemory(&desc, sizeof(desc));
-     desc.ByteWidth = sizeof(GeomBuffer) * maxCubeNumber;
-     desc.Usage = D3D11_USAGE_DEFAULT;
-     desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-     desc.CPUAccessFlags = 0;
-     desc.MiscFlags = 0;
-     desc.StructureByteStride = 0;
-     result = pDevice_->CreateBuffer(&desc, NULL, &pGeomBuffer_);
-     if (FAILED(result))
-     result = SetResourceName(pGeomBuffer_, "GeomBuffer");
-     if (FAILED(result))
-          return false;
+     cubeMeshBounds_ = ComputeMeshBounds(cubeVertices.data(), cubeVertices.size(), sizeof(Vertex));
+     planeMeshBounds_ = ComputeMeshBounds(coloredPlaneVertices.data(), coloredPlaneVertices.size(), sizeof(VertexPos));
 
-     desc.ByteWidth = sizeof(LightBuffer);
-     result = pDevice_->CreateBuffer(&desc, NULL, &pLightBuffer_);
-     if (FAILED(result))
-          return false;
-     result = SetResourceName(pLightBuffer_, "LightBuffer");
-     if (FAILED(result))
+     // Create const buffers, the transparent pass shares scene and light buffers
+     try
+     {
+          pConstantBufferDevice_ = std::make_shared<D3DConstantBufferDevice>(pDevice_, pDeviceContext_);
+          pConstantBuffers_ = std::make_shared<ConstantBufferManager>(*pConstantBufferDevice_);
+     }
+     catch (...)
+     {
           return false;
-
-     desc.ByteWidth = sizeof(SceneBuffer);
-     result = pDevice_->CreateBuffer(&desc, NULL, &pSceneBuffer_);
-     if (FAILED(result))
+     }
+     lightBlock_ = pConstantBuffers_->Register("LightBuffer", sizeof(LightBuffer));
+     if (ConstantBufferManager::invalidBlock == lightBlock_)
           return false;
-     result = SetResourceName(pSceneBuffer_, "SceneBuffer");
-     if (FAILED(result))
+     sceneBlock_ = pConstantBuffers_->Register("SceneBuffer", sizeof(SceneBuffer));
+     if (ConstantBufferManager::invalidBlock == sceneBlock_)
           return false;
 
      D3D11_RASTERIZER_DESC rasterizeDesc;
@@ -496,129 +497,116 @@ bool Renderer::Init(const HWND hWnd, std::shared_ptr<Camera> pCamera, std::share
           pCubeMap_ = std::make_shared<CubeMap>(pDevice_, pDeviceContext_, width_, height_, fov_, near_);
 
           pRenderTexture_ = std::make_shared<RenderTexture>(pDevice_, width_, height_);
-          pPostEffect_ = std::make_shared<PostEffect>(pDevice_, hWnd, width_, height_);
-          pFrustum_ = std::make_shared<Frustum>(near_);
-
-          pLights_ = std::make_shared<Lights>();
-          pLights_->Add(
-               {
-                    [](std::size_t milliseconds)
-                    {
-                         return DirectX::XMFLOAT4(0.0f, 1.5f, 2.0f * std::sin(milliseconds / 1000.0f), 0.0f);
-                    },
-                    [](std::size_t milliseconds)
-                    {
-                         return DirectX::XMFLOAT4(1.0f, 1.0f, std::sin(milliseconds / 100.0f), 1.0f);
-                    }
-               });
-          pLights_->Add(
-               {
-                    [](std::size_t milliseconds)
-                    {
-                         return DirectX::XMFLOAT4(0.0f, -1.5f, -2.0f * std::sin(milliseconds / 300.0f), 0.0f);
-                    },
-                    [](std::size_t milliseconds)
-                    {
-                         return DirectX::XMFLOAT4(1.0f, std::sin(milliseconds / 1000.0f), 1.0f, 1.0f);
-                    }
-               });
-          pLights_->Add(
-               {
-                    [](std::size_t milliseconds)
-                    {
-                         return DirectX::XMFLOAT4(-1.5f, 0.0f, -2.0f, 0.0f);
-                    },
-                    [](std::size_t milliseconds)
-                    {
-                         return DirectX::XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f);
-                    }
-               });
-          pLights_->Add(
-               {
-                    [](std::size_t milliseconds)
-                    {
-                         return DirectX::XMFLOAT4(1.5f, 0.0f, 2.0f, 0.0f);
-                    },
-                    [](std::size_t milliseconds)
-                    {
-                         return DirectX::XMFLOAT4(1.0f, 0.0f, 1.0f, 1.0f);
-                    }
-               });
-          pLights_->Add(
-               {
-                    [](std::size_t milliseconds)
-                    {
-                         return DirectX::XMFLOAT4(std::cos(milliseconds / 2000.0f), std::sin(milliseconds / 500.0f), 0.0f, 0.0f);
-                    },
-                    [](std::size_t milliseconds)
-                    {
-                         return DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-                    }
-               });
-          pLights_->Add(
-               {
-                    [](std::size_t milliseconds)
-                    {
-                         constexpr const float dist = 5;
-                         return DirectX::XMFLOAT4(
-                              dist * std::sin(milliseconds / 500.0f),
-                              1.5f,
-                              dist * std::cos(milliseconds / 500.0f),
-                              0.0f);
-                    },
-                    [](std::size_t milliseconds)
-                    {
-                         return DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-                    }
-               });
-
-          {
-               CubeModel cm;
-               cm.pos = DirectX::XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f);
-               cm.shineSpeedIdNm = DirectX::XMFLOAT4(300.0f, 1.0f, 0.0f, 1.0f);
-               cubes_.push_back(std::move(cm));
-          }
-          {
-               CubeModel cm;
-               cm.pos = DirectX::XMFLOAT4(0.0f, 0.0f, -1.0f, -3.0f);
-               cm.shineSpeedIdNm = DirectX::XMFLOAT4(200.0f, 1.0f, 1.0f, 0.0f);
-               cubes_.push_back(std::move(cm));
-          }
-          {
-               CubeModel cm;
-               cm.pos = DirectX::XMFLOAT4(0.0f, 0.0f, -2.5f, -0.5f);
-               cm.shineSpeedIdNm = DirectX::XMFLOAT4(200.0f, 1.0f, 2.0f, 1.0f);
-               cubes_.push_back(std::move(cm));
-          }
+          pPostEffect_ = std::make_shared<PostEffect>(pDevice_, *pConstantBuffers_, hWnd, width_, height_);
+          pLightDataBuffer_ = std::make_shared<InstanceBuffer>(pDevice_, static_cast<unsigned>(sizeof(LightData)), 1);
+          pClusterRangeBuffer_ = std::make_shared<InstanceBuffer>(
+               pDevice_,
+               static_cast<unsigned>(sizeof(ClusterRange)),
+               clusterTileNumberX_ * clusterTileNumberY_ * clusterSliceNumber_);
+          pClusterLightIndexBuffer_ = std::make_shared<InstanceBuffer>(pDevice_, static_cast<unsigned>(sizeof(std::uint32_t)), 1);
+          pUploadRingBackend_ = std::make_shared<D3DUploadRingBackend>(pDevice_, pDeviceContext_, D3D11_BIND_VERTEX_BUFFER, uploadRingCapacity_);
+          pUploadRing_ = std::make_shared<UploadRing>(*pUploadRingBackend_, uploadRingCapacity_);
+          pThreadPool_ = std::make_shared<ThreadPool>();
+          FrameBuilder::Settings frameSettings;
+          frameSettings.cullingMode = cullingMode_;
+          frameSettings.nearZ = near_;
+          frameSettings.fovY = fov_;
+          frameSettings.cullingChunkSize = cullingChunkSize_;
+          frameSettings.octreeHalfSize = octreeHalfSize_;
+          frameSettings.octreeDepth = octreeDepth_;
+          frameSettings.useContributionCulling = useContributionCulling_;
+          frameSettings.minPixelRadius = minCubePixelRadius_;
+          frameSettings.usePvs = usePvs_;
+          frameSettings.pvsCellSize = pvsCellSize_;
+          frameSettings.pvsMargin = pvsMargin_;
+          frameSettings.useOcclusionCulling = useOcclusionCulling_;
+          frameSettings.maxOccluderNumber = maxOccluderNumber_;
+          frameSettings.farZ = far_;
+          frameSettings.clusterTileNumberX = clusterTileNumberX_;
+          frameSettings.clusterTileNumberY = clusterTileNumberY_;
+          frameSettings.clusterSliceNumber = clusterSliceNumber_;
+          frameSettings.useInstanceLights = useInstanceLights_;
+          frameSettings.instanceChunkSize = instanceChunkSize_;
+          frameSettings.lightBvhRebuildPeriod = lightBvhRebuildPeriod_;
+          pFrameBuilder_ = std::make_shared<FrameBuilder>(frameSettings, *pThreadPool_, frameArena_);
+
+          pLights_ = std::make_shared<Lights>(maxLightNumber, lightCutoff_);
+          std::uint32_t light = pLights_->Add(DirectX::XMFLOAT4(0.0f, 1.5f, 0.0f, 0.0f), DirectX::XMFLOAT4(1.0f, 1.0f, 0.0f, 1.0f));
+          pLights_->AddSinusoid(light, Lights::Channel::PositionZ, 2.0f, 1.0f, 0.0f);
+          pLights_->AddSinusoid(light, Lights::Channel::ColorB, 1.0f, 10.0f, 0.0f);
+
+          light = pLights_->Add(DirectX::XMFLOAT4(0.0f, -1.5f, 0.0f, 0.0f), DirectX::XMFLOAT4(1.0f, 0.0f, 1.0f, 1.0f));
+          pLights_->AddSinusoid(light, Lights::Channel::PositionZ, -2.0f, 1000.0f / 300.0f, 0.0f);
+          pLights_->AddSinusoid(light, Lights::Channel::ColorG, 1.0f, 1.0f, 0.0f);
+
+          pLights_->Add(DirectX::XMFLOAT4(-1.5f, 0.0f, -2.0f, 0.0f), DirectX::XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f));
+          pLights_->Add(DirectX::XMFLOAT4(1.5f, 0.0f, 2.0f, 0.0f), DirectX::XMFLOAT4(1.0f, 0.0f, 1.0f, 1.0f));
+
+          light = pLights_->Add(DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f), DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+          pLights_->AddSinusoid(light, Lights::Channel::PositionX, 1.0f, 0.5f, DirectX::XM_PIDIV2);
+          pLights_->AddSinusoid(light, Lights::Channel::PositionY, 1.0f, 2.0f, 0.0f);
+
+          light = pLights_->Add(DirectX::XMFLOAT4(0.0f, 1.5f, 0.0f, 0.0f), DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+          pLights_->AddOrbit(light, 5.0f, 2.0f, 0.0f);
+
+          cubes_.Add(DirectX::XMFLOAT3(0.0f, 0.0f, 1.0f), 1.0f, 300.0f, 0, true);
+          cubes_.Add(DirectX::XMFLOAT3(0.0f, 0.0f, -1.0f), -3.0f, 200.0f, 1, false);
+          cubes_.Add(DirectX::XMFLOAT3(0.0f, 0.0f, -2.5f), -0.5f, 200.0f, 2, true);
 
           for (std::size_t i = 0; i < 5; ++i)
                for (std::size_t j = 0; j < 5; ++j)
                {
-                    CubeModel cm;
-                    cm.pos = DirectX::XMFLOAT4(
-                         3.0f + i * 1.5f,
-                         0.0f,
-                         -4.0f + j * 2.0f,
-                         static_cast<float>(rand() % 401 - 200) / 100);
+                    const float rotationSpeed = static_cast<float>(rand() % 401 - 200) / 100;
                     auto texId = std::rand() % 3;
-                    cm.shineSpeedIdNm = DirectX::XMFLOAT4(300.0f, 1.0f, static_cast<float>(texId), static_cast<float>(0 == texId));
-                    cubes_.push_back(std::move(cm));
+                    cubes_.Add(
+                         DirectX::XMFLOAT3(3.0f + i * 1.5f, 0.0f, -4.0f + j * 2.0f),
+                         rotationSpeed,
+                         300.0f,
+                         static_cast<std::uint32_t>(texId),
+                         0 == texId);
                }
 
           for (std::size_t i = 0; i < 10; ++i)
           {
                const float phi = i * DirectX::XM_PI / 9;
                constexpr const float dist = 5;
-               CubeModel cm;
-               cm.pos = DirectX::XMFLOAT4(
-                    -dist * std::sin(phi),
-                    0.0f,
-                    dist * std::cos(phi),
-                    static_cast<float>(rand() % 801 - 400) / 100);
+               const float rotationSpeed = static_cast<float>(rand() % 801 - 400) / 100;
                auto texId = std::rand() % 3;
-               cm.shineSpeedIdNm = DirectX::XMFLOAT4(300.0f, 1.0f, static_cast<float>(texId), static_cast<float>(0 == texId));
-               cubes_.push_back(std::move(cm));
+               cubes_.Add(
+                    DirectX::XMFLOAT3(-dist * std::sin(phi), 0.0f, dist * std::cos(phi)),
+                    rotationSpeed,
+                    300.0f,
+                    static_cast<std::uint32_t>(texId),
+                    0 == texId);
+          }
+
+          // Cube bounds, culling structures and the PVS are set up once, cubes are not added later
+          pFrameBuilder_->SetCubes(
+               cubes_,
+               cubeMeshBounds_,
+               cubeVertices.data(),
+               cubeVertices.size(),
+               sizeof(Vertex),
+               cubeIndices.data(),
+               cubeIndices.size());
+
+          // Spin is closed form, so cube parameters stay resident and the vertex shader computes world
+          // matrices from time, only indices of visible cubes are uploaded every frame
+          std::vector<SpinInstance> residentInstances(cubes_.GetSize());
+          for (std::size_t i = 0; i < residentInstances.size(); ++i)
+          {
+               residentInstances[i].placement = DirectX::XMFLOAT4(
+                    cubes_.GetPositions(0)[i],
+                    cubes_.GetPositions(1)[i],
+                    cubes_.GetPositions(2)[i],
+                    cubes_.GetRotationSpeeds()[i]);
+               residentInstances[i].material = PackMaterial(cubes_.GetTextureIds()[i], 0 != cubes_.GetNormalMaps()[i], cubes_.GetShininess()[i]);
           }
+          pStaticInstanceBuffer_ = std::make_shared<StaticInstanceBuffer>(
+               pDevice_,
+               static_cast<unsigned>(sizeof(SpinInstance)),
+               residentInstances.data(),
+               static_cast<unsigned>(residentInstances.size()));
      }
      catch (...)
      {
@@ -729,49 +717,11 @@ bool Renderer::Init(const HWND hWnd, std::shared_ptr<Camera> pCamera, std::share
           return false;
 
      // Create const buffers
-     ZeroMemory(&desc, sizeof(desc));
-     desc.ByteWidth = sizeof(TransparentWorldBuffer);
-     desc.Usage = D3D11_USAGE_DEFAULT;
-     desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-     desc.CPUAccessFlags = 0;
-     desc.MiscFlags = 0;
-     desc.StructureByteStride = 0;
-
-     result = pDevice_->CreateBuffer(&desc, NULL, &pTransparentWorldBuffer_);
-     if (FAILED(result))
-          return false;
-     result = SetResourceName(pTransparentWorldBuffer_, "TransparentWorldBuffer");
-     if (FAILED(result))
+     transparentWorldBlock_ = pConstantBuffers_->Register("TransparentWorldBuffer", sizeof(TransparentWorldBuffer));
+     if (ConstantBufferManager::invalidBlock == transparentWorldBlock_)
           return false;
-
-     result = pDevice_->CreateBuffer(&desc, NULL, &pTransparentWorldBuffer1_);
-     if (FAILED(result))
-          return false;
-     result = SetResourceName(pTransparentWorldBuffer1_, "TransparentWorldBuffer1");
-     if (FAILED(result))
-          return false;
-
-     ZeroMemory(&desc, sizeof(desc));
-     desc.ByteWidth = sizeof(SceneBuffer);
-     desc.Usage = D3D11_USAGE_DEFAULT;
-     desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-     desc.CPUAccessFlags = 0;
-     desc.MiscFlags = 0;
-     desc.StructureByteStride = 0;
-
-     result = pDevice_->CreateBuffer(&desc, NULL, &pTransparentSceneBuffer_);
-     if (FAILED(result))
-          return false;
-     result = SetResourceName(pTransparentSceneBuffer_, "TransparentSceneBuffer");
-     if (FAILED(result))
-          return false;
-
-     desc.ByteWidth = sizeof(LightBuffer);
-     result = pDevice_->CreateBuffer(&desc, NULL, &pTransparentLightBuffer_);
-     if (FAILED(result))
-          return false;
-     result = SetResourceName(pTransparentLightBuffer_, "TransparentLightBuffer");
-     if (FAILED(result))
+     transparentWorldBlock1_ = pConstantBuffers_->Register("TransparentWorldBuffer1", sizeof(TransparentWorldBuffer));
+     if (ConstantBufferManager::invalidBlock == transparentWorldBlock1_)
           return false;
 
      ZeroMemory(&rasterizeDesc, sizeof(rasterizeDesc));
@@ -827,83 +777,163 @@ bool Renderer::Init(const HWND hWnd, std::shared_ptr<Camera> pCamera, std::share
 
 bool Renderer::Update()
 {
+     // Render has not taken the previous packet yet, simulating another one would only replace it
+     if (!framePackets_.IsConsumed())
+     {
+          std::this_thread::yield();
+          return true;
+     }
+
+     frameArena_.Reset();
      pInput_->Update();
      pCamera_->Update(pInput_->GetMouseState());
 
-     std::size_t countSec =
-          std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() - start_;
-     double angle = static_cast<float>(countSec) / 1000.0f;
+     // P pauses, minus and equals halve and double the time scale, V toggles potentially visible sets
+     if (pInput_->IsKeyPressed(DIK_V))
+          pFrameBuilder_->SetPvsEnabled(!pFrameBuilder_->IsPvsEnabled());
+     if (pInput_->IsKeyPressed(DIK_P))
+          clock_.SetPaused(!clock_.IsPaused());
+     if (pInput_->IsKeyPressed(DIK_MINUS))
+          clock_.SetTimeScale(std::max(minTimeScale_, clock_.GetTimeScale() * 0.5));
+     if (pInput_->IsKeyPressed(DIK_EQUALS))
+          clock_.SetTimeScale(std::min(maxTimeScale_, clock_.GetTimeScale() * 2.0));
+
+     // Animations are closed form, so they are evaluated at the interpolated time instead of stepped
+     clock_.Tick();
+     const double angle = clock_.GetInterpolatedTime();
+
+     FramePacket &packet = framePackets_.GetWriteSlot();
+     packet.frameIndex = ++simulatedFrameNumber_;
+     packet.width = simulationWidth_.load(std::memory_order_relaxed);
+     packet.height = simulationHeight_.load(std::memory_order_relaxed);
+
+     const auto view = pCamera_->GetView();
+     const auto proj = DirectX::XMMatrixPerspectiveFovLH(fov_, packet.width / static_cast<float>(packet.height), far_, near_);
+     DirectX::XMStoreFloat4x4(&packet.view, view);
+     DirectX::XMStoreFloat4x4(&packet.proj, proj);
+     packet.pov = pCamera_->GetPov();
+     packet.time = angle;
+
+     // Cubes stay resident and spin in the vertex shader, so only their indices are uploaded
+     pFrameBuilder_->BuildEntries(packet);
+
+     // Transparent planes are lit by their strongest lights as well
+     std::array<Sphere, 2> planeSpheres;
+     for (std::size_t i = 0; i < planeSpheres.size(); ++i)
+     {
+          planeSpheres[i].center = DirectX::XMFLOAT3(
+               coloredPlaneOffsets[i].x + planeMeshBounds_.sphere.center.x,
+               coloredPlaneOffsets[i].y + planeMeshBounds_.sphere.center.y,
+               coloredPlaneOffsets[i].z + planeMeshBounds_.sphere.center.z);
+          planeSpheres[i].radius = planeMeshBounds_.sphere.radius;
+     }
+     pFrameBuilder_->BuildLights(packet, *pLights_, planeSpheres.data(), planeSpheres.size());
+
+     framePackets_.Publish();
+     return true;
+}
+
+bool Renderer::Upload(const FramePacket &packet)
+{
+     pConstantBuffers_->ResetStatistics();
+     pUploadRing_->BeginFrame();
 
      TransparentWorldBuffer transparentWorldBuffer;
-     transparentWorldBuffer.worldMatrix = DirectX::XMMatrixTranslation(0.0f, 0.0f, -0.1f);
+     transparentWorldBuffer.worldMatrix = DirectX::XMMatrixTranslation(coloredPlaneOffsets[0].x, coloredPlaneOffsets[0].y, coloredPlaneOffsets[0].z);
      transparentWorldBuffer.color = DirectX::XMFLOAT4(1.0f, 1.0f, 0.0f, 0.5f);
-     pDeviceContext_->UpdateSubresource(pTransparentWorldBuffer_, 0, NULL, &transparentWorldBuffer, 0, 0);
+     transparentWorldBuffer.packedLights = DirectX::XMUINT4(packet.planeLights[0].words[0], packet.planeLights[0].words[1], 0, 0);
+     pConstantBuffers_->Write(transparentWorldBlock_, transparentWorldBuffer);
 
-     transparentWorldBuffer.worldMatrix = DirectX::XMMatrixTranslation(0.0f, 0.0f, 0.1f);
+     transparentWorldBuffer.worldMatrix = DirectX::XMMatrixTranslation(coloredPlaneOffsets[1].x, coloredPlaneOffsets[1].y, coloredPlaneOffsets[1].z);
      transparentWorldBuffer.color = DirectX::XMFLOAT4(0.0f, 1.0f, 1.0f, 0.5f);
-     pDeviceContext_->UpdateSubresource(pTransparentWorldBuffer1_, 0, NULL, &transparentWorldBuffer, 0, 0);
+     transparentWorldBuffer.packedLights = DirectX::XMUINT4(packet.planeLights[1].words[0], packet.planeLights[1].words[1], 0, 0);
+     pConstantBuffers_->Write(transparentWorldBlock1_, transparentWorldBuffer);
 
+     const auto view = DirectX::XMLoadFloat4x4(&packet.view);
+     const auto proj = DirectX::XMLoadFloat4x4(&packet.proj);
+     renderedCubeNumber_ = packet.visibleEntries.size();
      SceneBuffer sceneBuffer;
-     const auto view = pCamera_->GetView();
-     const auto proj = DirectX::XMMatrixPerspectiveFovLH(fov_, width_ / static_cast<float>(height_), far_, near_);
      sceneBuffer.viewProjMatrix = DirectX::XMMatrixMultiply(view, proj);
-     pFrustum_->Construct(view, proj);
-     cubesToRender_.clear();
-     cubesToRender_.reserve(maxCubeNumber);
-     std::vector<DirectX::XMMATRIX> worldMatrices;
-     worldMatrices.reserve(maxCubeNumber);
-     for (std::size_t i = 0; i < cubes_.size(); ++i)
-     {
-          DirectX::XMMATRIX world =
-               DirectX::XMMatrixRotationY(static_cast<float>(cubes_[i].pos.w * angle * cubes_[i].shineSpeedIdNm.y)) *
-               DirectX::XMMatrixTranslation(cubes_[i].pos.x, cubes_[i].pos.y, cubes_[i].pos.z);
-          DirectX::XMFLOAT4 min;
-          XMStoreFloat4(&min, DirectX::XMVector4Transform(XMLoadFloat4(&(cubeAabb[0])), world));
-          DirectX::XMFLOAT4 max;
-          XMStoreFloat4(&max, DirectX::XMVector4Transform(XMLoadFloat4(&(cubeAabb[1])), world));
-          if (pFrustum_->CheckRectangle(max.x, max.y, max.z, min.x, min.y, min.z))
-          {
-               worldMatrices.push_back(std::move(world));
-               cubesToRender_.push_back(cubes_[i]);
-          }
-     }
-     sceneBuffer.indexBuffer = DirectX::XMINT4(static_cast<int>(cubesToRender_.size()), 0, 0, 0);
-     pDeviceContext_->UpdateSubresource(pSceneBuffer_, 0, NULL, &sceneBuffer, 0, 0);
-     pDeviceContext_->UpdateSubresource(pTransparentSceneBuffer_, 0, NULL, &sceneBuffer, 0, 0);
+     sceneBuffer.indexBuffer = DirectX::XMINT4(static_cast<int>(renderedCubeNumber_), 0, 0, 0);
+     sceneBuffer.time = DirectX::XMFLOAT4(static_cast<float>(packet.time), 0.0f, 0.0f, 0.0f);
+     pConstantBuffers_->Write(sceneBlock_, sceneBuffer);
 
-     GeomBuffer geomBuffer[maxCubeNumber];
-     for (std::size_t i = 0; i < cubesToRender_.size(); ++i)
-     {
-          geomBuffer[i].worldMatrix = worldMatrices[i];
-          geomBuffer[i].norm = geomBuffer[i].worldMatrix;
-          geomBuffer[i].shineSpeedTexIdNm = cubesToRender_[i].shineSpeedIdNm;
-     }
-     pDeviceContext_->UpdateSubresource(pGeomBuffer_, 0, NULL, &geomBuffer, 0, 0);
+     std::uint32_t *visibleEntries = pUploadRing_->Allocate<std::uint32_t>(renderedCubeNumber_, visibleEntryOffset_);
+     if (nullptr == visibleEntries)
+          return false;
+     std::copy(packet.visibleEntries.begin(), packet.visibleEntries.end(), visibleEntries);
+     PackedLightIndices *visibleLights = pUploadRing_->Allocate<PackedLightIndices>(renderedCubeNumber_, visibleLightOffset_);
+     if (nullptr == visibleLights)
+          return false;
+     std::copy(packet.visibleLights.begin(), packet.visibleLights.end(), visibleLights);
+     pUploadRing_->Unmap();
 
+     const LightClusterer &lightClusterer = pFrameBuilder_->GetLightClusterer();
      LightBuffer lightBuffer;
-     const auto pov = pCamera_->GetPov();
-     lightBuffer.cameraPosition.x = pov.x;
-     lightBuffer.cameraPosition.y = pov.y;
-     lightBuffer.cameraPosition.z = pov.z;
-     lightBuffer.lightCount.x = static_cast<int>(pLights_->GetNumber());
+     lightBuffer.cameraPosition.x = packet.pov.x;
+     lightBuffer.cameraPosition.y = packet.pov.y;
+     lightBuffer.cameraPosition.z = packet.pov.z;
+     lightBuffer.lightCount.x = static_cast<int>(packet.lightPositions.size());
      lightBuffer.lightCount.y = showNormalMap_;
      lightBuffer.lightCount.z = showNormals_;
-     auto lightPositions = pLights_->GetPositions(countSec);
-     std::copy(lightPositions.begin(), lightPositions.end(), lightBuffer.lightPositions);
-     auto lightColors = pLights_->GetColors(countSec);
-     std::copy(lightColors.begin(), lightColors.end(), lightBuffer.lightColors);
+     lightBuffer.lightCount.w = useInstanceLights_;
+     lightBuffer.viewDepth = DirectX::XMFLOAT4(packet.view._13, packet.view._23, packet.view._33, packet.view._43);
+     lightBuffer.clusterSize = DirectX::XMUINT4(lightClusterer.GetTileNumberX(), lightClusterer.GetTileNumberY(), lightClusterer.GetSliceNumber(), 0);
+     lightBuffer.clusterScale = DirectX::XMFLOAT4(
+          lightClusterer.GetTileNumberX() / static_cast<float>(packet.width),
+          lightClusterer.GetTileNumberY() / static_cast<float>(packet.height),
+          lightClusterer.GetSliceScale(),
+          lightClusterer.GetSliceBias());
      lightBuffer.ambientColor = ambientColor_;
-     pDeviceContext_->UpdateSubresource(pLightBuffer_, 0, NULL, &lightBuffer, 0, 0);
-     pDeviceContext_->UpdateSubresource(pTransparentLightBuffer_, 0, NULL, &lightBuffer, 0, 0);
+     pConstantBuffers_->Write(lightBlock_, lightBuffer);
+
+     const std::size_t lightNumber = packet.lightPositions.size();
+     LightData *lightData = static_cast<LightData *>(pLightDataBuffer_->Map(pDeviceContext_, static_cast<unsigned>(lightNumber)));
+     if (nullptr == lightData)
+          return false;
+     for (std::size_t i = 0; i < lightNumber; ++i)
+          lightData[i] = {packet.lightPositions[i], packet.lightColors[i]};
+     pLightDataBuffer_->Unmap(pDeviceContext_);
+
+     if (!useInstanceLights_)
+     {
+          ClusterRange *clusterRanges = static_cast<ClusterRange *>(
+               pClusterRangeBuffer_->Map(pDeviceContext_, static_cast<unsigned>(packet.clusterRanges.size())));
+          if (nullptr == clusterRanges)
+               return false;
+          std::copy(packet.clusterRanges.begin(), packet.clusterRanges.end(), clusterRanges);
+          pClusterRangeBuffer_->Unmap(pDeviceContext_);
+
+          std::uint32_t *clusterLightIndices = static_cast<std::uint32_t *>(
+               pClusterLightIndexBuffer_->Map(pDeviceContext_, static_cast<unsigned>(packet.clusterLightIndices.size())));
+          if (nullptr == clusterLightIndices)
+               return false;
+          std::copy(packet.clusterLightIndices.begin(), packet.clusterLightIndices.end(), clusterLightIndices);
+          pClusterLightIndexBuffer_->Unmap(pDeviceContext_);
+     }
 
-     pCubeMap_->Update(view, proj, pov);
+     pCubeMap_->Update(view, proj, packet.pov);
+     pConstantBuffers_->Flush();
 
      return true;
 }
 
+const ConstantBufferManager::Statistics &Renderer::GetConstantBufferStatistics() const
+{
+     return pConstantBuffers_->GetStatistics();
+}
+
 bool Renderer::Render()
 {
+     // Nothing new from the simulation thread, the previous frame stays on screen
+     if (!framePackets_.Acquire())
+     {
+          std::this_thread::yield();
+          return true;
+     }
      pDeviceContext_->ClearState();
+     if (!Upload(framePackets_.GetReadSlot()))
+          return false;
 
      D3D11_VIEWPORT viewport;
      viewport.TopLeftX = 0;
@@ -927,29 +957,37 @@ bool Renderer::Render()
      pDeviceContext_->RSSetState(pRasterizerState_);
      pDeviceContext_->OMSetDepthStencilState(pDepthState_, 0);
 
+     ID3D11Buffer *pSceneBuffer = D3DConstantBufferDevice::GetD3DBuffer(pConstantBuffers_->GetBuffer(sceneBlock_));
+     ID3D11Buffer *pLightBuffer = D3DConstantBufferDevice::GetD3DBuffer(pConstantBuffers_->GetBuffer(lightBlock_));
+
      ID3D11SamplerState *samplers[] = {pCubeTexture_->GetSampler(), pCubeNormalMap_->GetSampler()};
      pDeviceContext_->PSSetSamplers(0, 2, samplers);
 
      ID3D11ShaderResourceView *resources[] = {pCubeTexture_->GetTextures(), pCubeNormalMap_->GetTexture()};
      pDeviceContext_->PSSetShaderResources(0, 2, resources);
+     ID3D11ShaderResourceView *lightResources[] = {
+          pLightDataBuffer_->GetSRV(),
+          pClusterRangeBuffer_->GetSRV(),
+          pClusterLightIndexBuffer_->GetSRV()};
+     pDeviceContext_->PSSetShaderResources(5, 3, lightResources);
 
      pDeviceContext_->IASetIndexBuffer(pIndexBuffer_, DXGI_FORMAT_R16_UINT, 0);
-     ID3D11Buffer *vertexBuffers1[] = {pVertexBuffer_};
-     UINT strides1[] = {sizeof(Vertex)};
-     UINT offsets1[] = {0};
-     pDeviceContext_->IASetVertexBuffers(0, 1, vertexBuffers1, strides1, offsets1);
+     ID3D11Buffer *vertexBuffers1[] = {pVertexBuffer_, pUploadRingBackend_->GetBuffer(), pUploadRingBackend_->GetBuffer()};
+     UINT strides1[] = {sizeof(Vertex), sizeof(std::uint32_t), sizeof(PackedLightIndices)};
+     UINT offsets1[] = {0, visibleEntryOffset_, visibleLightOffset_};
+     pDeviceContext_->IASetVertexBuffers(0, 3, vertexBuffers1, strides1, offsets1);
      pDeviceContext_->IASetInputLayout(pInputLayout_);
      pDeviceContext_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
      pDeviceContext_->VSSetShader(pVertexShader_, NULL, 0);
-     pDeviceContext_->VSSetConstantBuffers(0, 1, &pGeomBuffer_);
-     pDeviceContext_->VSSetConstantBuffers(1, 1, &pSceneBuffer_);
+     ID3D11ShaderResourceView *pInstanceResource = pStaticInstanceBuffer_->GetSRV();
+     pDeviceContext_->VSSetShaderResources(2, 1, &pInstanceResource);
+     pDeviceContext_->VSSetConstantBuffers(1, 1, &pSceneBuffer);
      pDeviceContext_->PSSetShader(pPixelShader_, NULL, 0);
-     pDeviceContext_->PSSetConstantBuffers(0, 1, &pGeomBuffer_);
-     pDeviceContext_->PSSetConstantBuffers(1, 1, &pSceneBuffer_);
-     pDeviceContext_->PSSetConstantBuffers(2, 1, &pLightBuffer_);
+     pDeviceContext_->PSSetConstantBuffers(1, 1, &pSceneBuffer);
+     pDeviceContext_->PSSetConstantBuffers(2, 1, &pLightBuffer);
      pDeviceContext_->DrawIndexedInstanced(
           static_cast<UINT>(cubeIndices.size()),
-          static_cast<UINT>(cubesToRender_.size()),
+          static_cast<UINT>(renderedCubeNumber_),
           0,
           0,
           0);
@@ -969,16 +1007,18 @@ bool Renderer::Render()
      pDeviceContext_->OMSetBlendState(pTransparentBlendState_, NULL, 0xFFFFFFFF);
      pDeviceContext_->OMSetDepthStencilState(pTransparentDepthState_, 0);
 
-     pDeviceContext_->VSSetConstantBuffers(1, 1, &pTransparentSceneBuffer_);
-     pDeviceContext_->VSSetConstantBuffers(2, 1, &pTransparentLightBuffer_);
+     pDeviceContext_->VSSetConstantBuffers(1, 1, &pSceneBuffer);
+     pDeviceContext_->VSSetConstantBuffers(2, 1, &pLightBuffer);
      pDeviceContext_->PSSetShader(pTransparentPixelShader_, NULL, 0);
 
-     pDeviceContext_->VSSetConstantBuffers(0, 1, &pTransparentWorldBuffer_);
-     pDeviceContext_->PSSetConstantBuffers(0, 1, &pTransparentWorldBuffer_);
+     ID3D11Buffer *pTransparentWorldBuffer = D3DConstantBufferDevice::GetD3DBuffer(pConstantBuffers_->GetBuffer(transparentWorldBlock_));
+     pDeviceContext_->VSSetConstantBuffers(0, 1, &pTransparentWorldBuffer);
+     pDeviceContext_->PSSetConstantBuffers(0, 1, &pTransparentWorldBuffer);
      pDeviceContext_->DrawIndexed(static_cast<UINT>(coloredPlaneIndices.size()), 0, 0);
 
-     pDeviceContext_->VSSetConstantBuffers(0, 1, &pTransparentWorldBuffer1_);
-     pDeviceContext_->PSSetConstantBuffers(0, 1, &pTransparentWorldBuffer1_);
+     ID3D11Buffer *pTransparentWorldBuffer1 = D3DConstantBufferDevice::GetD3DBuffer(pConstantBuffers_->GetBuffer(transparentWorldBlock1_));
+     pDeviceContext_->VSSetConstantBuffers(0, 1, &pTransparentWorldBuffer1);
+     pDeviceContext_->PSSetConstantBuffers(0, 1, &pTransparentWorldBuffer1);
      pDeviceContext_->DrawIndexed(static_cast<UINT>(coloredPlaneIndices.size()), 0, 0);
 
      ID3D11RenderTargetView *views[] = {pBackBufferRTV_};
@@ -989,6 +1029,7 @@ bool Renderer::Render()
      pDeviceContext_->ClearDepthStencilView(pDepthBufferDSV_, D3D11_CLEAR_DEPTH, 0.0f, 0);
 
     pPostEffect_->Process(pDeviceContext_, pRenderTexture_->GetSRV(), pBackBufferRTV_, viewport);
+     pUploadRing_->EndFrame();
 
      HRESULT result = pSwapChain_->Present(0, 0);
      if (!SUCCEEDED(result))
@@ -1048,6 +1089,8 @@ bool Renderer::Resize(const unsigned width, const unsigned height)
 
      width_ = width;
      height_ = height;
+     simulationWidth_.store(width, std::memory_order_relaxed);
+     simulationHeight_.store(height, std::memory_order_relaxed);
 
      pCubeMap_->Resize(width, height);
      pRenderTexture_->Resize(width, height);
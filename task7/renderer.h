@@ -8,14 +8,32 @@
 #include "lights.h"
 #include "render_texture.h"
 #include "post_effect.h"
+#include "frame_arena.h"
+#include "frame_builder.h"
+#include "frame_packet.h"
 #include "frustum.h"
+#include "instance_buffer.h"
+#include "instance_storage.h"
+#include "instance_transform.h"
+#include "constant_buffer_manager.h"
+#include "d3d_constant_buffer_device.h"
+#include "d3d_upload_ring_backend.h"
+#include "bounding_volume.h"
+#include "simulation_clock.h"
+#include "static_instance_buffer.h"
+#include "thread_pool.h"
+#include "triple_buffer.h"
+#include "upload_ring.h"
 
 #include <d3d11.h>
 #include <dxgi.h>
 #include <directxmath.h>
 #include <windows.h>
 #include <array>
+#include <atomic>
 #include <memory>
+#include <vector>
+#include <cstdint>
 
 class Renderer
 {
@@ -28,9 +46,13 @@ public:
      void CleanAll();
 
      bool Init(const HWND hWnd, std::shared_ptr<Camera> pCamera, std::shared_ptr<Input> pInput);
+     // Simulation thread: input, culling and instance packing, publishes a frame packet
      bool Update();
+     // Render thread: uploads the latest frame packet and draws it, also owns Resize
      bool Render();
      bool Resize(const unsigned width, const unsigned height);
+     // Constant buffer traffic of the last Update
+     const ConstantBufferManager::Statistics &GetConstantBufferStatistics() const;
 
      static constexpr const unsigned defaultWidth = 1280;
      static constexpr const unsigned defaultHeight = 720;
@@ -48,8 +70,40 @@ private:
 
      static constexpr const bool showNormalMap_ = true;
      static constexpr const bool showNormals_ = false;
+     static constexpr const FrameBuilder::CullingMode cullingMode_ = FrameBuilder::CullingMode::Bvh;
+     static constexpr const float octreeHalfSize_ = 32.0f;
+     static constexpr const unsigned octreeDepth_ = 4;
+     static constexpr const bool useContributionCulling_ = true;
+     static constexpr const float minCubePixelRadius_ = 1.0f;
+     // Conservative bake only keeps occluder parts thicker than a cell, spinning cubes have small ones,
+     // so the sets remove little here for the bake time they take. V toggles them at runtime.
+     static constexpr const bool usePvs_ = false;
+     static constexpr const float pvsCellSize_ = 0.5f;
+     static constexpr const float pvsMargin_ = 4.0f;
+     static constexpr const bool useOcclusionCulling_ = true;
+     static constexpr const std::size_t maxOccluderNumber_ = 16;
+     static constexpr const std::size_t cullingChunkSize_ = 1024;
+     static constexpr const std::size_t instanceChunkSize_ = 256;
+     static constexpr const std::size_t frameArenaCapacity_ = 1 << 20;
+     static constexpr const double simulationStep_ = 1.0 / 60.0;
+     // Non-zero value advances time by this amount every frame, for reproducible benchmarks
+     static constexpr const double virtualFrameTime_ = 0.0;
+     static constexpr const double minTimeScale_ = 1.0 / 16.0;
+     static constexpr const double maxTimeScale_ = 16.0;
+     static constexpr const unsigned uploadRingCapacity_ = 1 << 20;
+     static constexpr const unsigned clusterTileNumberX_ = 16;
+     static constexpr const unsigned clusterTileNumberY_ = 9;
+     static constexpr const unsigned clusterSliceNumber_ = 24;
+     // Light influence radius is where 1 / d^2 attenuated color drops to this, falloff is windowed to reach zero there
+     static constexpr const float lightCutoff_ = 1.0f / 256.0f;
+     // Cubes and transparent planes shade with their strongest lights picked on CPU, light clusters are
+     // then neither built nor uploaded
+     static constexpr const bool useInstanceLights_ = true;
+     // Refits follow animated lights but loosen the light hierarchy, so it is rebuilt with this period in frames
+     static constexpr const std::uint64_t lightBvhRebuildPeriod_ = 64;
 
      Renderer();
+     bool Upload(const FramePacket &packet);
 
      ID3D11Device *pDevice_;
      ID3D11DeviceContext *pDeviceContext_;
@@ -63,9 +117,6 @@ private:
      ID3D11InputLayout *pInputLayout_;
      ID3D11Buffer *pVertexBuffer_;
      ID3D11Buffer *pIndexBuffer_;
-     ID3D11Buffer *pGeomBuffer_;
-     ID3D11Buffer *pLightBuffer_;
-     ID3D11Buffer *pSceneBuffer_;
      ID3D11RasterizerState *pRasterizerState_;
      ID3D11DepthStencilState *pDepthState_;
 
@@ -74,10 +125,6 @@ private:
      ID3D11InputLayout *pTransparentInputLayout_;
      ID3D11Buffer *pTransparentVertexBuffer_;
      ID3D11Buffer *pTransparentIndexBuffer_;
-     ID3D11Buffer *pTransparentWorldBuffer_;
-     ID3D11Buffer *pTransparentWorldBuffer1_;
-     ID3D11Buffer *pTransparentLightBuffer_;
-     ID3D11Buffer *pTransparentSceneBuffer_;
      ID3D11RasterizerState *pTransparentRasterizerState_;
      ID3D11DepthStencilState *pTransparentDepthState_;
      ID3D11BlendState *pTransparentBlendState_;
@@ -88,21 +135,42 @@ private:
      std::shared_ptr<Lights> pLights_;
      std::shared_ptr<RenderTexture> pRenderTexture_;
      std::shared_ptr<PostEffect> pPostEffect_;
-     std::shared_ptr<Frustum> pFrustum_;
+     std::shared_ptr<D3DConstantBufferDevice> pConstantBufferDevice_;
+     std::shared_ptr<ConstantBufferManager> pConstantBuffers_;
+     std::shared_ptr<D3DUploadRingBackend> pUploadRingBackend_;
+     std::shared_ptr<UploadRing> pUploadRing_;
+     std::shared_ptr<StaticInstanceBuffer> pStaticInstanceBuffer_;
+     std::shared_ptr<InstanceBuffer> pLightDataBuffer_;
+     std::shared_ptr<InstanceBuffer> pClusterRangeBuffer_;
+     std::shared_ptr<InstanceBuffer> pClusterLightIndexBuffer_;
+     std::shared_ptr<ThreadPool> pThreadPool_;
+     std::shared_ptr<FrameBuilder> pFrameBuilder_;
 
      std::shared_ptr<Camera> pCamera_;
      std::shared_ptr<Input> pInput_;
 
      unsigned width_;
      unsigned height_;
-
-     std::size_t start_;
-
-     struct CubeModel
-     {
-          DirectX::XMFLOAT4 pos;
-          DirectX::XMFLOAT4 shineSpeedIdNm;
-     };
-     std::vector<CubeModel> cubes_;
-     std::vector<CubeModel> cubesToRender_;
+     // Size seen by the simulation thread, written by Resize on the render thread
+     std::atomic<unsigned> simulationWidth_;
+     std::atomic<unsigned> simulationHeight_;
+     std::uint64_t simulatedFrameNumber_;
+
+     SteadyTimeSource timeSource_;
+     SimulationClock clock_;
+     std::size_t renderedCubeNumber_;
+     unsigned visibleEntryOffset_;
+     unsigned visibleLightOffset_;
+     ConstantBufferManager::Block sceneBlock_;
+     ConstantBufferManager::Block lightBlock_;
+     ConstantBufferManager::Block transparentWorldBlock_;
+     ConstantBufferManager::Block transparentWorldBlock1_;
+     FrameArena frameArena_;
+
+     MeshBounds cubeMeshBounds_;
+     MeshBounds planeMeshBounds_;
+     InstanceStorage cubes_;
+
+
+     TripleBuffer<FramePacket> framePackets_;
 };
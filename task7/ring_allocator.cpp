@@ -0,0 +1,105 @@
+#include "ring_allocator.h"
+
+namespace
+{
+
+     std::size_t Align(const std::size_t value, const std::size_t alignment)
+     {
+          return (value + alignment - 1) & ~(alignment - 1);
+     }
+
+}
+
+RingAllocator::RingAllocator(const std::size_t capacity) :
+     capacity_(capacity), head_(0), tail_(0), used_(0), frameUsed_(0)
+{
+}
+
+std::size_t RingAllocator::Allocate(const std::size_t size, const std::size_t alignment)
+{
+     if (0 == used_)
+     {
+          head_ = 0;
+          tail_ = 0;
+     }
+     else if (used_ == capacity_)
+     {
+          return invalidOffset;
+     }
+
+     std::size_t offset = Align(head_, alignment);
+     std::size_t consumed = 0;
+     if (head_ >= tail_)
+     {
+          // Free space is [head, capacity) and [0, tail)
+          if (offset + size <= capacity_)
+               consumed = offset + size - head_;
+          else if (size <= tail_)
+          {
+               consumed = capacity_ - head_ + size;
+               offset = 0;
+          }
+          else
+               return invalidOffset;
+     }
+     else
+     {
+          if (offset + size > tail_)
+               return invalidOffset;
+          consumed = offset + size - head_;
+     }
+
+     head_ = offset + size;
+     if (head_ == capacity_)
+          head_ = 0;
+     used_ += consumed;
+     frameUsed_ += consumed;
+     return offset;
+}
+
+void RingAllocator::FinishFrame(const std::uint64_t fence)
+{
+     if (0 == frameUsed_)
+          return;
+     frames_.push_back(Frame{fence, head_, frameUsed_});
+     frameUsed_ = 0;
+}
+
+void RingAllocator::Release(const std::uint64_t completedFence)
+{
+     while (!frames_.empty() && frames_.front().fence <= completedFence)
+     {
+          tail_ = frames_.front().end;
+          used_ -= frames_.front().size;
+          frames_.pop_front();
+     }
+}
+
+void RingAllocator::Reset()
+{
+     head_ = 0;
+     tail_ = 0;
+     used_ = 0;
+     frameUsed_ = 0;
+     frames_.clear();
+}
+
+std::size_t RingAllocator::GetCapacity() const
+{
+     return capacity_;
+}
+
+std::size_t RingAllocator::GetUsed() const
+{
+     return used_;
+}
+
+std::size_t RingAllocator::GetFrameUsed() const
+{
+     return frameUsed_;
+}
+
+std::size_t RingAllocator::GetPendingFrameNumber() const
+{
+     return frames_.size();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Offsets in a ring of capacity bytes for data produced every frame. Allocations of a frame are tagged
+// with the fence signaled after it and stay in use until that fence is completed, so the GPU never reads
+// a region which is being overwritten.
+class RingAllocator
+{
+public:
+     static constexpr const std::size_t invalidOffset = SIZE_MAX;
+
+     RingAllocator(const std::size_t capacity);
+     // Returns invalidOffset if there is no free region, alignment must be a power of two
+     std::size_t Allocate(const std::size_t size, const std::size_t alignment);
+     // Tags allocations made since the previous call with the fence
+     void FinishFrame(const std::uint64_t fence);
+     // Frees regions of frames whose fences are not greater than completed one
+     void Release(const std::uint64_t completedFence);
+     // Forgets every allocation, for use after the whole buffer is discarded
+     void Reset();
+     std::size_t GetCapacity() const;
+     // Bytes in use including alignment padding and skipped ring end
+     std::size_t GetUsed() const;
+     std::size_t GetFrameUsed() const;
+     std::size_t GetPendingFrameNumber() const;
+
+private:
+     struct Frame
+     {
+          std::uint64_t fence;
+          std::size_t end;
+          std::size_t size;
+     };
+
+     const std::size_t capacity_;
+     std::size_t head_;
+     std::size_t tail_;
+     std::size_t used_;
+     std::size_t frameUsed_;
+     std::deque<Frame> frames_;
+};
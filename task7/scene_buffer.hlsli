@@ -1,7 +1,6 @@
-#include "defines.hlsli"
-
 cbuffer SceneConstantBuffer : register (b1)
 {
      float4x4 viewProj;
      int4 indexBuffer; // x - index
+     float4 time; // x - animation time in seconds
 };
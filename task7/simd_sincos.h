@@ -0,0 +1,84 @@
+#pragma once
+
+#include <immintrin.h>
+
+// Cephes single precision sine and cosine of 4 or 8 angles: reduction by pi/4 in three parts and minimax
+// polynomials. Absolute error stays below 2e-7 for |angle| up to 8192, larger angles should be reduced by caller.
+static constexpr const float sinCosFourOverPi = 1.27323954473516f;
+static constexpr const float sinCosReductionPart1 = 0.78515625f;
+static constexpr const float sinCosReductionPart2 = 2.4187564849853515625e-4f;
+static constexpr const float sinCosReductionPart3 = 3.77489497744594108e-8f;
+static constexpr const float sinCosSinCoefficient0 = -1.9515295891e-4f;
+static constexpr const float sinCosSinCoefficient1 = 8.3321608736e-3f;
+static constexpr const float sinCosSinCoefficient2 = -1.6666654611e-1f;
+static constexpr const float sinCosCosCoefficient0 = 2.443315711809948e-5f;
+static constexpr const float sinCosCosCoefficient1 = -1.388731625493765e-3f;
+static constexpr const float sinCosCosCoefficient2 = 4.166664568298827e-2f;
+
+inline void SinCos4(const __m128 angle, __m128 &sin, __m128 &cos)
+{
+     const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+     const __m128 x = _mm_andnot_ps(signMask, angle);
+
+     // Octant rounded up to even, so the reduced argument is in [-pi/4, pi/4]
+     __m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(sinCosFourOverPi)));
+     octant = _mm_and_si128(_mm_add_epi32(octant, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+     const __m128 y = _mm_cvtepi32_ps(octant);
+     __m128 r = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(sinCosReductionPart1)));
+     r = _mm_sub_ps(r, _mm_mul_ps(y, _mm_set1_ps(sinCosReductionPart2)));
+     r = _mm_sub_ps(r, _mm_mul_ps(y, _mm_set1_ps(sinCosReductionPart3)));
+
+     const __m128 sinSign = _mm_xor_ps(
+          _mm_and_ps(angle, signMask),
+          _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29)));
+     const __m128 cosSign = _mm_castsi128_ps(
+          _mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+     const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+
+     const __m128 z = _mm_mul_ps(r, r);
+     __m128 cosPoly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(sinCosCosCoefficient0), z), _mm_set1_ps(sinCosCosCoefficient1));
+     cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(sinCosCosCoefficient2));
+     cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+     cosPoly = _mm_add_ps(_mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+     __m128 sinPoly = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(sinCosSinCoefficient0), z), _mm_set1_ps(sinCosSinCoefficient1));
+     sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(sinCosSinCoefficient2));
+     sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), r), r);
+
+     sin = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cosPoly), _mm_andnot_ps(swap, sinPoly)), sinSign);
+     cos = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sinPoly), _mm_andnot_ps(swap, cosPoly)), cosSign);
+}
+
+#if defined(__AVX2__)
+inline void SinCos8(const __m256 angle, __m256 &sin, __m256 &cos)
+{
+     const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+     const __m256 x = _mm256_andnot_ps(signMask, angle);
+
+     __m256i octant = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(sinCosFourOverPi)));
+     octant = _mm256_and_si256(_mm256_add_epi32(octant, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+     const __m256 y = _mm256_cvtepi32_ps(octant);
+     __m256 r = _mm256_fnmadd_ps(y, _mm256_set1_ps(sinCosReductionPart1), x);
+     r = _mm256_fnmadd_ps(y, _mm256_set1_ps(sinCosReductionPart2), r);
+     r = _mm256_fnmadd_ps(y, _mm256_set1_ps(sinCosReductionPart3), r);
+
+     const __m256 sinSign = _mm256_xor_ps(
+          _mm256_and_ps(angle, signMask),
+          _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(4)), 29)));
+     const __m256 cosSign = _mm256_castsi256_ps(
+          _mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(octant, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+     const __m256 swap = _mm256_castsi256_ps(
+          _mm256_cmpeq_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(2)), _mm256_set1_epi32(2)));
+
+     const __m256 z = _mm256_mul_ps(r, r);
+     __m256 cosPoly = _mm256_fmadd_ps(_mm256_set1_ps(sinCosCosCoefficient0), z, _mm256_set1_ps(sinCosCosCoefficient1));
+     cosPoly = _mm256_fmadd_ps(cosPoly, z, _mm256_set1_ps(sinCosCosCoefficient2));
+     cosPoly = _mm256_mul_ps(_mm256_mul_ps(cosPoly, z), z);
+     cosPoly = _mm256_add_ps(_mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), cosPoly), _mm256_set1_ps(1.0f));
+     __m256 sinPoly = _mm256_fmadd_ps(_mm256_set1_ps(sinCosSinCoefficient0), z, _mm256_set1_ps(sinCosSinCoefficient1));
+     sinPoly = _mm256_fmadd_ps(sinPoly, z, _mm256_set1_ps(sinCosSinCoefficient2));
+     sinPoly = _mm256_fmadd_ps(_mm256_mul_ps(sinPoly, z), r, r);
+
+     sin = _mm256_xor_ps(_mm256_blendv_ps(sinPoly, cosPoly, swap), sinSign);
+     cos = _mm256_xor_ps(_mm256_blendv_ps(cosPoly, sinPoly, swap), cosSign);
+}
+#endif
@@ -0,0 +1,110 @@
+#include "simulation_clock.h"
+
+namespace
+{
+
+     constexpr const double nanosecondsInSecond = 1e9;
+
+     std::uint64_t ToNanoseconds(const double seconds)
+     {
+          return static_cast<std::uint64_t>(seconds * nanosecondsInSecond + 0.5);
+     }
+
+}
+
+SimulationClock::SimulationClock(TimeSource &source, const double step, const unsigned maxSteps) :
+     source_(source),
+     step_(ToNanoseconds(step) > 0 ? ToNanoseconds(step) : 1),
+     maxSteps_(maxSteps > 0 ? maxSteps : 1),
+     lastReal_(source.GetNanoseconds()),
+     accumulator_(0),
+     stepNumber_(0),
+     virtualFrameTime_(0),
+     timeScale_(1.0),
+     paused_(false)
+{
+}
+
+unsigned SimulationClock::Tick()
+{
+     const std::uint64_t real = source_.GetNanoseconds();
+     std::uint64_t elapsed = real > lastReal_ ? real - lastReal_ : 0;
+     lastReal_ = real;
+     if (0 != virtualFrameTime_)
+          elapsed = virtualFrameTime_;
+     if (paused_)
+          return 0;
+
+     // Long stalls, e.g. a debugger break, must not turn into a burst of steps
+     const std::uint64_t scaled = static_cast<std::uint64_t>(static_cast<double>(elapsed) * timeScale_);
+     const std::uint64_t maxElapsed = step_ * maxSteps_;
+     accumulator_ += scaled < maxElapsed ? scaled : maxElapsed;
+
+     unsigned steps = 0;
+     while (accumulator_ >= step_ && steps < maxSteps_)
+     {
+          accumulator_ -= step_;
+          ++steps;
+     }
+     if (accumulator_ >= step_)
+          accumulator_ = step_ - 1;
+     stepNumber_ += steps;
+     return steps;
+}
+
+double SimulationClock::GetTime() const
+{
+     return static_cast<double>(stepNumber_ * step_) / nanosecondsInSecond;
+}
+
+double SimulationClock::GetStep() const
+{
+     return static_cast<double>(step_) / nanosecondsInSecond;
+}
+
+double SimulationClock::GetAlpha() const
+{
+     return static_cast<double>(accumulator_) / static_cast<double>(step_);
+}
+
+double SimulationClock::GetInterpolatedTime() const
+{
+     if (0 == stepNumber_)
+          return 0.0;
+     return static_cast<double>((stepNumber_ - 1) * step_ + accumulator_) / nanosecondsInSecond;
+}
+
+std::uint64_t SimulationClock::GetStepNumber() const
+{
+     return stepNumber_;
+}
+
+void SimulationClock::SetPaused(const bool paused)
+{
+     paused_ = paused;
+}
+
+bool SimulationClock::IsPaused() const
+{
+     return paused_;
+}
+
+void SimulationClock::SetTimeScale(const double scale)
+{
+     timeScale_ = scale > 0.0 ? scale : 0.0;
+}
+
+double SimulationClock::GetTimeScale() const
+{
+     return timeScale_;
+}
+
+void SimulationClock::SetVirtualFrameTime(const double frameTime)
+{
+     virtualFrameTime_ = frameTime > 0.0 ? ToNanoseconds(frameTime) : 0;
+}
+
+bool SimulationClock::IsVirtual() const
+{
+     return 0 != virtualFrameTime_;
+}
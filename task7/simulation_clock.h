@@ -0,0 +1,45 @@
+#pragma once
+
+#include "time_source.h"
+
+#include <cstdint>
+
+// Fixed step simulation time. Every Tick turns elapsed real time, scaled and clamped, into a number of
+// whole steps to simulate, and the remainder gives the blend factor between the last two states. Virtual
+// mode advances by a fixed frame time per Tick regardless of the time source, so runs are reproducible.
+// Times are kept in integer nanoseconds to avoid drift.
+class SimulationClock
+{
+public:
+     SimulationClock(TimeSource &source, const double step, const unsigned maxSteps = 8);
+     // Returns number of steps to simulate for this frame
+     unsigned Tick();
+
+     // Time of the latest step in seconds
+     double GetTime() const;
+     double GetStep() const;
+     // Position between the previous and the latest step in [0, 1)
+     double GetAlpha() const;
+     // Time to present, lags the latest step by the remainder of one step
+     double GetInterpolatedTime() const;
+     std::uint64_t GetStepNumber() const;
+
+     void SetPaused(const bool paused);
+     bool IsPaused() const;
+     void SetTimeScale(const double scale);
+     double GetTimeScale() const;
+     // Zero frame time returns to real time
+     void SetVirtualFrameTime(const double frameTime);
+     bool IsVirtual() const;
+
+private:
+     TimeSource &source_;
+     const std::uint64_t step_;
+     const unsigned maxSteps_;
+     std::uint64_t lastReal_;
+     std::uint64_t accumulator_;
+     std::uint64_t stepNumber_;
+     std::uint64_t virtualFrameTime_;
+     double timeScale_;
+     bool paused_;
+};
@@ -0,0 +1,66 @@
+#include "static_instance_buffer.h"
+#include "utils.h"
+#include <exception>
+#include <vector>
+
+StaticInstanceBuffer::StaticInstanceBuffer(ID3D11Device *device, const unsigned stride, const void *data, const unsigned count) :
+     size_(count), pBuffer_(nullptr), pSRV_(nullptr)
+{
+     // Empty buffers can not be created, keep a single zeroed element instead
+     const unsigned elementNumber = count > 0 ? count : 1;
+     std::vector<char> empty;
+     if (0 == count)
+     {
+          empty.resize(stride);
+          data = empty.data();
+     }
+
+     D3D11_BUFFER_DESC desc;
+     ZeroMemory(&desc, sizeof(desc));
+     desc.ByteWidth = stride * elementNumber;
+     desc.Usage = D3D11_USAGE_IMMUTABLE;
+     desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+     desc.CPUAccessFlags = 0;
+     desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+     desc.StructureByteStride = stride;
+
+     D3D11_SUBRESOURCE_DATA initData;
+     ZeroMemory(&initData, sizeof(initData));
+     initData.pSysMem = data;
+     initData.SysMemPitch = desc.ByteWidth;
+     initData.SysMemSlicePitch = 0;
+
+     HRESULT result = device->CreateBuffer(&desc, &initData, &pBuffer_);
+     if (FAILED(result))
+          throw std::exception("Failed to create static instance buffer");
+
+     D3D11_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc;
+     ZeroMemory(&shaderResourceViewDesc, sizeof(shaderResourceViewDesc));
+     shaderResourceViewDesc.Format = DXGI_FORMAT_UNKNOWN;
+     shaderResourceViewDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+     shaderResourceViewDesc.Buffer.FirstElement = 0;
+     shaderResourceViewDesc.Buffer.NumElements = elementNumber;
+
+     result = device->CreateShaderResourceView(pBuffer_, &shaderResourceViewDesc, &pSRV_);
+     if (FAILED(result))
+     {
+          SafeRelease(pBuffer_);
+          throw std::exception("Failed to create static instance buffer view");
+     }
+}
+
+StaticInstanceBuffer::~StaticInstanceBuffer()
+{
+     SafeRelease(pSRV_);
+     SafeRelease(pBuffer_);
+}
+
+unsigned StaticInstanceBuffer::GetSize() const
+{
+     return size_;
+}
+
+ID3D11ShaderResourceView *StaticInstanceBuffer::GetSRV()
+{
+     return pSRV_;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <d3d11.h>
+
+// Immutable structured buffer of per instance data which is uploaded once and stays resident
+class StaticInstanceBuffer
+{
+public:
+     StaticInstanceBuffer(ID3D11Device *device, const unsigned stride, const void *data, const unsigned count);
+     ~StaticInstanceBuffer();
+     unsigned GetSize() const;
+     ID3D11ShaderResourceView *GetSRV();
+
+private:
+     unsigned size_;
+     ID3D11Buffer *pBuffer_;
+     ID3D11ShaderResourceView *pSRV_;
+};
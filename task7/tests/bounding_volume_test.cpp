@@ -0,0 +1,114 @@
+#include "bounding_volume.h"
+#include "check.h"
+
+#include <directxmath.h>
+#include <cmath>
+#include <random>
+
+namespace
+{
+
+     DirectX::XMFLOAT3 GetCorner(const Aabb &box, const int corner)
+     {
+          return DirectX::XMFLOAT3(
+               0 != (corner & 1) ? box.max.x : box.min.x,
+               0 != (corner & 2) ? box.max.y : box.min.y,
+               0 != (corner & 4) ? box.max.z : box.min.z);
+     }
+
+     DirectX::XMFLOAT3 Transform(const DirectX::XMFLOAT3 &point, DirectX::FXMMATRIX world)
+     {
+          DirectX::XMFLOAT3 result;
+          DirectX::XMStoreFloat3(&result, DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&point), world));
+          return result;
+     }
+
+     bool Contains(const Aabb &box, const DirectX::XMFLOAT3 &point, const float tolerance)
+     {
+          return point.x >= box.min.x - tolerance && point.x <= box.max.x + tolerance &&
+               point.y >= box.min.y - tolerance && point.y <= box.max.y + tolerance &&
+               point.z >= box.min.z - tolerance && point.z <= box.max.z + tolerance;
+     }
+
+     float Distance(const DirectX::XMFLOAT3 &a, const DirectX::XMFLOAT3 &b)
+     {
+          return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z));
+     }
+
+}
+
+// Arvo's box transform against transformed corners, spin bounds against sampled angles
+int main()
+{
+     std::mt19937 random(3);
+     std::uniform_real_distribution<float> coordinate(-5.0f, 5.0f);
+     std::uniform_real_distribution<float> size(0.0f, 5.0f);
+     std::uniform_real_distribution<float> angle(-DirectX::XM_PI, DirectX::XM_PI);
+     const float tolerance = 1e-4f;
+
+     for (int i = 0; i < 10000; ++i)
+     {
+          Aabb box;
+          box.min = DirectX::XMFLOAT3(coordinate(random), coordinate(random), coordinate(random));
+          box.max = DirectX::XMFLOAT3(box.min.x + size(random), box.min.y + size(random), box.min.z + size(random));
+
+          // Transformed box is exactly the bounds of transformed corners
+          const DirectX::XMMATRIX world = DirectX::XMMatrixMultiply(
+               DirectX::XMMatrixMultiply(
+                    DirectX::XMMatrixScaling(1.0f + size(random), 1.0f, 2.0f),
+                    DirectX::XMMatrixRotationRollPitchYaw(angle(random), angle(random), angle(random))),
+               DirectX::XMMatrixTranslation(coordinate(random), coordinate(random), coordinate(random)));
+          const Aabb transformed = TransformAabb(box, world);
+          Aabb expected = {{1e9f, 1e9f, 1e9f}, {-1e9f, -1e9f, -1e9f}};
+          for (int corner = 0; corner < 8; ++corner)
+          {
+               const DirectX::XMFLOAT3 point = Transform(GetCorner(box, corner), world);
+               expected.min = DirectX::XMFLOAT3(std::fmin(expected.min.x, point.x), std::fmin(expected.min.y, point.y), std::fmin(expected.min.z, point.z));
+               expected.max = DirectX::XMFLOAT3(std::fmax(expected.max.x, point.x), std::fmax(expected.max.y, point.y), std::fmax(expected.max.z, point.z));
+          }
+          CHECK(std::fabs(transformed.min.x - expected.min.x) < tolerance && std::fabs(transformed.max.x - expected.max.x) < tolerance);
+          CHECK(std::fabs(transformed.min.y - expected.min.y) < tolerance && std::fabs(transformed.max.y - expected.max.y) < tolerance);
+          CHECK(std::fabs(transformed.min.z - expected.min.z) < tolerance && std::fabs(transformed.max.z - expected.max.z) < tolerance);
+
+          // Spin bounds hold the box at any angle around the vertical axis, sphere bounds hold it too
+          const Sphere sphere = {
+               DirectX::XMFLOAT3((box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f, (box.min.z + box.max.z) * 0.5f),
+               Distance(box.min, box.max) * 0.5f};
+          const Aabb inner = SpinInnerAabb(box);
+          const Aabb outer = SpinOuterAabb(box);
+          const Sphere spinSphere = SpinSphere(sphere);
+          const Aabb spinSphereBox = SphereToAabb(spinSphere);
+          for (int step = 0; step < 16; ++step)
+          {
+               const DirectX::XMMATRIX spin = DirectX::XMMatrixRotationY(angle(random));
+               for (int corner = 0; corner < 8; ++corner)
+               {
+                    const DirectX::XMFLOAT3 point = Transform(GetCorner(box, corner), spin);
+                    CHECK(Contains(outer, point, tolerance));
+                    CHECK(Distance(point, spinSphere.center) <= spinSphere.radius + tolerance);
+                    CHECK(Contains(spinSphereBox, point, tolerance));
+               }
+               // Inner box is covered by the spinning box, its corners stay inside of the rotated box.
+               // It is empty when the box does not hold the axis.
+               if (0.0f < inner.max.x)
+               {
+                    const DirectX::XMMATRIX inverse = DirectX::XMMatrixTranspose(spin);
+                    for (int corner = 0; corner < 8; ++corner)
+                         CHECK(Contains(box, Transform(GetCorner(inner, corner), inverse), tolerance));
+               }
+          }
+     }
+
+     // Unit cube mesh is bounded by the half diagonal
+     float vertices[8][3];
+     for (int corner = 0; corner < 8; ++corner)
+     {
+          vertices[corner][0] = 0 != (corner & 1) ? 0.5f : -0.5f;
+          vertices[corner][1] = 0 != (corner & 2) ? 0.5f : -0.5f;
+          vertices[corner][2] = 0 != (corner & 4) ? 0.5f : -0.5f;
+     }
+     const MeshBounds meshBounds = ComputeMeshBounds(vertices, 8, sizeof(vertices[0]));
+     CHECK(std::fabs(meshBounds.sphere.radius - std::sqrt(0.75f)) < tolerance);
+     CHECK(std::fabs(meshBounds.box.min.x + 0.5f) < tolerance && std::fabs(meshBounds.box.max.z - 0.5f) < tolerance);
+     return CheckResult();
+}
@@ -0,0 +1,97 @@
+#include "bvh.h"
+#include "frustum.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Bvh::Cull against the linear CheckRectangles pass over the same boxes for 10^5 and 10^6 boxes spread over a
+// large scene, median of repeated runs with the camera turning between them. Build time is paid once.
+int main()
+{
+     const int runNumber = 21;
+     std::printf("%10s %10s %10s %12s %12s %8s\n", "boxes", "visible", "build ms", "bvh ms", "linear ms", "speedup");
+     for (std::size_t count : {100000, 1000000})
+     {
+          // Density stays the same, so the frustum keeps a similar number of boxes while the scene grows
+          std::mt19937 random(2);
+          const float extent = std::sqrt(static_cast<float>(count)) * 0.5f;
+          std::uniform_real_distribution<float> coordinate(-extent, extent);
+          std::uniform_real_distribution<float> halfSize(0.1f, 0.5f);
+          std::vector<float> bounds[6];
+          for (auto &component : bounds)
+               component.resize(count);
+          for (std::size_t i = 0; i < count; ++i)
+          {
+               const float center[] = {coordinate(random), coordinate(random) * 0.05f, coordinate(random)};
+               for (int axis = 0; axis < 3; ++axis)
+               {
+                    const float size = halfSize(random);
+                    bounds[axis][i] = center[axis] - size;
+                    bounds[axis + 3][i] = center[axis] + size;
+               }
+          }
+
+          Bvh bvh;
+          const auto buildStart = std::chrono::steady_clock::now();
+          bvh.Build(bounds[0].data(), bounds[1].data(), bounds[2].data(), bounds[3].data(), bounds[4].data(), bounds[5].data(), count);
+          const double buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+          Frustum frustum(0.1f);
+          std::vector<std::uint32_t> visible(count);
+          std::vector<std::uint32_t> linearVisible(count);
+          std::vector<double> bvhTimes;
+          std::vector<double> linearTimes;
+          std::size_t visibleNumber = 0;
+          bool same = true;
+          for (int run = 0; run < runNumber; ++run)
+          {
+               const float angle = run * 0.3f;
+               frustum.Construct(
+                    DirectX::XMMatrixLookAtLH(
+                         DirectX::XMVectorSet(0.0f, 2.0f, 0.0f, 0.0f),
+                         DirectX::XMVectorSet(std::cos(angle), 2.0f, std::sin(angle), 0.0f),
+                         DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+                    DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f));
+
+               const auto start = std::chrono::steady_clock::now();
+               visibleNumber = bvh.Cull(frustum, visible.data());
+               const auto middle = std::chrono::steady_clock::now();
+               const std::size_t linearVisibleNumber = frustum.CheckRectangles(
+                    bounds[0].data(),
+                    bounds[1].data(),
+                    bounds[2].data(),
+                    bounds[3].data(),
+                    bounds[4].data(),
+                    bounds[5].data(),
+                    count,
+                    linearVisible.data());
+               const auto end = std::chrono::steady_clock::now();
+               bvhTimes.push_back(std::chrono::duration<double, std::milli>(middle - start).count());
+               linearTimes.push_back(std::chrono::duration<double, std::milli>(end - middle).count());
+
+               // Hierarchy visits boxes in its own order
+               std::sort(visible.begin(), visible.begin() + visibleNumber);
+               same = same && visibleNumber == linearVisibleNumber &&
+                    std::equal(visible.begin(), visible.begin() + visibleNumber, linearVisible.begin());
+          }
+          std::nth_element(bvhTimes.begin(), bvhTimes.begin() + runNumber / 2, bvhTimes.end());
+          std::nth_element(linearTimes.begin(), linearTimes.begin() + runNumber / 2, linearTimes.end());
+          const double bvhTime = bvhTimes[runNumber / 2];
+          const double linearTime = linearTimes[runNumber / 2];
+          std::printf(
+               "%10zu %10zu %10.1f %12.3f %12.3f %7.2fx%s\n",
+               count,
+               visibleNumber,
+               buildTime,
+               bvhTime,
+               linearTime,
+               linearTime / bvhTime,
+               same ? "" : " (results differ)");
+     }
+     return 0;
+}
@@ -0,0 +1,80 @@
+#include "bvh.h"
+#include "check.h"
+#include "frustum.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Bvh::Cull against brute force Frustum::CheckRectangles, after the build and after refits of moved boxes
+int main()
+{
+     std::mt19937 random(2);
+     std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+     std::uniform_real_distribution<float> extent(0.01f, 1.0f);
+     std::uniform_real_distribution<float> shift(-0.5f, 0.5f);
+
+     const std::size_t count = 20000;
+     std::vector<float> bounds[6];
+     for (auto &component : bounds)
+          component.resize(count);
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               const float center = coordinate(random);
+               const float halfSize = extent(random);
+               bounds[axis][i] = center - halfSize;
+               bounds[axis + 3][i] = center + halfSize;
+          }
+     }
+
+     Bvh bvh;
+     bvh.Build(bounds[0].data(), bounds[1].data(), bounds[2].data(), bounds[3].data(), bounds[4].data(), bounds[5].data(), count);
+     CHECK(count == bvh.GetSize());
+
+     Frustum frustum(0.1f);
+     std::size_t visibleTotal = 0;
+     for (int view = 0; view < 50; ++view)
+     {
+          if (5 == view % 10)
+          {
+               for (std::size_t i = 0; i < count; ++i)
+               {
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                         const float delta = shift(random);
+                         bounds[axis][i] += delta;
+                         bounds[axis + 3][i] += delta;
+                    }
+               }
+               bvh.Refit(bounds[0].data(), bounds[1].data(), bounds[2].data(), bounds[3].data(), bounds[4].data(), bounds[5].data());
+          }
+
+          const DirectX::XMVECTOR eye = DirectX::XMVectorSet(coordinate(random), coordinate(random), coordinate(random), 0.0f);
+          const DirectX::XMVECTOR at = DirectX::XMVectorSet(coordinate(random) * 0.1f, 0.0f, 0.0f, 0.0f);
+          frustum.Construct(
+               DirectX::XMMatrixLookAtLH(eye, at, DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+               DirectX::XMMatrixPerspectiveFovLH(1.0f, 1.7f, 100.0f, 0.1f));
+
+          std::vector<std::uint32_t> visible(count);
+          visible.resize(bvh.Cull(frustum, visible.data()));
+          std::sort(visible.begin(), visible.end());
+
+          std::vector<std::uint32_t> expected(count);
+          expected.resize(frustum.CheckRectangles(
+               bounds[0].data(),
+               bounds[1].data(),
+               bounds[2].data(),
+               bounds[3].data(),
+               bounds[4].data(),
+               bounds[5].data(),
+               count,
+               expected.data()));
+          CHECK(expected == visible);
+          visibleTotal += visible.size();
+     }
+     CHECK(0 < visibleTotal);
+     return CheckResult();
+}
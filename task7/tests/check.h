@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+
+// Failed checks are reported and counted, tests keep running and return CheckResult() from main
+inline int &GetCheckFailures()
+{
+     static int failures = 0;
+     return failures;
+}
+
+#define CHECK(condition) \
+     do \
+     { \
+          if (!(condition)) \
+          { \
+               std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+               ++GetCheckFailures(); \
+          } \
+     } while (false)
+
+inline int CheckResult()
+{
+     if (0 != GetCheckFailures())
+          std::printf("%d checks failed\n", GetCheckFailures());
+     return 0 != GetCheckFailures() ? 1 : 0;
+}
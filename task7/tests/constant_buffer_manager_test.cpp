@@ -0,0 +1,146 @@
+#include "check.h"
+#include "constant_buffer_manager.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+     // Buffers are byte vectors filled with garbage, so missed uploads show up as differences
+     class FakeConstantBufferDevice : public ConstantBufferDevice
+     {
+     public:
+          explicit FakeConstantBufferDevice(const bool partialUpdate) :
+               createNumber(0),
+               releaseNumber(0),
+               fullUploadViolations(0),
+               failCreate(false),
+               partialUpdate_(partialUpdate)
+          {
+          }
+
+          void *CreateBuffer(const std::string &, const unsigned size) override
+          {
+               if (failCreate)
+                    return nullptr;
+               ++createNumber;
+               return new std::vector<char>(size, 0x55);
+          }
+
+          void ReleaseBuffer(void *buffer) override
+          {
+               ++releaseNumber;
+               delete static_cast<std::vector<char> *>(buffer);
+          }
+
+          bool SupportsPartialUpdate() const override
+          {
+               return partialUpdate_;
+          }
+
+          unsigned UpdateBuffer(void *buffer, const void *data, const unsigned size, const unsigned begin, const unsigned end) override
+          {
+               std::vector<char> &content = *static_cast<std::vector<char> *>(buffer);
+               if (!partialUpdate_ && (0 != begin || size != end))
+                    ++fullUploadViolations;
+               if (size != content.size() || end < begin || size < end)
+                    ++fullUploadViolations;
+               std::memcpy(content.data() + begin, static_cast<const char *>(data) + begin, end - begin);
+               return end - begin;
+          }
+
+          static const std::vector<char> &GetContent(void *buffer)
+          {
+               return *static_cast<std::vector<char> *>(buffer);
+          }
+
+          int createNumber;
+          int releaseNumber;
+          int fullUploadViolations;
+          bool failCreate;
+
+     private:
+          bool partialUpdate_;
+     };
+
+}
+
+// Shadow copies against reference buffers over random writes, with and without partial updates,
+// plus sharing by name, redundant writes and failures
+int main()
+{
+     for (const bool partialUpdate : { false, true })
+     {
+          FakeConstantBufferDevice device(partialUpdate);
+          {
+               ConstantBufferManager manager(device);
+               const ConstantBufferManager::Block scene = manager.Register("Scene", 80);
+               const ConstantBufferManager::Block light = manager.Register("Light", 1024);
+               CHECK(ConstantBufferManager::invalidBlock != scene && ConstantBufferManager::invalidBlock != light);
+               CHECK(scene == manager.Register("Scene", 80));
+               CHECK(ConstantBufferManager::invalidBlock == manager.Register("Scene", 96));
+               CHECK(2 == device.createNumber);
+               device.failCreate = true;
+               CHECK(ConstantBufferManager::invalidBlock == manager.Register("Failed", 16));
+               device.failCreate = false;
+
+               // Initial content is zero and goes to the device on the first flush
+               const ConstantBufferManager::Block blocks[2] = { scene, light };
+               std::vector<char> expected[2] = { std::vector<char>(80, 0), std::vector<char>(1024, 0) };
+               manager.Flush();
+               for (int i = 0; i < 2; ++i)
+                    CHECK(expected[i] == FakeConstantBufferDevice::GetContent(manager.GetBuffer(blocks[i])));
+
+               std::mt19937 random(17);
+               for (int frame = 0; frame < 500; ++frame)
+               {
+                    manager.ResetStatistics();
+                    const int writeNumber = static_cast<int>(random() % 5);
+                    for (int write = 0; write < writeNumber; ++write)
+                    {
+                         const int i = static_cast<int>(random() % 2);
+                         const unsigned size = static_cast<unsigned>(expected[i].size());
+                         const unsigned offset = static_cast<unsigned>(random() % size);
+                         const unsigned length = 1 + static_cast<unsigned>(random() % std::min(64u, size - offset));
+                         std::vector<char> data(length);
+                         for (char &value : data)
+                              value = static_cast<char>(random() % 3);
+                         std::memcpy(expected[i].data() + offset, data.data(), length);
+                         manager.Write(blocks[i], data.data(), offset, length);
+                    }
+                    manager.Flush();
+                    for (int i = 0; i < 2; ++i)
+                         CHECK(expected[i] == FakeConstantBufferDevice::GetContent(manager.GetBuffer(blocks[i])));
+                    const ConstantBufferManager::Statistics &statistics = manager.GetStatistics();
+                    CHECK(0 == statistics.uploadedBytes % 16);
+                    if (0 == writeNumber)
+                         CHECK(0 == statistics.uploadNumber);
+               }
+
+               // Writing the same content again uploads nothing
+               manager.ResetStatistics();
+               manager.Write(light, expected[1].data(), 0, 1024);
+               manager.Flush();
+               CHECK(1024 == manager.GetStatistics().writtenBytes);
+               CHECK(0 == manager.GetStatistics().uploadedBytes);
+               CHECK(0 == manager.GetStatistics().uploadNumber);
+
+               // Single changed register is uploaded alone with partial updates, the whole buffer without
+               manager.ResetStatistics();
+               const char value = 7;
+               expected[1][500] = value;
+               manager.Write(light, &value, 500, 1);
+               manager.Flush();
+               CHECK(expected[1] == FakeConstantBufferDevice::GetContent(manager.GetBuffer(light)));
+               CHECK((partialUpdate ? 16u : 1024u) == manager.GetStatistics().uploadedBytes);
+               CHECK(1 == manager.GetStatistics().uploadNumber);
+          }
+          CHECK(0 == device.fullUploadViolations);
+          CHECK(device.createNumber == device.releaseNumber);
+     }
+     return CheckResult();
+}
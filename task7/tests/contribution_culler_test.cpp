@@ -0,0 +1,146 @@
+#include "check.h"
+#include "contribution_culler.h"
+
+#include <directxmath.h>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+     // Field of view of 90 degrees over 200 pixels gives 100 pixels per unit of radius at unit distance
+     const float fov = DirectX::XM_PIDIV2;
+     const unsigned height = 200;
+     const float pixelScale = 100.0f;
+
+     // Unit spheres on the x axis, placed at distance where they project to given pixel radius
+     struct Scene
+     {
+          std::vector<float> centers[3];
+          std::vector<float> radius;
+          std::vector<float> maxDistance;
+
+          explicit Scene(const std::size_t count) :
+               radius(count, 1.0f),
+               maxDistance(count, 1000.0f)
+          {
+               for (auto &component : centers)
+                    component.resize(count, 0.0f);
+          }
+
+          void SetPixelRadius(const std::size_t i, const float pixelRadius)
+          {
+               // pixelRadius = r / sqrt(d^2 - r^2) * pixelScale
+               const float r = radius[i];
+               const float projected = r * pixelScale / pixelRadius;
+               centers[0][i] = std::sqrt(projected * projected + r * r);
+          }
+
+          std::vector<std::uint32_t> Filter(ContributionCuller &culler, std::vector<std::uint32_t> indices, const bool useMaxDistance = false)
+          {
+               culler.SetView(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), fov, height);
+               indices.resize(culler.Filter(
+                    centers[0].data(),
+                    centers[1].data(),
+                    centers[2].data(),
+                    radius.data(),
+                    useMaxDistance ? maxDistance.data() : nullptr,
+                    radius.size(),
+                    indices.data(),
+                    indices.size()));
+               return indices;
+          }
+     };
+
+     bool Kept(ContributionCuller &culler, Scene &scene, const std::uint32_t index, const float pixelRadius)
+     {
+          scene.SetPixelRadius(index, pixelRadius);
+          return !scene.Filter(culler, {index}).empty();
+     }
+
+}
+
+// Pixel radius threshold derived from fov and viewport height, hysteresis band around it, max draw distance
+// and the reset of hysteresis for objects which skipped a frame
+int main()
+{
+     // Threshold: 1 pixel with 20 % hysteresis, so dropped objects come back above 1.2 pixels
+     {
+          ContributionCuller culler(1.0f, 0.2f);
+          Scene scene(6);
+          const float pixelRadii[] = {5.0f, 1.05f, 0.95f, 0.5f, 2.0f, 1.5f};
+          for (std::size_t i = 0; i < 6; ++i)
+               scene.SetPixelRadius(i, pixelRadii[i]);
+          // Kept entries stay in input order
+          CHECK((std::vector<std::uint32_t>{5, 4, 1, 0} == scene.Filter(culler, {5, 4, 3, 2, 1, 0})));
+
+          // Eye inside of the sphere always keeps it
+          scene.centers[0][3] = 0.5f;
+          CHECK((std::vector<std::uint32_t>{3} == scene.Filter(culler, {3})));
+
+          // Threshold scales with viewport height
+          ContributionCuller tallCuller(1.0f, 0.2f);
+          tallCuller.SetView(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), fov, height * 2);
+          scene.SetPixelRadius(2, 0.6f);
+          std::uint32_t index = 2;
+          CHECK(1 == tallCuller.Filter(
+               scene.centers[0].data(),
+               scene.centers[1].data(),
+               scene.centers[2].data(),
+               scene.radius.data(),
+               nullptr,
+               scene.radius.size(),
+               &index,
+               1));
+     }
+
+     // Hysteresis band: between 1 and 1.2 pixels an object keeps its previous state
+     {
+          ContributionCuller culler(1.0f, 0.2f);
+          Scene scene(1);
+          CHECK(Kept(culler, scene, 0, 1.1f));
+          CHECK(Kept(culler, scene, 0, 1.01f));
+          CHECK(!Kept(culler, scene, 0, 0.99f));
+          CHECK(!Kept(culler, scene, 0, 1.1f));
+          CHECK(!Kept(culler, scene, 0, 1.19f));
+          CHECK(Kept(culler, scene, 0, 1.21f));
+          CHECK(Kept(culler, scene, 0, 1.1f));
+     }
+
+     // Max distance: dropped beyond it, back only within 80 % of it
+     {
+          ContributionCuller culler(1.0f, 0.2f);
+          Scene scene(1);
+          scene.maxDistance[0] = 50.0f;
+          const auto keptAt = [&culler, &scene](const float distance)
+          {
+               scene.centers[0][0] = distance;
+               return !scene.Filter(culler, {0}, true).empty();
+          };
+          CHECK(keptAt(45.0f));
+          CHECK(!keptAt(55.0f));
+          CHECK(!keptAt(45.0f));
+          CHECK(!keptAt(41.0f));
+          CHECK(keptAt(39.0f));
+          CHECK(keptAt(49.0f));
+          // Far enough to be dropped by the pixel radius regardless of max distance
+          scene.maxDistance[0] = 1000.0f;
+          CHECK(!keptAt(150.0f));
+     }
+
+     // Objects culled by earlier stages skip the filter, their drop from an older frame is forgotten
+     {
+          ContributionCuller culler(1.0f, 0.2f);
+          Scene scene(2);
+          scene.SetPixelRadius(1, 5.0f);
+          CHECK(!Kept(culler, scene, 0, 0.9f));
+          CHECK((std::vector<std::uint32_t>{1} == scene.Filter(culler, {1})));
+          CHECK(Kept(culler, scene, 0, 1.1f));
+
+          // Without a skipped frame the band still applies
+          CHECK(!Kept(culler, scene, 0, 0.9f));
+          CHECK(!Kept(culler, scene, 0, 1.1f));
+     }
+
+     return CheckResult();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "upload_ring_backend.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Upload ring backend over system memory, GPU completes fences with the given latency in frames
+class FakeUploadRingBackend : public UploadRingBackend
+{
+public:
+     explicit FakeUploadRingBackend(const std::size_t capacity) :
+          memory(capacity),
+          signaledFence(0),
+          latency(2),
+          mapNumber(0),
+          discardNumber(0),
+          mapped(false),
+          doubleMapped(false)
+     {
+     }
+
+     void *Map(const bool discard) override
+     {
+          doubleMapped = doubleMapped || mapped;
+          mapped = true;
+          ++mapNumber;
+          discardNumber += discard ? 1 : 0;
+          return memory.data();
+     }
+
+     void Unmap() override
+     {
+          mapped = false;
+     }
+
+     std::uint64_t SignalFence() override
+     {
+          return ++signaledFence;
+     }
+
+     std::uint64_t GetCompletedFence() override
+     {
+          return signaledFence > latency ? signaledFence - latency : 0;
+     }
+
+     std::vector<char> memory;
+     std::uint64_t signaledFence;
+     std::uint64_t latency;
+     std::size_t mapNumber;
+     std::size_t discardNumber;
+     bool mapped;
+     bool doubleMapped;
+};
@@ -0,0 +1,176 @@
+#include "check.h"
+#include "frame_arena.h"
+#include "frame_builder.h"
+#include "frame_packet.h"
+#include "instance_storage.h"
+#include "lights.h"
+#include "thread_pool.h"
+
+#include <directxmath.h>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+     std::atomic<std::size_t> allocationNumber(0);
+
+     struct Vertex
+     {
+          float x, y, z;
+     };
+
+     // Unit cube with clockwise front faces, as the renderer's cube
+     const Vertex cubeVertices[24] = {
+          {-0.5f, -0.5f, 0.5f}, {0.5f, -0.5f, 0.5f}, {0.5f, -0.5f, -0.5f}, {-0.5f, -0.5f, -0.5f},
+          {-0.5f, 0.5f, -0.5f}, {0.5f, 0.5f, -0.5f}, {0.5f, 0.5f, 0.5f}, {-0.5f, 0.5f, 0.5f},
+          {0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, 0.5f}, {0.5f, 0.5f, 0.5f}, {0.5f, 0.5f, -0.5f},
+          {-0.5f, -0.5f, 0.5f}, {-0.5f, -0.5f, -0.5f}, {-0.5f, 0.5f, -0.5f}, {-0.5f, 0.5f, 0.5f},
+          {0.5f, -0.5f, 0.5f}, {-0.5f, -0.5f, 0.5f}, {-0.5f, 0.5f, 0.5f}, {0.5f, 0.5f, 0.5f},
+          {-0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, -0.5f}, {-0.5f, 0.5f, -0.5f}};
+     const unsigned short cubeIndices[36] = {
+          0, 2, 1, 0, 3, 2,
+          4, 6, 5, 4, 7, 6,
+          8, 10, 9, 8, 11, 10,
+          12, 14, 13, 12, 15, 14,
+          16, 18, 17, 16, 19, 18,
+          20, 22, 21, 20, 23, 22};
+
+}
+
+void *operator new(std::size_t size)
+{
+     allocationNumber.fetch_add(1, std::memory_order_relaxed);
+     void *pointer = std::malloc(0 != size ? size : 1);
+     if (nullptr == pointer)
+          throw std::bad_alloc();
+     return pointer;
+}
+
+void operator delete(void *pointer) noexcept
+{
+     std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+     std::free(pointer);
+}
+
+// Arena bookkeeping and alignment, then the renderer's frames minus D3D: every culling mode with contribution and
+// occlusion culling, light BVH refits and rebuilds, instance lights and clusters. Steady state frames must not
+// allocate once the arena and packet vectors have grown.
+int main()
+{
+     FrameArena arena(256);
+     CHECK(256 == arena.GetCapacity());
+     void *small = arena.Allocate(3, 1);
+     void *aligned = arena.Allocate(64, 64);
+     CHECK(nullptr != small && nullptr != aligned);
+     CHECK(0 == reinterpret_cast<std::uintptr_t>(aligned) % 64);
+     CHECK(67 <= arena.GetUsed());
+     // Overflow goes to a separate block, the next Reset grows the main one to hold the whole frame
+     CHECK(nullptr != arena.Allocate(1000, 16));
+     arena.Reset();
+     CHECK(0 == arena.GetUsed());
+     CHECK(1067 <= arena.GetCapacity());
+
+     std::mt19937 random(14);
+     std::uniform_real_distribution<float> coordinate(-30.0f, 30.0f);
+     std::uniform_real_distribution<float> speed(-4.0f, 4.0f);
+     InstanceStorage cubes;
+     for (std::size_t i = 0; i < 20000; ++i)
+          cubes.Add(
+               DirectX::XMFLOAT3(coordinate(random), coordinate(random) * 0.2f, coordinate(random)),
+               speed(random),
+               100.0f,
+               static_cast<std::uint32_t>(i % 3),
+               0 == i % 2);
+     const MeshBounds meshBounds = ComputeMeshBounds(cubeVertices, 24, sizeof(Vertex));
+
+     Lights lights(64, 1.0f / 256.0f);
+     for (std::uint32_t i = 0; i < 64; ++i)
+     {
+          lights.Add(DirectX::XMFLOAT4(coordinate(random), 1.0f, coordinate(random), 0.0f), DirectX::XMFLOAT4(1.0f, 0.5f, 0.25f, 1.0f));
+          lights.AddOrbit(i, 2.0f, 0.5f, static_cast<float>(i));
+          lights.AddSinusoid(i, Lights::Channel::ColorR, 0.5f, 2.0f, 0.0f);
+     }
+     const Sphere planeSpheres[2] = {
+          {DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f), 1.5f},
+          {DirectX::XMFLOAT3(-1.0f, 0.0f, 0.0f), 1.5f}};
+
+     ThreadPool threadPool(4);
+     const FrameBuilder::CullingMode modes[] = {
+          FrameBuilder::CullingMode::Batch,
+          FrameBuilder::CullingMode::Bvh,
+          FrameBuilder::CullingMode::Temporal,
+          FrameBuilder::CullingMode::Octree};
+     for (const auto mode : modes)
+          for (const bool useInstanceLights : {true, false})
+          {
+               FrameBuilder::Settings settings;
+               settings.cullingMode = mode;
+               settings.nearZ = 0.1f;
+               settings.fovY = DirectX::XM_PI / 3;
+               settings.cullingChunkSize = 1024;
+               settings.octreeHalfSize = 32.0f;
+               settings.octreeDepth = 4;
+               settings.useContributionCulling = true;
+               settings.minPixelRadius = 1.0f;
+               settings.usePvs = false;
+               settings.pvsCellSize = 0.5f;
+               settings.pvsMargin = 4.0f;
+               settings.useOcclusionCulling = true;
+               settings.maxOccluderNumber = 16;
+               settings.farZ = 100.0f;
+               settings.clusterTileNumberX = 16;
+               settings.clusterTileNumberY = 9;
+               settings.clusterSliceNumber = 24;
+               settings.useInstanceLights = useInstanceLights;
+               settings.instanceChunkSize = 256;
+               settings.lightBvhRebuildPeriod = 16;
+               FrameBuilder builder(settings, threadPool, arena);
+               builder.SetCubes(cubes, meshBounds, cubeVertices, 24, sizeof(Vertex), cubeIndices, 36);
+
+               FramePacket packet;
+               std::size_t visibleTotal = 0;
+               // The camera turns around twice, the second turn repeats the first one and must not allocate
+               const int frameNumber = 200;
+               for (int frame = 0; frame < frameNumber; ++frame)
+               {
+                    if (frameNumber / 2 == frame)
+                         allocationNumber.store(0);
+
+                    arena.Reset();
+                    const float angle = frame * DirectX::XM_2PI / (frameNumber / 2);
+                    packet.frameIndex = frame + 1;
+                    packet.width = 1280;
+                    packet.height = 720;
+                    packet.pov = DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f);
+                    packet.time = (frame % (frameNumber / 2)) / 60.0;
+                    DirectX::XMStoreFloat4x4(
+                         &packet.view,
+                         DirectX::XMMatrixLookAtLH(
+                              DirectX::XMLoadFloat3(&packet.pov),
+                              DirectX::XMVectorSet(std::cos(angle), 1.0f, std::sin(angle), 0.0f),
+                              DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+                    DirectX::XMStoreFloat4x4(
+                         &packet.proj,
+                         DirectX::XMMatrixPerspectiveFovLH(settings.fovY, 16.0f / 9.0f, settings.farZ, settings.nearZ));
+
+                    builder.BuildEntries(packet);
+                    builder.BuildLights(packet, lights, planeSpheres, 2);
+                    visibleTotal += packet.visibleEntries.size();
+               }
+               CHECK(0 == allocationNumber.load());
+               CHECK(0 < visibleTotal);
+               CHECK(packet.visibleLights.size() == packet.visibleEntries.size());
+               CHECK(useInstanceLights == packet.clusterRanges.empty());
+          }
+     return CheckResult();
+}
@@ -0,0 +1,277 @@
+#include "check.h"
+#include "frame_arena.h"
+#include "frame_builder.h"
+#include "frame_packet.h"
+#include "frustum.h"
+#include "instance_storage.h"
+#include "thread_pool.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+     struct Vertex
+     {
+          float x, y, z;
+     };
+
+     // Unit cube with clockwise front faces, as the renderer's cube
+     const Vertex cubeVertices[24] = {
+          {-0.5f, -0.5f, 0.5f}, {0.5f, -0.5f, 0.5f}, {0.5f, -0.5f, -0.5f}, {-0.5f, -0.5f, -0.5f},
+          {-0.5f, 0.5f, -0.5f}, {0.5f, 0.5f, -0.5f}, {0.5f, 0.5f, 0.5f}, {-0.5f, 0.5f, 0.5f},
+          {0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, 0.5f}, {0.5f, 0.5f, 0.5f}, {0.5f, 0.5f, -0.5f},
+          {-0.5f, -0.5f, 0.5f}, {-0.5f, -0.5f, -0.5f}, {-0.5f, 0.5f, -0.5f}, {-0.5f, 0.5f, 0.5f},
+          {0.5f, -0.5f, 0.5f}, {-0.5f, -0.5f, 0.5f}, {-0.5f, 0.5f, 0.5f}, {0.5f, 0.5f, 0.5f},
+          {-0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, -0.5f}, {-0.5f, 0.5f, -0.5f}};
+     const unsigned short cubeIndices[36] = {
+          0, 2, 1, 0, 3, 2,
+          4, 6, 5, 4, 7, 6,
+          8, 10, 9, 8, 11, 10,
+          12, 14, 13, 12, 15, 14,
+          16, 18, 17, 16, 19, 18,
+          20, 22, 21, 20, 23, 22};
+
+     const float fovY = DirectX::XM_PI / 3;
+     const unsigned height = 720;
+
+     FrameBuilder::Settings MakeSettings(const FrameBuilder::CullingMode mode)
+     {
+          FrameBuilder::Settings settings;
+          settings.cullingMode = mode;
+          settings.nearZ = 0.1f;
+          settings.fovY = fovY;
+          settings.cullingChunkSize = 256;
+          settings.octreeHalfSize = 128.0f;
+          settings.octreeDepth = 5;
+          settings.useContributionCulling = false;
+          settings.minPixelRadius = 1.0f;
+          settings.usePvs = false;
+          settings.pvsCellSize = 2.0f;
+          settings.pvsMargin = 4.0f;
+          settings.useOcclusionCulling = false;
+          settings.maxOccluderNumber = 16;
+          settings.farZ = 100.0f;
+          settings.clusterTileNumberX = 16;
+          settings.clusterTileNumberY = 9;
+          settings.clusterSliceNumber = 24;
+          settings.useInstanceLights = true;
+          settings.instanceChunkSize = 256;
+          settings.lightBvhRebuildPeriod = 64;
+          return settings;
+     }
+
+     // Camera orbits low over the cube grid looking across it
+     void SetCamera(const int frame, const float distance, FramePacket &packet)
+     {
+          const float angle = frame * 0.15f;
+          packet.frameIndex = frame;
+          packet.width = height * 16 / 9;
+          packet.height = height;
+          packet.pov = DirectX::XMFLOAT3(std::cos(angle) * distance, 1.0f + (frame % 5), std::sin(angle) * distance);
+          packet.time = frame / 60.0;
+          DirectX::XMStoreFloat4x4(
+               &packet.view,
+               DirectX::XMMatrixLookAtLH(
+                    DirectX::XMLoadFloat3(&packet.pov),
+                    DirectX::XMVectorSet(std::sin(angle * 3.0f) * 10.0f, 0.0f, 0.0f, 0.0f),
+                    DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+          DirectX::XMStoreFloat4x4(
+               &packet.proj,
+               DirectX::XMMatrixPerspectiveFovLH(fovY, packet.width / static_cast<float>(packet.height), 100.0f, 0.1f));
+     }
+
+     std::vector<std::uint32_t> BruteForceBoxes(const FrameBuilder &builder)
+     {
+          std::vector<std::uint32_t> visible;
+          for (std::size_t i = 0; i < builder.GetCubeNumber(); ++i)
+          {
+               const float min[] = {builder.GetCubeBounds(0)[i], builder.GetCubeBounds(1)[i], builder.GetCubeBounds(2)[i]};
+               const float max[] = {builder.GetCubeBounds(3)[i], builder.GetCubeBounds(4)[i], builder.GetCubeBounds(5)[i]};
+               unsigned planeMask = Frustum::allPlanesMask;
+               if (builder.GetFrustum().CheckRectangleMasked(min, max, planeMask))
+                    visible.push_back(static_cast<std::uint32_t>(i));
+          }
+          return visible;
+     }
+
+     std::vector<std::uint32_t> BruteForceSpheres(const FrameBuilder &builder)
+     {
+          std::vector<std::uint32_t> visible;
+          for (std::size_t i = 0; i < builder.GetCubeNumber(); ++i)
+          {
+               const DirectX::XMFLOAT3 center(builder.GetCubeSpheres(0)[i], builder.GetCubeSpheres(1)[i], builder.GetCubeSpheres(2)[i]);
+               if (builder.GetFrustum().CheckSphere(center, builder.GetCubeSpheres(3)[i]))
+                    visible.push_back(static_cast<std::uint32_t>(i));
+          }
+          return visible;
+     }
+
+     float ProjectedRadius(const FrameBuilder &builder, const DirectX::XMFLOAT3 &eye, const std::uint32_t i)
+     {
+          const float dx = builder.GetCubeSpheres(0)[i] - eye.x;
+          const float dy = builder.GetCubeSpheres(1)[i] - eye.y;
+          const float dz = builder.GetCubeSpheres(2)[i] - eye.z;
+          const float r = builder.GetCubeSpheres(3)[i];
+          const float d2 = dx * dx + dy * dy + dz * dz - r * r;
+          return d2 <= 0.0f ? 1e9f : r / std::sqrt(d2) * 0.5f * height / std::tan(0.5f * fovY);
+     }
+
+     bool IsSubsequence(const std::vector<std::uint32_t> &part, const std::vector<std::uint32_t> &whole)
+     {
+          std::size_t j = 0;
+          for (const std::uint32_t index : part)
+          {
+               while (j < whole.size() && whole[j] != index)
+                    ++j;
+               if (j == whole.size())
+                    return false;
+               ++j;
+          }
+          return true;
+     }
+
+}
+
+// Visible entry lists built by every culling mode against brute force frustum tests of the same bounds,
+// then contribution, occlusion and PVS stages as ordered subsets of the frustum list
+int main()
+{
+     std::mt19937 random(16);
+     std::uniform_real_distribution<float> speed(-4.0f, 4.0f);
+     std::uniform_real_distribution<float> jitter(-0.4f, 0.4f);
+
+     InstanceStorage cubes;
+     for (int i = 0; i < 40; ++i)
+          for (int j = 0; j < 40; ++j)
+               cubes.Add(
+                    DirectX::XMFLOAT3(-60.0f + i * 3.0f + jitter(random), jitter(random), -60.0f + j * 3.0f + jitter(random)),
+                    speed(random),
+                    100.0f,
+                    static_cast<std::uint32_t>(i % 3),
+                    0 == j % 2);
+     const MeshBounds meshBounds = ComputeMeshBounds(cubeVertices, 24, sizeof(Vertex));
+
+     ThreadPool threadPool(4);
+     FrameArena arena(1 << 20);
+     FramePacket packet;
+     const int frameNumber = 40;
+
+     const FrameBuilder::CullingMode modes[] = {
+          FrameBuilder::CullingMode::Batch,
+          FrameBuilder::CullingMode::Bvh,
+          FrameBuilder::CullingMode::Temporal,
+          FrameBuilder::CullingMode::Octree};
+     for (const auto mode : modes)
+     {
+          FrameBuilder builder(MakeSettings(mode), threadPool, arena);
+          builder.SetCubes(cubes, meshBounds, cubeVertices, 24, sizeof(Vertex), cubeIndices, 36);
+          CHECK(cubes.GetSize() == builder.GetCubeNumber());
+          std::size_t visibleTotal = 0;
+          for (int frame = 0; frame < frameNumber; ++frame)
+          {
+               // Camera leaves the grid every 10 frames and sees most of it
+               SetCamera(frame, 0 == frame % 10 ? 150.0f : 30.0f, packet);
+               arena.Reset();
+               builder.BuildEntries(packet);
+
+               const bool spheres = FrameBuilder::CullingMode::Temporal == mode || FrameBuilder::CullingMode::Octree == mode;
+               const std::vector<std::uint32_t> expected = spheres ? BruteForceSpheres(builder) : BruteForceBoxes(builder);
+               std::vector<std::uint32_t> visible = packet.visibleEntries;
+               // Batch culling keeps index order, the other structures visit cubes in their own order
+               if (FrameBuilder::CullingMode::Batch != mode)
+                    std::sort(visible.begin(), visible.end());
+               CHECK(expected == visible);
+               visibleTotal += visible.size();
+          }
+          CHECK(0 < visibleTotal && visibleTotal < frameNumber * cubes.GetSize());
+     }
+
+     // Contribution culling keeps cubes above the return threshold and drops those below the keep one
+     {
+          FrameBuilder::Settings settings = MakeSettings(FrameBuilder::CullingMode::Batch);
+          settings.useContributionCulling = true;
+          settings.minPixelRadius = 20.0f;
+          FrameBuilder builder(settings, threadPool, arena);
+          builder.SetCubes(cubes, meshBounds, cubeVertices, 24, sizeof(Vertex), cubeIndices, 36);
+          std::size_t droppedTotal = 0;
+          for (int frame = 0; frame < frameNumber; ++frame)
+          {
+               SetCamera(frame, 0 == frame % 10 ? 150.0f : 30.0f, packet);
+               arena.Reset();
+               builder.BuildEntries(packet);
+               const std::vector<std::uint32_t> frustumVisible = BruteForceBoxes(builder);
+               CHECK(IsSubsequence(packet.visibleEntries, frustumVisible));
+               for (const std::uint32_t index : frustumVisible)
+               {
+                    const float pixelRadius = ProjectedRadius(builder, packet.pov, index);
+                    const bool kept = std::find(packet.visibleEntries.begin(), packet.visibleEntries.end(), index) != packet.visibleEntries.end();
+                    if (pixelRadius >= settings.minPixelRadius * 1.21f)
+                         CHECK(kept);
+                    if (pixelRadius < settings.minPixelRadius * 0.99f)
+                         CHECK(!kept);
+               }
+               droppedTotal += frustumVisible.size() - packet.visibleEntries.size();
+          }
+          CHECK(0 < droppedTotal);
+     }
+
+     // Occlusion culling only removes entries, and a dense block of stacked cubes hides its inside
+     {
+          InstanceStorage blockCubes;
+          for (int i = 0; i < 16; ++i)
+               for (int j = 0; j < 16; ++j)
+                    for (int k = 0; k < 4; ++k)
+                         blockCubes.Add(DirectX::XMFLOAT3(i - 7.5f, k - 1.5f, j - 7.5f), speed(random), 100.0f, 0, false);
+          FrameBuilder::Settings settings = MakeSettings(FrameBuilder::CullingMode::Bvh);
+          settings.useOcclusionCulling = true;
+          settings.maxOccluderNumber = 64;
+          FrameBuilder builder(settings, threadPool, arena);
+          builder.SetCubes(blockCubes, meshBounds, cubeVertices, 24, sizeof(Vertex), cubeIndices, 36);
+          FrameBuilder reference(MakeSettings(FrameBuilder::CullingMode::Bvh), threadPool, arena);
+          reference.SetCubes(blockCubes, meshBounds, cubeVertices, 24, sizeof(Vertex), cubeIndices, 36);
+          std::size_t occludedTotal = 0;
+          for (int frame = 0; frame < frameNumber; ++frame)
+          {
+               SetCamera(frame, 14.0f, packet);
+               arena.Reset();
+               reference.BuildEntries(packet);
+               const std::vector<std::uint32_t> frustumVisible = packet.visibleEntries;
+               builder.BuildEntries(packet);
+               CHECK(IsSubsequence(packet.visibleEntries, frustumVisible));
+               occludedTotal += frustumVisible.size() - packet.visibleEntries.size();
+          }
+          CHECK(0 < occludedTotal);
+     }
+
+     // PVS toggled at runtime over a small static layout: baked on the first enable, then it only removes
+     // entries, and nothing outside of its region
+     {
+          InstanceStorage smallCubes;
+          for (int i = 0; i < 5; ++i)
+               for (int j = 0; j < 5; ++j)
+                    smallCubes.Add(DirectX::XMFLOAT3(i * 1.5f, 0.0f, j * 1.5f), speed(random), 100.0f, 0, false);
+          FrameBuilder builder(MakeSettings(FrameBuilder::CullingMode::Batch), threadPool, arena);
+          builder.SetCubes(smallCubes, meshBounds, cubeVertices, 24, sizeof(Vertex), cubeIndices, 36);
+          CHECK(!builder.IsPvsEnabled());
+          for (int frame = 0; frame < frameNumber; ++frame)
+          {
+               if (10 == frame || 30 == frame)
+                    builder.SetPvsEnabled(10 == frame);
+               SetCamera(frame, 0 == frame % 10 ? 150.0f : 5.0f, packet);
+               arena.Reset();
+               builder.BuildEntries(packet);
+               const std::vector<std::uint32_t> frustumVisible = BruteForceBoxes(builder);
+               CHECK(IsSubsequence(packet.visibleEntries, frustumVisible));
+               if (!builder.IsPvsEnabled() || 0 == frame % 10)
+                    CHECK(frustumVisible == packet.visibleEntries);
+          }
+          CHECK(!builder.IsPvsEnabled());
+     }
+
+     return CheckResult();
+}
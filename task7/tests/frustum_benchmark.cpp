@@ -0,0 +1,89 @@
+#include "frustum.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Batch CheckRectangles against the scalar CheckRectangle loop over the same boxes for 10^3 to 10^6 boxes,
+// median of repeated runs with the camera turning between them
+int main()
+{
+     const int runNumber = 21;
+     std::printf("%10s %10s %12s %12s %8s\n", "boxes", "visible", "batch ms", "scalar ms", "speedup");
+     for (std::size_t count : {1000, 10000, 100000, 1000000})
+     {
+          std::mt19937 random(1);
+          std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+          std::uniform_real_distribution<float> extent(0.1f, 1.0f);
+          std::vector<float> bounds[6];
+          for (auto &component : bounds)
+               component.resize(count);
+          for (std::size_t i = 0; i < count; ++i)
+          {
+               for (int axis = 0; axis < 3; ++axis)
+               {
+                    const float center = coordinate(random);
+                    const float halfSize = extent(random);
+                    bounds[axis][i] = center - halfSize;
+                    bounds[axis + 3][i] = center + halfSize;
+               }
+          }
+
+          Frustum frustum(0.1f);
+          std::vector<std::uint32_t> visible(count);
+          std::vector<std::uint32_t> scalarVisible(count);
+          std::vector<double> batchTimes;
+          std::vector<double> scalarTimes;
+          std::size_t visibleNumber = 0;
+          bool same = true;
+          for (int run = 0; run < runNumber; ++run)
+          {
+               const float angle = run * 0.3f;
+               frustum.Construct(
+                    DirectX::XMMatrixLookAtLH(
+                         DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
+                         DirectX::XMVectorSet(std::cos(angle), 0.0f, std::sin(angle), 0.0f),
+                         DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+                    DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f));
+
+               const auto start = std::chrono::steady_clock::now();
+               visibleNumber = frustum.CheckRectangles(
+                    bounds[0].data(),
+                    bounds[1].data(),
+                    bounds[2].data(),
+                    bounds[3].data(),
+                    bounds[4].data(),
+                    bounds[5].data(),
+                    count,
+                    visible.data());
+               const auto middle = std::chrono::steady_clock::now();
+               std::size_t scalarVisibleNumber = 0;
+               for (std::size_t i = 0; i < count; ++i)
+               {
+                    if (frustum.CheckRectangle(bounds[3][i], bounds[4][i], bounds[5][i], bounds[0][i], bounds[1][i], bounds[2][i]))
+                         scalarVisible[scalarVisibleNumber++] = static_cast<std::uint32_t>(i);
+               }
+               const auto end = std::chrono::steady_clock::now();
+               batchTimes.push_back(std::chrono::duration<double, std::milli>(middle - start).count());
+               scalarTimes.push_back(std::chrono::duration<double, std::milli>(end - middle).count());
+               same = same && visibleNumber == scalarVisibleNumber &&
+                    std::equal(visible.begin(), visible.begin() + visibleNumber, scalarVisible.begin());
+          }
+          std::nth_element(batchTimes.begin(), batchTimes.begin() + runNumber / 2, batchTimes.end());
+          std::nth_element(scalarTimes.begin(), scalarTimes.begin() + runNumber / 2, scalarTimes.end());
+          const double batchTime = batchTimes[runNumber / 2];
+          const double scalarTime = scalarTimes[runNumber / 2];
+          std::printf(
+               "%10zu %10zu %12.3f %12.3f %7.2fx%s\n",
+               count,
+               visibleNumber,
+               batchTime,
+               scalarTime,
+               scalarTime / batchTime,
+               same ? "" : " (results differ)");
+     }
+     return 0;
+}
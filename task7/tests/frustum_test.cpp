@@ -0,0 +1,66 @@
+#include "check.h"
+#include "frustum.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// SIMD batch test of Frustum::CheckRectangles against the scalar CheckRectangle, on random views and boxes
+int main()
+{
+     std::mt19937 random(1);
+     std::uniform_real_distribution<float> coordinate(-30.0f, 30.0f);
+     std::uniform_real_distribution<float> extent(0.01f, 3.0f);
+
+     Frustum frustum(0.1f);
+     std::size_t visibleTotal = 0;
+     for (int view = 0; view < 200; ++view)
+     {
+          const DirectX::XMVECTOR eye = DirectX::XMVectorSet(coordinate(random), coordinate(random), coordinate(random), 0.0f);
+          frustum.Construct(
+               DirectX::XMMatrixLookAtLH(eye, DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f), DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+               DirectX::XMMatrixPerspectiveFovLH(1.0f, 1.7f, 100.0f, 0.1f));
+
+          // Odd count covers the scalar tail, every 7th box is inverted
+          const std::size_t count = 1003;
+          std::vector<float> bounds[6];
+          for (auto &component : bounds)
+               component.resize(count);
+          for (std::size_t i = 0; i < count; ++i)
+          {
+               for (int axis = 0; axis < 3; ++axis)
+               {
+                    const float center = coordinate(random);
+                    const float halfSize = extent(random);
+                    bounds[axis][i] = center - halfSize;
+                    bounds[axis + 3][i] = center + halfSize;
+                    if (0 == i % 7)
+                         std::swap(bounds[axis][i], bounds[axis + 3][i]);
+               }
+          }
+
+          std::vector<std::uint32_t> visible(count);
+          const std::size_t visibleNumber = frustum.CheckRectangles(
+               bounds[0].data(),
+               bounds[1].data(),
+               bounds[2].data(),
+               bounds[3].data(),
+               bounds[4].data(),
+               bounds[5].data(),
+               count,
+               visible.data());
+          visible.resize(visibleNumber);
+
+          std::vector<std::uint32_t> expected;
+          for (std::size_t i = 0; i < count; ++i)
+          {
+               if (frustum.CheckRectangle(bounds[3][i], bounds[4][i], bounds[5][i], bounds[0][i], bounds[1][i], bounds[2][i]))
+                    expected.push_back(static_cast<std::uint32_t>(i));
+          }
+          CHECK(expected == visible);
+          visibleTotal += visible.size();
+     }
+     CHECK(0 < visibleTotal);
+     return CheckResult();
+}
@@ -0,0 +1,84 @@
+#include "bounding_volume.h"
+#include "frame_arena.h"
+#include "frustum.h"
+#include "instance_storage.h"
+#include "parallel_culling.h"
+#include "thread_pool.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Update-equivalent work over structure-of-arrays instances: chunked frustum culling on the thread pool and
+// compaction of the visible list, median of repeated frames for 10^4 to 10^6 instances
+int main()
+{
+     const std::size_t chunkSize = 1024;
+     const int frameNumber = 21;
+     ThreadPool threadPool;
+     std::printf("%10s %10s %12s\n", "instances", "visible", "update ms");
+     for (std::size_t count : {10000, 100000, 1000000})
+     {
+          std::mt19937 random(12);
+          const float extent = std::sqrt(static_cast<float>(count)) * 0.5f;
+          std::uniform_real_distribution<float> coordinate(-extent, extent);
+          std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+          InstanceStorage storage;
+          for (std::size_t i = 0; i < count; ++i)
+               storage.Add(DirectX::XMFLOAT3(coordinate(random), coordinate(random) * 0.1f, coordinate(random)), speed(random), 8.0f, 0, false);
+
+          // Spin does not change bounds, they are computed once as in the renderer
+          const Sphere spinSphere = SpinSphere(Sphere{DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), 0.87f});
+          std::vector<float> bounds[6];
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               bounds[axis].resize(count);
+               bounds[axis + 3].resize(count);
+               for (std::size_t i = 0; i < count; ++i)
+               {
+                    bounds[axis][i] = storage.GetPositions(axis)[i] - spinSphere.radius;
+                    bounds[axis + 3][i] = storage.GetPositions(axis)[i] + spinSphere.radius;
+               }
+          }
+
+          Frustum frustum(0.1f);
+          FrameArena arena(4096);
+          std::vector<std::uint32_t> visible(count);
+          std::vector<double> times;
+          std::size_t visibleNumber = 0;
+          for (int frame = 0; frame < frameNumber; ++frame)
+          {
+               const float angle = frame * 0.3f;
+               frustum.Construct(
+                    DirectX::XMMatrixLookAtLH(
+                         DirectX::XMVectorSet(0.0f, 2.0f, 0.0f, 0.0f),
+                         DirectX::XMVectorSet(std::cos(angle), 2.0f, std::sin(angle), 0.0f),
+                         DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+                    DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f));
+
+               const auto start = std::chrono::steady_clock::now();
+               arena.Reset();
+               visibleNumber = CheckRectanglesParallel(
+                    frustum,
+                    bounds[0].data(),
+                    bounds[1].data(),
+                    bounds[2].data(),
+                    bounds[3].data(),
+                    bounds[4].data(),
+                    bounds[5].data(),
+                    count,
+                    chunkSize,
+                    threadPool,
+                    arena,
+                    visible.data());
+               times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+          }
+          std::nth_element(times.begin(), times.begin() + frameNumber / 2, times.end());
+          std::printf("%10zu %10zu %12.3f\n", count, visibleNumber, times[frameNumber / 2]);
+     }
+     return 0;
+}
@@ -0,0 +1,83 @@
+#include "check.h"
+#include "instance_storage.h"
+
+#include <directxmath.h>
+#include <map>
+#include <random>
+
+namespace
+{
+
+     struct Instance
+     {
+          DirectX::XMFLOAT3 position;
+          float rotationSpeed;
+          float shininess;
+          std::uint32_t textureId;
+          bool normalMap;
+     };
+
+     // Every live handle maps to an index whose components hold the instance, and back
+     bool Matches(const InstanceStorage &storage, const std::map<std::uint32_t, Instance> &instances)
+     {
+          if (storage.GetSize() != instances.size())
+               return false;
+          for (const auto &pair : instances)
+          {
+               const std::uint32_t index = storage.GetIndex(pair.first);
+               const Instance &instance = pair.second;
+               if (index >= storage.GetSize() || storage.GetHandle(index) != pair.first ||
+                    storage.GetPositions(0)[index] != instance.position.x ||
+                    storage.GetPositions(1)[index] != instance.position.y ||
+                    storage.GetPositions(2)[index] != instance.position.z ||
+                    storage.GetRotationSpeeds()[index] != instance.rotationSpeed ||
+                    storage.GetShininess()[index] != instance.shininess ||
+                    storage.GetTextureIds()[index] != instance.textureId ||
+                    (0 != storage.GetNormalMaps()[index]) != instance.normalMap)
+                    return false;
+          }
+          return true;
+     }
+
+}
+
+// Random adds and removes against a map of live handles: handles stay valid, components stay dense
+int main()
+{
+     std::mt19937 random(12);
+     std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+
+     InstanceStorage storage;
+     std::map<std::uint32_t, Instance> instances;
+     for (int step = 0; step < 20000; ++step)
+     {
+          if (instances.empty() || 0 != random() % 3)
+          {
+               const Instance instance = {
+                    DirectX::XMFLOAT3(value(random), value(random), value(random)),
+                    value(random),
+                    value(random),
+                    static_cast<std::uint32_t>(random() % 3),
+                    0 == random() % 2};
+               const std::uint32_t handle = storage.Add(instance.position, instance.rotationSpeed, instance.shininess, instance.textureId, instance.normalMap);
+               CHECK(InstanceStorage::invalidHandle != handle);
+               CHECK(0 == instances.count(handle));
+               instances[handle] = instance;
+          }
+          else
+          {
+               auto it = instances.begin();
+               std::advance(it, random() % instances.size());
+               storage.Remove(it->first);
+               instances.erase(it);
+          }
+          if (0 == step % 1000)
+               CHECK(Matches(storage, instances));
+     }
+     CHECK(Matches(storage, instances));
+
+     storage.Clear();
+     CHECK(0 == storage.GetSize());
+     CHECK(0 == storage.Add(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f, 0.0f, 0, false));
+     return CheckResult();
+}
@@ -0,0 +1,141 @@
+#include "check.h"
+#include "instance_transform.h"
+#include "simd_sincos.h"
+
+#include <directxmath.h>
+#include <directxpackedvector.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+     // Matrix followed by other data, so the kernel's stride differs from the matrix size
+     struct StridedMatrix
+     {
+          DirectX::XMFLOAT4X4 world;
+          float padding[3];
+     };
+
+     double GetMaxError(const DirectX::XMFLOAT4X4 &matrix, const DirectX::XMFLOAT4X4 &expected)
+     {
+          double error = 0.0;
+          for (int row = 0; row < 4; ++row)
+               for (int column = 0; column < 4; ++column)
+                    error = std::max(error, static_cast<double>(std::fabs(matrix.m[row][column] - expected.m[row][column])));
+          return error;
+     }
+
+}
+
+// Batch spin transforms against DirectXMath for every tail length, with and without indices,
+// the SIMD sine and cosine against double precision and material packing
+int main()
+{
+     std::mt19937 random(13);
+     std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+     std::uniform_real_distribution<float> speed(-4.0f, 4.0f);
+
+     for (std::size_t count : {1, 3, 4, 5, 7, 8, 9, 13, 1000})
+     {
+          std::vector<float> positions[3];
+          std::vector<float> speeds(count);
+          std::vector<std::uint32_t> indices(count);
+          for (auto &component : positions)
+               component.resize(count);
+          for (std::size_t i = 0; i < count; ++i)
+          {
+               for (auto &component : positions)
+                    component[i] = coordinate(random);
+               speeds[i] = speed(random);
+               indices[i] = static_cast<std::uint32_t>(random() % count);
+          }
+
+          for (double time : {0.0, 1.234, 10.0, 1000000.0, 31536000.0})
+          {
+               for (bool useIndices : {false, true})
+               {
+                    const std::uint32_t *pIndices = useIndices ? indices.data() : nullptr;
+                    std::vector<StridedMatrix> matrices(count);
+                    ComputeSpinWorldMatrices(
+                         positions[0].data(),
+                         positions[1].data(),
+                         positions[2].data(),
+                         speeds.data(),
+                         time,
+                         pIndices,
+                         count,
+                         &matrices[0].world,
+                         sizeof(StridedMatrix));
+
+                    double error = 0.0;
+                    for (std::size_t k = 0; k < count; ++k)
+                    {
+                         const std::size_t i = useIndices ? indices[k] : k;
+                         DirectX::XMFLOAT4X4 expected;
+                         DirectX::XMStoreFloat4x4(
+                              &expected,
+                              DirectX::XMMatrixMultiply(
+                                   DirectX::XMMatrixRotationY(static_cast<float>(std::fmod(speeds[i] * time, 6.283185307179586))),
+                                   DirectX::XMMatrixTranslation(positions[0][i], positions[1][i], positions[2][i])));
+                         error = std::max(error, GetMaxError(matrices[k].world, expected));
+                    }
+                    CHECK(error < 1e-5);
+               }
+          }
+     }
+
+     // Absolute error of sine and cosine over the range used by the renderer
+     std::uniform_real_distribution<float> angle(-8192.0f, 8192.0f);
+     double sinCosError = 0.0;
+     for (int i = 0; i < 100000; ++i)
+     {
+          float angles[8];
+          for (float &value : angles)
+               value = angle(random);
+          float sines[8];
+          float cosines[8];
+          __m128 sin, cos;
+          SinCos4(_mm_loadu_ps(angles), sin, cos);
+          _mm_storeu_ps(sines, sin);
+          _mm_storeu_ps(cosines, cos);
+          SinCos4(_mm_loadu_ps(angles + 4), sin, cos);
+          _mm_storeu_ps(sines + 4, sin);
+          _mm_storeu_ps(cosines + 4, cos);
+          for (int lane = 0; lane < 8; ++lane)
+          {
+               sinCosError = std::max(sinCosError, std::fabs(sines[lane] - std::sin(static_cast<double>(angles[lane]))));
+               sinCosError = std::max(sinCosError, std::fabs(cosines[lane] - std::cos(static_cast<double>(angles[lane]))));
+          }
+#if defined(__AVX2__)
+          __m256 sin8, cos8;
+          SinCos8(_mm256_loadu_ps(angles), sin8, cos8);
+          float sines8[8];
+          float cosines8[8];
+          _mm256_storeu_ps(sines8, sin8);
+          _mm256_storeu_ps(cosines8, cos8);
+          for (int lane = 0; lane < 8; ++lane)
+          {
+               sinCosError = std::max(sinCosError, std::fabs(sines8[lane] - std::sin(static_cast<double>(angles[lane]))));
+               sinCosError = std::max(sinCosError, std::fabs(cosines8[lane] - std::cos(static_cast<double>(angles[lane]))));
+          }
+#endif
+     }
+     CHECK(sinCosError < 2e-7);
+
+     // Material bit fields read by geom_buffer.hlsli
+     for (const std::uint32_t textureId : {0u, 1u, 2u, 0x7FFFu})
+          for (const float shininess : {0.0f, 1.0f, 32.0f, 300.0f, 1000.0f})
+               for (const bool normalMap : {false, true})
+               {
+                    const std::uint32_t material = PackMaterial(textureId, normalMap, shininess);
+                    CHECK(textureId == (material & 0x7FFF));
+                    CHECK(normalMap == (0 != (material & 0x8000)));
+                    const float unpacked = DirectX::PackedVector::XMConvertHalfToFloat(static_cast<DirectX::PackedVector::HALF>(material >> 16));
+                    CHECK(std::fabs(unpacked - shininess) <= shininess / 1024.0f);
+               }
+     return CheckResult();
+}
@@ -0,0 +1,114 @@
+#include "check.h"
+#include "fake_upload_ring_backend.h"
+#include "frame_arena.h"
+#include "frustum.h"
+#include "instance_storage.h"
+#include "instance_transform.h"
+#include "parallel_culling.h"
+#include "thread_pool.h"
+#include "upload_ring.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// 10^5 resident instances: records are built from the component arrays once, then every frame chunked culling
+// produces the visible index list which is written into the upload ring, with no limit on instance number
+int main()
+{
+     const std::size_t count = 100000;
+     const std::size_t chunkSize = 1024;
+     std::mt19937 random(11);
+     std::uniform_real_distribution<float> coordinate(-150.0f, 150.0f);
+     std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+
+     InstanceStorage storage;
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          const DirectX::XMFLOAT3 position(coordinate(random), coordinate(random) * 0.1f, coordinate(random));
+          storage.Add(position, speed(random), 8.0f, static_cast<std::uint32_t>(i % 3), 0 == i % 2);
+     }
+     CHECK(count == storage.GetSize());
+
+     // Layout of geom_buffer.hlsli: float4 placement, uint material
+     CHECK(20 == sizeof(SpinInstance));
+     std::vector<SpinInstance> residentInstances(storage.GetSize());
+     for (std::size_t i = 0; i < residentInstances.size(); ++i)
+     {
+          residentInstances[i].placement = DirectX::XMFLOAT4(
+               storage.GetPositions(0)[i],
+               storage.GetPositions(1)[i],
+               storage.GetPositions(2)[i],
+               storage.GetRotationSpeeds()[i]);
+          residentInstances[i].material = PackMaterial(storage.GetTextureIds()[i], 0 != storage.GetNormalMaps()[i], storage.GetShininess()[i]);
+     }
+     CHECK(residentInstances[count - 1].placement.w == storage.GetRotationSpeeds()[count - 1]);
+     CHECK((residentInstances[1].material & 0x8000) == 0 && (residentInstances[2].material & 0x8000) != 0);
+
+     // Bounds of unit cubes spinning around their centers
+     const float halfSize = 0.87f;
+     std::vector<float> bounds[6];
+     for (int axis = 0; axis < 3; ++axis)
+     {
+          bounds[axis].resize(count);
+          bounds[axis + 3].resize(count);
+          for (std::size_t i = 0; i < count; ++i)
+          {
+               bounds[axis][i] = storage.GetPositions(axis)[i] - halfSize;
+               bounds[axis + 3][i] = storage.GetPositions(axis)[i] + halfSize;
+          }
+     }
+
+     const std::size_t ringCapacity = 1 << 20;
+     FakeUploadRingBackend backend(ringCapacity);
+     UploadRing ring(backend, ringCapacity);
+     ThreadPool threadPool(4);
+     Frustum frustum(0.1f);
+     FrameArena arena(4096);
+     std::vector<std::uint32_t> visible(count);
+     for (int frame = 0; frame < 60; ++frame)
+     {
+          // Camera from far away sees every instance on some frames
+          const float distance = 0 == frame % 10 ? 600.0f : 20.0f;
+          const float angle = frame * 0.1f;
+          frustum.Construct(
+               DirectX::XMMatrixLookAtLH(
+                    DirectX::XMVectorSet(std::cos(angle) * distance, distance * 0.5f, std::sin(angle) * distance, 0.0f),
+                    DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
+                    DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+               DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3, 16.0f / 9.0f, 1000.0f, 0.1f));
+
+          arena.Reset();
+          const std::size_t visibleNumber = CheckRectanglesParallel(
+               frustum,
+               bounds[0].data(),
+               bounds[1].data(),
+               bounds[2].data(),
+               bounds[3].data(),
+               bounds[4].data(),
+               bounds[5].data(),
+               count,
+               chunkSize,
+               threadPool,
+               arena,
+               visible.data());
+          if (0 == frame % 10)
+               CHECK(count == visibleNumber);
+
+          ring.BeginFrame();
+          unsigned offset = 0;
+          std::uint32_t *entries = ring.Allocate<std::uint32_t>(visibleNumber, offset);
+          CHECK(nullptr != entries);
+          if (nullptr != entries)
+          {
+               std::copy(visible.begin(), visible.begin() + visibleNumber, entries);
+               ring.Unmap();
+               CHECK(std::equal(visible.begin(), visible.begin() + visibleNumber, reinterpret_cast<const std::uint32_t *>(backend.memory.data() + offset)));
+          }
+          ring.EndFrame();
+     }
+     CHECK(!backend.doubleMapped);
+     return CheckResult();
+}
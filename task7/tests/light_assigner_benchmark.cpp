@@ -0,0 +1,137 @@
+#include "light_assigner.h"
+#include "light_falloff.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+     std::uint32_t GetLight(const PackedLightIndices &packed, const unsigned slot)
+     {
+          return (packed.words[slot / 2] >> (16 * (slot % 2))) & 0xFFFF;
+     }
+
+     template <typename Work>
+     double Median(const int runNumber, Work &&work)
+     {
+          std::vector<double> times;
+          for (int run = 0; run < runNumber; ++run)
+          {
+               const auto start = std::chrono::steady_clock::now();
+               work();
+               times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+          }
+          std::nth_element(times.begin(), times.begin() + runNumber / 2, times.end());
+          return times[runNumber / 2];
+     }
+
+}
+
+// Grid build and assignment of the top 4 lights for 10^4 instances and 10^3 lights against brute force ranking
+// of every light for every instance, for dense, medium and sparse scenes, median of repeated runs
+int main()
+{
+     const std::size_t lightNumber = 1000;
+     const std::size_t instanceNumber = 10000;
+     const unsigned slotNumber = LightAssigner::lightsPerInstance;
+     std::printf("%8s %10s %10s %12s %12s %8s %10s\n", "extent", "assigned", "build ms", "assign ms", "brute ms", "speedup", "mismatch");
+     for (const float extent : {40.0f, 100.0f, 300.0f})
+     {
+          std::mt19937 random(24);
+          std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+          std::vector<DirectX::XMFLOAT4> lights(lightNumber);
+          std::vector<DirectX::XMFLOAT4> colors(lightNumber);
+          std::vector<float> intensities(lightNumber);
+          for (std::size_t i = 0; i < lightNumber; ++i)
+          {
+               intensities[i] = 0.05f + unit(random) * (0 == i % 50 ? 20.0f : 1.0f);
+               colors[i] = DirectX::XMFLOAT4(intensities[i] * unit(random), intensities[i], intensities[i] * unit(random), 1.0f);
+               lights[i] = DirectX::XMFLOAT4(
+                    (unit(random) - 0.5f) * extent,
+                    (unit(random) - 0.5f) * extent * 0.3f,
+                    (unit(random) - 0.5f) * extent,
+                    ComputeLightRadius(intensities[i], 1.0f / 256.0f));
+          }
+          std::vector<float> x(instanceNumber);
+          std::vector<float> y(instanceNumber);
+          std::vector<float> z(instanceNumber);
+          std::vector<float> radius(instanceNumber);
+          std::vector<std::uint32_t> indices(instanceNumber);
+          for (std::size_t i = 0; i < instanceNumber; ++i)
+          {
+               x[i] = (unit(random) - 0.5f) * extent;
+               y[i] = (unit(random) - 0.5f) * extent * 0.3f;
+               z[i] = (unit(random) - 0.5f) * extent;
+               radius[i] = 0.87f;
+               indices[i] = static_cast<std::uint32_t>(i);
+          }
+
+          // Intensity of the light at the closest point of the instance sphere
+          const auto score = [&](const std::size_t light, const std::size_t instance)
+          {
+               const float dx = lights[light].x - x[instance];
+               const float dy = lights[light].y - y[instance];
+               const float dz = lights[light].z - z[instance];
+               const float distance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - radius[instance], 0.0f);
+               return distance >= lights[light].w ? 0.0f : intensities[light] * ComputeLightAttenuation(distance, lights[light].w);
+          };
+
+          LightAssigner assigner;
+          std::vector<PackedLightIndices> assigned(instanceNumber);
+          const double buildTime = Median(21, [&]() { assigner.Build(lights.data(), colors.data(), lightNumber, 0.87f); });
+          const double assignTime = Median(
+               21,
+               [&]() { assigner.Assign(x.data(), y.data(), z.data(), radius.data(), indices.data(), instanceNumber, assigned.data()); });
+
+          // Brute force keeps the strongest lights of every instance by insertion into a short sorted list
+          std::vector<float> bruteScores(instanceNumber * slotNumber);
+          const double bruteTime = Median(
+               5,
+               [&]()
+               {
+                    for (std::size_t instance = 0; instance < instanceNumber; ++instance)
+                    {
+                         float *best = &bruteScores[instance * slotNumber];
+                         std::fill(best, best + slotNumber, 0.0f);
+                         for (std::size_t light = 0; light < lightNumber; ++light)
+                         {
+                              const float value = score(light, instance);
+                              if (value <= best[slotNumber - 1])
+                                   continue;
+                              unsigned slot = slotNumber - 1;
+                              for (; 0 < slot && best[slot - 1] < value; --slot)
+                                   best[slot] = best[slot - 1];
+                              best[slot] = value;
+                         }
+                    }
+               });
+
+          std::size_t mismatchNumber = 0;
+          std::size_t lightsPerInstance = 0;
+          for (std::size_t instance = 0; instance < instanceNumber; ++instance)
+               for (unsigned slot = 0; slot < slotNumber; ++slot)
+               {
+                    const std::uint32_t light = GetLight(assigned[instance], slot);
+                    const float actual = LightAssigner::noLight == light ? 0.0f : score(light, instance);
+                    const float expected = bruteScores[instance * slotNumber + slot];
+                    mismatchNumber += std::fabs(actual - expected) > 1e-6f * std::max(expected, 1.0f) ? 1 : 0;
+                    lightsPerInstance += LightAssigner::noLight == light ? 0 : 1;
+               }
+          std::printf(
+               "%8.0f %10.2f %10.3f %12.3f %12.3f %7.2fx %10zu\n",
+               extent,
+               lightsPerInstance / static_cast<double>(instanceNumber),
+               buildTime,
+               assignTime,
+               bruteTime,
+               bruteTime / (buildTime + assignTime),
+               mismatchNumber);
+     }
+     return 0;
+}
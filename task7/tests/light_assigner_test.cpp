@@ -0,0 +1,118 @@
+#include "check.h"
+#include "light_assigner.h"
+#include "light_falloff.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+     std::uint32_t GetLight(const PackedLightIndices &packed, const unsigned slot)
+     {
+          return (packed.words[slot / 2] >> (16 * (slot % 2))) & 0xFFFF;
+     }
+
+}
+
+// Top 4 lights of every instance against brute force ranking over all lights, for dense, sparse,
+// dim and mostly global light sets
+int main()
+{
+     std::mt19937 random(24);
+     std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+     const std::size_t lightNumber = 1000;
+     const std::size_t instanceNumber = 2000;
+     const float extents[] = { 100.0f, 40.0f, 300.0f, 100.0f, 100.0f };
+
+     std::size_t mismatchNumber = 0;
+     std::size_t duplicateNumber = 0;
+     std::size_t singleMismatchNumber = 0;
+     std::size_t assignedNumber = 0;
+     for (int scene = 0; scene < 5; ++scene)
+     {
+          const float extent = extents[scene];
+          const float scale = 3 <= scene ? 0.1f : 1.0f;
+          std::vector<DirectX::XMFLOAT4> lights(lightNumber);
+          std::vector<DirectX::XMFLOAT4> colors(lightNumber);
+          for (std::size_t i = 0; i < lightNumber; ++i)
+          {
+               float intensity = (0.05f + unit(random) * (0 == i % 50 ? 20.0f : 1.0f)) * scale;
+               if (4 == scene)
+                    intensity = 0.02f + unit(random) * 0.1f;
+               colors[i] = DirectX::XMFLOAT4(intensity * unit(random), intensity, -intensity * unit(random), 1.0f);
+               lights[i] = DirectX::XMFLOAT4(
+                    (unit(random) - 0.5f) * extent,
+                    (unit(random) - 0.5f) * extent * 0.3f,
+                    (unit(random) - 0.5f) * extent,
+                    ComputeLightRadius(intensity, 1.0f / 256.0f));
+          }
+          // Inactive light
+          lights[3].w = 0.0f;
+
+          std::vector<float> x(instanceNumber);
+          std::vector<float> y(instanceNumber);
+          std::vector<float> z(instanceNumber);
+          std::vector<float> radius(instanceNumber);
+          std::vector<std::uint32_t> indices(instanceNumber);
+          for (std::size_t i = 0; i < instanceNumber; ++i)
+          {
+               x[i] = (unit(random) - 0.5f) * extent;
+               y[i] = (unit(random) - 0.5f) * extent * 0.3f;
+               z[i] = (unit(random) - 0.5f) * extent;
+               radius[i] = 0.3f + unit(random) * 0.57f;
+               indices[i] = static_cast<std::uint32_t>(instanceNumber - 1 - i);
+          }
+
+          LightAssigner assigner;
+          assigner.Build(lights.data(), colors.data(), lightNumber, 0.87f);
+          std::vector<PackedLightIndices> assigned(instanceNumber);
+          assigner.Assign(x.data(), y.data(), z.data(), radius.data(), indices.data(), instanceNumber, assigned.data());
+
+          // Intensity of the light at the closest point of the instance sphere
+          const auto score = [&](const std::size_t light, const std::size_t instance)
+          {
+               const float dx = lights[light].x - x[instance];
+               const float dy = lights[light].y - y[instance];
+               const float dz = lights[light].z - z[instance];
+               const float distance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - radius[instance], 0.0f);
+               if (distance >= lights[light].w)
+                    return 0.0f;
+               const DirectX::XMFLOAT4 &color = colors[light];
+               const float intensity = std::max(std::max(std::fabs(color.x), std::fabs(color.y)), std::fabs(color.z));
+               return intensity * ComputeLightAttenuation(distance, lights[light].w);
+          };
+
+          std::vector<float> scores(lightNumber);
+          for (std::size_t k = 0; k < instanceNumber; ++k)
+          {
+               const std::size_t instance = indices[k];
+               for (std::size_t light = 0; light < lightNumber; ++light)
+                    scores[light] = score(light, instance);
+               std::partial_sort(scores.begin(), scores.begin() + LightAssigner::lightsPerInstance, scores.end(), std::greater<float>());
+
+               for (unsigned slot = 0; slot < LightAssigner::lightsPerInstance; ++slot)
+               {
+                    const std::uint32_t light = GetLight(assigned[k], slot);
+                    const float actual = LightAssigner::noLight == light ? 0.0f : score(light, instance);
+                    mismatchNumber += std::fabs(actual - scores[slot]) > 1e-6f * std::max(scores[slot], 1.0f) ? 1 : 0;
+                    assignedNumber += LightAssigner::noLight == light ? 0 : 1;
+                    for (unsigned other = slot + 1; other < LightAssigner::lightsPerInstance; ++other)
+                         duplicateNumber += LightAssigner::noLight != light && GetLight(assigned[k], other) == light ? 1 : 0;
+               }
+
+               const PackedLightIndices single = assigner.Assign(x[instance], y[instance], z[instance], radius[instance]);
+               singleMismatchNumber += single.words[0] != assigned[k].words[0] || single.words[1] != assigned[k].words[1] ? 1 : 0;
+          }
+     }
+     CHECK(0 == mismatchNumber);
+     CHECK(0 == duplicateNumber);
+     CHECK(0 == singleMismatchNumber);
+     CHECK(0 < assignedNumber);
+     return CheckResult();
+}
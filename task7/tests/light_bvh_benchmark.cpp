@@ -0,0 +1,135 @@
+#include "light_bvh.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+     const int runNumber = 11;
+
+     // Median time in milliseconds of repeated runs of work
+     template <typename Work>
+     double Median(Work &&work)
+     {
+          std::vector<double> times;
+          for (int run = 0; run < runNumber; ++run)
+          {
+               const auto start = std::chrono::steady_clock::now();
+               work();
+               times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+          }
+          std::nth_element(times.begin(), times.begin() + runNumber / 2, times.end());
+          return times[runNumber / 2];
+     }
+
+}
+
+// Point and box queries of the light BVH against a linear scan of the same light spheres for 10^2, 10^3 and 10^4
+// lights at constant density, so every query touches a similar number of lights while the scene grows. Times are
+// per query in microseconds, median of repeated runs: the tree grows with the depth, the scan with the count.
+int main()
+{
+     const std::size_t queryNumber = 1000;
+     const float queryHalfSize = 2.0f;
+     std::printf("%8s %8s %6s %10s %10s %8s %10s %10s %8s\n", "lights", "nodes", "hits", "point bvh", "point scan", "speedup", "box bvh", "box scan", "speedup");
+     for (std::size_t count : {100, 1000, 10000})
+     {
+          std::mt19937 random(25);
+          // Scene widens with the count and keeps its height
+          const float extent = std::sqrt(static_cast<float>(count)) * 2.0f;
+          std::uniform_real_distribution<float> coordinate(-extent, extent);
+          std::uniform_real_distribution<float> height(-5.0f, 5.0f);
+          std::uniform_real_distribution<float> radius(1.0f, 4.0f);
+          std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+          std::vector<DirectX::XMFLOAT4> lights(count);
+          std::vector<DirectX::XMFLOAT4> colors(count);
+          for (std::size_t i = 0; i < count; ++i)
+          {
+               lights[i] = DirectX::XMFLOAT4(coordinate(random), height(random), coordinate(random), radius(random));
+               colors[i] = DirectX::XMFLOAT4(unit(random), unit(random), unit(random), 1.0f);
+          }
+          LightBvh bvh;
+          bvh.Build(lights.data(), colors.data(), count);
+
+          std::vector<DirectX::XMFLOAT3> points(queryNumber);
+          for (auto &point : points)
+               point = DirectX::XMFLOAT3(coordinate(random), height(random), coordinate(random));
+
+          std::vector<std::uint32_t> found(count);
+          std::size_t bvhPointHits = 0;
+          std::size_t scanPointHits = 0;
+          const double bvhPoint = Median(
+               [&]()
+               {
+                    bvhPointHits = 0;
+                    for (const auto &point : points)
+                         bvhPointHits += bvh.QueryPoint(point.x, point.y, point.z, found.data());
+               });
+          const double scanPoint = Median(
+               [&]()
+               {
+                    scanPointHits = 0;
+                    for (const auto &point : points)
+                         for (std::size_t i = 0; i < count; ++i)
+                         {
+                              const float dx = lights[i].x - point.x;
+                              const float dy = lights[i].y - point.y;
+                              const float dz = lights[i].z - point.z;
+                              scanPointHits += dx * dx + dy * dy + dz * dz <= lights[i].w * lights[i].w ? 1 : 0;
+                         }
+               });
+
+          std::size_t bvhBoxHits = 0;
+          std::size_t scanBoxHits = 0;
+          const double bvhBox = Median(
+               [&]()
+               {
+                    bvhBoxHits = 0;
+                    for (const auto &point : points)
+                    {
+                         const float min[3] = {point.x - queryHalfSize, point.y - queryHalfSize, point.z - queryHalfSize};
+                         const float max[3] = {point.x + queryHalfSize, point.y + queryHalfSize, point.z + queryHalfSize};
+                         bvhBoxHits += bvh.QueryBox(min, max, found.data());
+                    }
+               });
+          const double scanBox = Median(
+               [&]()
+               {
+                    scanBoxHits = 0;
+                    for (const auto &point : points)
+                         for (std::size_t i = 0; i < count; ++i)
+                         {
+                              // Distance from light to the box, clamped to zero without branches (0.5 * (d + |d|))
+                              // so that the scan vectorizes
+                              const float ex = std::abs(lights[i].x - point.x) - queryHalfSize;
+                              const float ey = std::abs(lights[i].y - point.y) - queryHalfSize;
+                              const float ez = std::abs(lights[i].z - point.z) - queryHalfSize;
+                              const float dx = 0.5f * (ex + std::abs(ex));
+                              const float dy = 0.5f * (ey + std::abs(ey));
+                              const float dz = 0.5f * (ez + std::abs(ez));
+                              scanBoxHits += dx * dx + dy * dy + dz * dz <= lights[i].w * lights[i].w ? 1 : 0;
+                         }
+               });
+
+          const double perQuery = 1000.0 / queryNumber;
+          std::printf(
+               "%8zu %8zu %6.1f %10.3f %10.3f %7.2fx %10.3f %10.3f %7.2fx%s\n",
+               count,
+               bvh.GetNodeNumber(),
+               bvhBoxHits / static_cast<double>(queryNumber),
+               bvhPoint * perQuery,
+               scanPoint * perQuery,
+               scanPoint / bvhPoint,
+               bvhBox * perQuery,
+               scanBox * perQuery,
+               scanBox / bvhBox,
+               bvhPointHits == scanPointHits && bvhBoxHits == scanBoxHits ? "" : " (results differ)");
+     }
+     return 0;
+}
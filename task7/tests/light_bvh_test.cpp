@@ -0,0 +1,171 @@
+#include "check.h"
+#include "frustum.h"
+#include "light_bvh.h"
+#include "light_falloff.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+     float GetIntensity(const DirectX::XMFLOAT4 &color)
+     {
+          return std::max(std::max(std::fabs(color.x), std::fabs(color.y)), std::fabs(color.z));
+     }
+
+     float GetDistance(const DirectX::XMFLOAT4 &light, const float *point)
+     {
+          const float dx = light.x - point[0];
+          const float dy = light.y - point[1];
+          const float dz = light.z - point[2];
+          return std::sqrt(dx * dx + dy * dy + dz * dz);
+     }
+
+     std::vector<std::uint32_t> GetSorted(const std::vector<std::uint32_t> &lights, const std::size_t number)
+     {
+          std::vector<std::uint32_t> sorted(lights.begin(), lights.begin() + number);
+          std::sort(sorted.begin(), sorted.end());
+          return sorted;
+     }
+
+}
+
+// Box, point and frustum queries against brute force after build and after refit with moved lights,
+// root intensity and light sampling probabilities against sampled frequencies
+int main()
+{
+     std::mt19937 random(25);
+     std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+     std::size_t queryMismatchNumber = 0;
+     std::size_t sampleMismatchNumber = 0;
+     for (int iteration = 0; iteration < 40; ++iteration)
+     {
+          const std::size_t number = 0 == iteration ? 0 : (1 == iteration ? 1 : (iteration * 53) % 900 + 2);
+          std::vector<DirectX::XMFLOAT4> lights(number);
+          std::vector<DirectX::XMFLOAT4> colors(number);
+          for (std::size_t i = 0; i < number; ++i)
+          {
+               const float intensity = unit(random) * 2.0f - 0.5f;
+               colors[i] = DirectX::XMFLOAT4(intensity, unit(random), 0.0f, 1.0f);
+               lights[i] = DirectX::XMFLOAT4(
+                    (unit(random) - 0.5f) * 80.0f,
+                    (unit(random) - 0.5f) * 20.0f,
+                    (unit(random) - 0.5f) * 80.0f,
+                    0 == i % 17 ? 0.0f : std::fabs(intensity) * 6.0f + 0.5f);
+          }
+          LightBvh bvh;
+          bvh.Build(lights.data(), colors.data(), number);
+          CHECK(number == bvh.GetSize());
+
+          for (int phase = 0; phase < 2; ++phase)
+          {
+               if (1 == phase)
+               {
+                    for (std::size_t i = 0; i < number; ++i)
+                    {
+                         lights[i].x += (unit(random) - 0.5f) * 30.0f;
+                         lights[i].w *= unit(random) * 2.0f;
+                         colors[i].x = unit(random) - 0.3f;
+                    }
+                    bvh.Refit(lights.data(), colors.data());
+               }
+               if (0 < number)
+               {
+                    float intensity = 0.0f;
+                    for (const DirectX::XMFLOAT4 &color : colors)
+                         intensity += GetIntensity(color);
+                    CHECK(std::fabs(bvh.GetNodeIntensity(0) - intensity) <= 1e-3f * std::max(1.0f, intensity));
+               }
+
+               std::vector<std::uint32_t> found(number + 1);
+               std::vector<std::uint32_t> expected;
+               for (int query = 0; query < 30; ++query)
+               {
+                    const float min[3] = { (unit(random) - 0.5f) * 90.0f, (unit(random) - 0.5f) * 25.0f, (unit(random) - 0.5f) * 90.0f };
+                    const float max[3] = { min[0] + unit(random) * 10.0f, min[1] + unit(random) * 10.0f, min[2] + unit(random) * 10.0f };
+                    expected.clear();
+                    for (std::uint32_t i = 0; i < number; ++i)
+                    {
+                         const DirectX::XMFLOAT4 &light = lights[i];
+                         const float dx = std::max(std::max(min[0] - light.x, light.x - max[0]), 0.0f);
+                         const float dy = std::max(std::max(min[1] - light.y, light.y - max[1]), 0.0f);
+                         const float dz = std::max(std::max(min[2] - light.z, light.z - max[2]), 0.0f);
+                         if (0.0f < light.w && dx * dx + dy * dy + dz * dz <= light.w * light.w)
+                              expected.push_back(i);
+                    }
+                    queryMismatchNumber += expected != GetSorted(found, bvh.QueryBox(min, max, found.data())) ? 1 : 0;
+
+                    const float *point = min;
+                    expected.clear();
+                    for (std::uint32_t i = 0; i < number; ++i)
+                    {
+                         const float distance = GetDistance(lights[i], point);
+                         if (0.0f < lights[i].w && distance * distance <= lights[i].w * lights[i].w)
+                              expected.push_back(i);
+                    }
+                    queryMismatchNumber += expected != GetSorted(found, bvh.QueryPoint(point[0], point[1], point[2], found.data())) ? 1 : 0;
+
+                    Frustum frustum(100.0f);
+                    frustum.Construct(
+                         DirectX::XMMatrixLookAtLH(
+                              DirectX::XMVectorSet((unit(random) - 0.5f) * 40.0f, (unit(random) - 0.5f) * 10.0f, (unit(random) - 0.5f) * 40.0f, 1.0f),
+                              DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f),
+                              DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+                         DirectX::XMMatrixPerspectiveFovLH(1.0f, 1.6f, 100.0f, 0.1f));
+                    expected.clear();
+                    for (std::uint32_t i = 0; i < number; ++i)
+                         if (0.0f < lights[i].w && frustum.CheckSphere(DirectX::XMFLOAT3(lights[i].x, lights[i].y, lights[i].z), lights[i].w))
+                              expected.push_back(i);
+                    queryMismatchNumber += expected != GetSorted(found, bvh.QueryFrustum(frustum, found.data())) ? 1 : 0;
+
+                    // Stratified samples: reported probabilities are consistent, match frequencies and sum to one
+                    if (0 == number || 2 <= query)
+                         continue;
+                    const int sampleNumber = 20000;
+                    std::vector<float> probabilities(number, 0.0f);
+                    std::vector<int> counts(number, 0);
+                    int invalidNumber = 0;
+                    for (int sample = 0; sample < sampleNumber; ++sample)
+                    {
+                         float probability;
+                         const std::uint32_t light = bvh.SampleLight(point[0], point[1], point[2], (sample + 0.5f) / sampleNumber, probability);
+                         if (LightBvh::invalidLight == light)
+                         {
+                              ++invalidNumber;
+                              continue;
+                         }
+                         if (!(GetDistance(lights[light], point) < lights[light].w) || probability <= 0.0f)
+                              ++sampleMismatchNumber;
+                         if (0.0f == probabilities[light])
+                              probabilities[light] = probability;
+                         else if (std::fabs(probabilities[light] - probability) > 1e-5f * probability)
+                              ++sampleMismatchNumber;
+                         ++counts[light];
+                    }
+                    double probabilitySum = 0.0;
+                    for (std::size_t i = 0; i < number; ++i)
+                    {
+                         probabilitySum += probabilities[i];
+                         if (0 != counts[i] && std::fabs(counts[i] / static_cast<double>(sampleNumber) - probabilities[i]) > 0.01)
+                              ++sampleMismatchNumber;
+                         // Every light which noticeably reaches the point is sampled
+                         const float distance = GetDistance(lights[i], point);
+                         if (distance < lights[i].w * 0.9f &&
+                              GetIntensity(colors[i]) * ComputeLightAttenuation(distance, lights[i].w) > 1e-3f &&
+                              0.0f == probabilities[i])
+                              ++sampleMismatchNumber;
+                    }
+                    if (0.0 < probabilitySum && std::fabs(probabilitySum + invalidNumber / static_cast<double>(sampleNumber) - 1.0) > 0.01)
+                         ++sampleMismatchNumber;
+               }
+          }
+     }
+     CHECK(0 == queryMismatchNumber);
+     CHECK(0 == sampleMismatchNumber);
+     return CheckResult();
+}
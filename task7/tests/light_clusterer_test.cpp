@@ -0,0 +1,130 @@
+#include "check.h"
+#include "light_clusterer.h"
+#include "thread_pool.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+     const unsigned tileNumberX = 16;
+     const unsigned tileNumberY = 9;
+     const unsigned sliceNumber = 24;
+
+     DirectX::XMFLOAT3 ToView(const DirectX::XMFLOAT4X4 &view, const DirectX::XMFLOAT4 &point)
+     {
+          return DirectX::XMFLOAT3(
+               point.x * view._11 + point.y * view._21 + point.z * view._31 + view._41,
+               point.x * view._12 + point.y * view._22 + point.z * view._32 + view._42,
+               point.x * view._13 + point.y * view._23 + point.z * view._33 + view._43);
+     }
+
+     bool Contains(const std::vector<std::uint32_t> &indices, const ClusterRange &range, const std::uint32_t light)
+     {
+          const auto begin = indices.begin() + range.offset;
+          const auto end = begin + range.count;
+          return end != std::find(begin, end, light);
+     }
+
+}
+
+// Cluster lists against brute force sphere-box tests for random views and light sets, then shader style
+// lookups of random view points must find every light which reaches the point
+int main()
+{
+     std::mt19937 random(22);
+     std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+     ThreadPool threadPool(4);
+     LightClusterer clusterer(tileNumberX, tileNumberY, sliceNumber, 0.1f, 100.0f);
+     CHECK(tileNumberX * tileNumberY * sliceNumber == clusterer.GetClusterNumber());
+     const float fovY = DirectX::XM_PI / 3;
+     const float aspect = 16.0f / 9.0f;
+
+     std::vector<ClusterRange> ranges;
+     std::vector<std::uint32_t> indices;
+     std::size_t mismatchNumber = 0;
+     std::size_t missedNumber = 0;
+     std::size_t assignedNumber = 0;
+     for (int iteration = 0; iteration < 30; ++iteration)
+     {
+          // Rigid view, rotation about y and translation
+          const float angle = unit(random) * 3.0f;
+          DirectX::XMFLOAT4X4 view = {};
+          view._11 = std::cos(angle);
+          view._13 = -std::sin(angle);
+          view._22 = 1.0f;
+          view._31 = std::sin(angle);
+          view._33 = std::cos(angle);
+          view._41 = unit(random) * 5.0f;
+          view._42 = unit(random) * 5.0f;
+          view._43 = unit(random) * 5.0f;
+          view._44 = 1.0f;
+
+          const std::size_t lightNumber = 0 == iteration ? 0 : (iteration * 37) % 700 + 1;
+          std::vector<DirectX::XMFLOAT4> lights(lightNumber);
+          for (DirectX::XMFLOAT4 &light : lights)
+               light = DirectX::XMFLOAT4(unit(random) * 60.0f, unit(random) * 20.0f, unit(random) * 60.0f, std::fabs(unit(random)) * 8.0f);
+          clusterer.Build(view, fovY, aspect, lights.data(), lightNumber, threadPool, ranges, indices);
+          CHECK(clusterer.GetClusterNumber() == ranges.size());
+
+          std::size_t expectedTotal = 0;
+          for (unsigned slice = 0; slice < sliceNumber; ++slice)
+               for (unsigned tileY = 0; tileY < tileNumberY; ++tileY)
+                    for (unsigned tileX = 0; tileX < tileNumberX; ++tileX)
+                    {
+                         float min[3];
+                         float max[3];
+                         clusterer.GetClusterBox(tileX, tileY, slice, min, max);
+                         std::vector<std::uint32_t> expected;
+                         for (std::uint32_t i = 0; i < lightNumber; ++i)
+                         {
+                              const DirectX::XMFLOAT3 center = ToView(view, lights[i]);
+                              const float dx = std::max(std::max(min[0] - center.x, center.x - max[0]), 0.0f);
+                              const float dy = std::max(std::max(min[1] - center.y, center.y - max[1]), 0.0f);
+                              const float dz = std::max(std::max(min[2] - center.z, center.z - max[2]), 0.0f);
+                              if (dx * dx + dy * dy + dz * dz <= lights[i].w * lights[i].w)
+                                   expected.push_back(i);
+                         }
+                         const ClusterRange &range = ranges[(slice * tileNumberY + tileY) * tileNumberX + tileX];
+                         const std::vector<std::uint32_t> actual(indices.begin() + range.offset, indices.begin() + range.offset + range.count);
+                         mismatchNumber += expected != actual ? 1 : 0;
+                         expectedTotal += expected.size();
+                    }
+          CHECK(expectedTotal == indices.size());
+          assignedNumber += indices.size();
+
+          const float scale = clusterer.GetSliceScale();
+          const float bias = clusterer.GetSliceBias();
+          const float tanHalfY = std::tan(fovY / 2);
+          for (int sample = 0; sample < 5000; ++sample)
+          {
+               const float z = 0.1f * std::pow(1000.0f, (unit(random) + 1.0f) / 2.0f);
+               const float screenX = unit(random) * 0.999f;
+               const float screenY = unit(random) * 0.999f;
+               const DirectX::XMFLOAT3 point(screenX * z * tanHalfY * aspect, screenY * z * tanHalfY, z);
+               const unsigned slice = static_cast<unsigned>(std::min(sliceNumber - 1.0f, std::max(0.0f, std::floor(std::log(z) * scale + bias))));
+               const unsigned tileX = static_cast<unsigned>((screenX + 1.0f) / 2.0f * tileNumberX);
+               const unsigned tileY = static_cast<unsigned>((1.0f - screenY) / 2.0f * tileNumberY);
+               const ClusterRange &range = ranges[(slice * tileNumberY + tileY) * tileNumberX + tileX];
+               for (std::uint32_t i = 0; i < lightNumber; ++i)
+               {
+                    const DirectX::XMFLOAT3 center = ToView(view, lights[i]);
+                    const float distanceSq =
+                         (center.x - point.x) * (center.x - point.x) +
+                         (center.y - point.y) * (center.y - point.y) +
+                         (center.z - point.z) * (center.z - point.z);
+                    if (distanceSq < lights[i].w * lights[i].w * 0.999f && !Contains(indices, range, i))
+                         ++missedNumber;
+               }
+          }
+     }
+     CHECK(0 == mismatchNumber);
+     CHECK(0 == missedNumber);
+     CHECK(0 < assignedNumber);
+     return CheckResult();
+}
@@ -0,0 +1,64 @@
+#include "check.h"
+#include "light_falloff.h"
+#include "lights.h"
+
+#include <directxmath.h>
+#include <cmath>
+
+namespace
+{
+
+     bool IsNear(const float value, const float expected, const float tolerance)
+     {
+          return std::fabs(value - expected) <= tolerance;
+     }
+
+}
+
+// Influence radius matches the cutoff, the window reaches zero smoothly at the radius and attenuation
+// never grows with distance; Lights writes the radius of the brightest channel to position w
+int main()
+{
+     CHECK(IsNear(ComputeLightRadius(1.0f, 1.0f / 256.0f), 16.0f, 1e-5f));
+     CHECK(IsNear(ComputeLightRadius(4.0f, 1.0f / 256.0f), 32.0f, 1e-5f));
+     CHECK(0.0f == ComputeLightRadius(0.0f, 0.1f));
+     CHECK(0.0f == ComputeLightRadius(-1.0f, 0.1f));
+     CHECK(0.0f == ComputeLightRadius(1.0f, 0.0f));
+     for (float intensity = 0.01f; intensity < 100.0f; intensity *= 1.7f)
+     {
+          const float radius = ComputeLightRadius(intensity, 0.01f);
+          CHECK(IsNear(intensity / (radius * radius), 0.01f, 1e-6f));
+     }
+
+     CHECK(1.0f == ComputeLightWindow(0.0f, 5.0f));
+     CHECK(0.0f == ComputeLightWindow(5.0f, 5.0f));
+     CHECK(0.0f == ComputeLightWindow(7.0f, 5.0f));
+     CHECK(0.0f == ComputeLightWindow(1.0f, 0.0f));
+     CHECK(IsNear(ComputeLightWindow(2.5f, 5.0f), (1.0f - 0.0625f) * (1.0f - 0.0625f), 1e-6f));
+
+     bool monotonic = true;
+     float previous = 2.0f;
+     for (float distance = 0.0f; distance <= 6.0f; distance += 0.001f)
+     {
+          const float attenuation = ComputeLightAttenuation(distance, 5.0f);
+          monotonic = monotonic && attenuation <= previous + 1e-7f;
+          previous = attenuation;
+     }
+     CHECK(monotonic);
+     // Smooth end, the window derivative is zero at the radius
+     CHECK(ComputeLightAttenuation(4.999f, 5.0f) < 1e-5f);
+     // Inverse square is clamped to one near the light
+     CHECK(IsNear(ComputeLightAttenuation(0.5f, 5.0f), ComputeLightWindow(0.5f, 5.0f), 1e-6f));
+     CHECK(IsNear(ComputeLightAttenuation(2.0f, 1000.0f), 0.25f, 1e-6f));
+
+     Lights lights(4, 1.0f / 256.0f);
+     lights.Add(DirectX::XMFLOAT4(1.0f, 2.0f, 3.0f, 7.0f), DirectX::XMFLOAT4(0.5f, -4.0f, 1.0f, 1.0f));
+     lights.Add(DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f), DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+     DirectX::XMFLOAT4 positions[2];
+     DirectX::XMFLOAT4 colors[2];
+     lights.Evaluate(0.0, positions, colors);
+     CHECK(IsNear(positions[0].w, 32.0f, 1e-5f));
+     CHECK(1.0f == positions[0].x);
+     CHECK(0.0f == positions[1].w);
+     return CheckResult();
+}
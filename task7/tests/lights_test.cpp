@@ -0,0 +1,99 @@
+#include "check.h"
+#include "light_falloff.h"
+#include "lights.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Sinusoids of every tail length, orbits and keyframe curves against double precision references,
+// influence radius from the evaluated color and capacity limits
+int main()
+{
+     std::mt19937 random(21);
+     std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+     const double times[] = { 0.0, 1.7, 1000.0, 1000000.0 };
+
+     double sinError = 0.0;
+     for (std::size_t number = 1; number <= 23; ++number)
+     {
+          Lights lights(64, 1.0f / 256.0f);
+          std::vector<float> amplitudes(number);
+          std::vector<float> frequencies(number);
+          std::vector<float> phases(number);
+          for (std::size_t i = 0; i < number; ++i)
+          {
+               const std::uint32_t light = lights.Add(DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f), DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+               CHECK(i == light);
+               amplitudes[i] = 1.0f + unit(random) * 0.5f;
+               frequencies[i] = unit(random) * 5.0f;
+               phases[i] = unit(random) * 7.0f;
+               CHECK(lights.AddSinusoid(light, Lights::Channel::PositionX, amplitudes[i], frequencies[i], phases[i]));
+          }
+          std::vector<DirectX::XMFLOAT4> positions(number);
+          std::vector<DirectX::XMFLOAT4> colors(number);
+          for (const double seconds : times)
+          {
+               lights.Evaluate(seconds, positions.data(), colors.data());
+               for (std::size_t i = 0; i < number; ++i)
+               {
+                    const double expected = amplitudes[i] * std::sin(static_cast<double>(frequencies[i]) * seconds + phases[i]);
+                    sinError = std::max(sinError, std::fabs(expected - positions[i].x));
+               }
+          }
+     }
+     CHECK(sinError < 1e-5);
+
+     Lights lights(2, 1.0f / 256.0f);
+     const std::uint32_t orbiting = lights.Add(DirectX::XMFLOAT4(1.0f, 2.0f, 3.0f, 0.0f), DirectX::XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f));
+     const std::uint32_t blinking = lights.Add(DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f), DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+     CHECK(Lights::invalidLight == lights.Add(DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f), DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f)));
+     CHECK(2 == lights.GetNumber());
+     CHECK(!lights.AddSinusoid(2, Lights::Channel::ColorR, 1.0f, 1.0f, 0.0f));
+     CHECK(lights.AddOrbit(orbiting, 2.0f, 0.5f, 0.25f));
+
+     const float keyTimes[] = { 0.0f, 1.0f, 3.0f };
+     const float keyValues[] = { 0.0f, 2.0f, 1.0f };
+     const float unsortedTimes[] = { 1.0f, 0.0f };
+     CHECK(lights.AddKeyframes(blinking, Lights::Channel::ColorG, keyTimes, keyValues, 3, 4.0f));
+     CHECK(lights.AddKeyframes(blinking, Lights::Channel::ColorB, keyTimes, keyValues, 3, 0.0f));
+     CHECK(!lights.AddKeyframes(blinking, Lights::Channel::ColorR, unsortedTimes, keyValues, 2, 0.0f));
+     CHECK(!lights.AddKeyframes(blinking, Lights::Channel::ColorR, keyTimes, keyValues, 0, 0.0f));
+
+     // Reference of the curve over one period
+     const auto curve = [&](const double time)
+     {
+          if (time >= keyTimes[2])
+               return static_cast<double>(keyValues[2]);
+          const int next = time < keyTimes[1] ? 1 : 2;
+          const double t = (time - keyTimes[next - 1]) / (keyTimes[next] - keyTimes[next - 1]);
+          return keyValues[next - 1] + (keyValues[next] - keyValues[next - 1]) * t;
+     };
+
+     DirectX::XMFLOAT4 positions[2];
+     DirectX::XMFLOAT4 colors[2];
+     for (int frame = 0; frame < 1000; ++frame)
+     {
+          const double seconds = frame * 0.013;
+          lights.Evaluate(seconds, positions, colors);
+
+          const double angle = 0.5 * seconds + 0.25;
+          CHECK(std::fabs(positions[orbiting].x - (1.0 + 2.0 * std::sin(angle))) < 1e-5);
+          CHECK(std::fabs(positions[orbiting].z - (3.0 + 2.0 * std::cos(angle))) < 1e-5);
+          CHECK(2.0f == positions[orbiting].y);
+          CHECK(0.5f == colors[orbiting].x);
+
+          CHECK(std::fabs(colors[blinking].y - curve(std::fmod(seconds, 4.0))) < 1e-5);
+          CHECK(std::fabs(colors[blinking].z - curve(seconds)) < 1e-5);
+          CHECK(0.0f == colors[blinking].x);
+
+          for (int i = 0; i < 2; ++i)
+          {
+               const float intensity = std::max(std::max(std::fabs(colors[i].x), std::fabs(colors[i].y)), std::fabs(colors[i].z));
+               CHECK(ComputeLightRadius(intensity, 1.0f / 256.0f) == positions[i].w);
+          }
+     }
+     return CheckResult();
+}
@@ -0,0 +1,215 @@
+#include "frustum.h"
+#include "loose_octree.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+     const int runNumber = 11;
+
+     // Median time in milliseconds of repeated runs of work
+     template <typename Work>
+     double Median(Work &&work)
+     {
+          std::vector<double> times;
+          for (int run = 0; run < runNumber; ++run)
+          {
+               const auto start = std::chrono::steady_clock::now();
+               work(run);
+               times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+          }
+          std::nth_element(times.begin(), times.begin() + runNumber / 2, times.end());
+          return times[runNumber / 2];
+     }
+
+     void Print(const char *query, const double octreeTime, const double scanTime, const std::size_t octreeHits, const std::size_t scanHits)
+     {
+          std::printf(
+               "%10s %12.3f %12.3f %7.2fx%s\n",
+               query,
+               octreeTime,
+               scanTime,
+               scanTime / octreeTime,
+               octreeHits == scanHits ? "" : " (results differ)");
+     }
+
+}
+
+// Frustum, sphere, box and ray queries of the loose octree against a brute force scan of the same spheres,
+// and moving a tenth of objects by Update against rebuilding the tree, for 10^4 and 10^5 objects
+int main()
+{
+     const std::size_t queryNumber = 100;
+     for (std::size_t count : {10000, 100000})
+     {
+          std::mt19937 random(10);
+          const float extent = std::sqrt(static_cast<float>(count)) * 0.5f;
+          std::uniform_real_distribution<float> coordinate(-extent, extent);
+          std::uniform_real_distribution<float> radiusDistribution(0.1f, 1.0f);
+          std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+          std::vector<DirectX::XMFLOAT3> centers(count);
+          std::vector<float> radii(count);
+          LooseOctree octree(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), extent, 5);
+          for (std::size_t i = 0; i < count; ++i)
+          {
+               centers[i] = DirectX::XMFLOAT3(coordinate(random), coordinate(random) * 0.1f, coordinate(random));
+               radii[i] = radiusDistribution(random);
+               octree.Insert(centers[i], radii[i]);
+          }
+
+          // Query shapes are shared by octree and scan runs
+          std::vector<DirectX::XMFLOAT3> queryCenters(queryNumber);
+          std::vector<DirectX::XMFLOAT3> rayDirections(queryNumber);
+          for (std::size_t q = 0; q < queryNumber; ++q)
+          {
+               queryCenters[q] = DirectX::XMFLOAT3(coordinate(random), 0.0f, coordinate(random));
+               DirectX::XMStoreFloat3(&rayDirections[q], DirectX::XMVector3Normalize(DirectX::XMVectorSet(unit(random), unit(random) * 0.1f, unit(random), 0.0f)));
+          }
+          std::vector<Frustum> frusta(runNumber, Frustum(0.1f));
+          for (int run = 0; run < runNumber; ++run)
+          {
+               const float angle = run * 0.6f;
+               frusta[run].Construct(
+                    DirectX::XMMatrixLookAtLH(
+                         DirectX::XMVectorSet(0.0f, 2.0f, 0.0f, 0.0f),
+                         DirectX::XMVectorSet(std::cos(angle), 2.0f, std::sin(angle), 0.0f),
+                         DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+                    DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f));
+          }
+          const float queryRadius = 5.0f;
+          const float rayLength = 50.0f;
+
+          std::printf("%zu objects\n%10s %12s %12s %8s\n", count, "query", "octree ms", "scan ms", "speedup");
+
+          std::size_t octreeHits = 0;
+          std::size_t scanHits = 0;
+          const double octreeFrustum = Median(
+               [&](int run)
+               {
+                    octree.VisitFrustum(frusta[run], [&octreeHits](std::uint32_t) { ++octreeHits; });
+               });
+          const double scanFrustum = Median(
+               [&](int run)
+               {
+                    for (std::size_t i = 0; i < count; ++i)
+                         scanHits += frusta[run].CheckSphere(centers[i], radii[i]) ? 1 : 0;
+               });
+          Print("frustum", octreeFrustum, scanFrustum, octreeHits, scanHits);
+
+          octreeHits = 0;
+          scanHits = 0;
+          const double octreeSphere = Median(
+               [&](int)
+               {
+                    for (const auto &center : queryCenters)
+                         octree.VisitSphere(center, queryRadius, [&octreeHits](std::uint32_t) { ++octreeHits; });
+               });
+          const double scanSphere = Median(
+               [&](int)
+               {
+                    for (const auto &center : queryCenters)
+                         for (std::size_t i = 0; i < count; ++i)
+                         {
+                              const float dx = centers[i].x - center.x;
+                              const float dy = centers[i].y - center.y;
+                              const float dz = centers[i].z - center.z;
+                              const float r = radii[i] + queryRadius;
+                              scanHits += dx * dx + dy * dy + dz * dz <= r * r ? 1 : 0;
+                         }
+               });
+          Print("sphere", octreeSphere, scanSphere, octreeHits, scanHits);
+
+          octreeHits = 0;
+          scanHits = 0;
+          const double octreeAabb = Median(
+               [&](int)
+               {
+                    for (const auto &center : queryCenters)
+                         octree.VisitAabb(
+                              DirectX::XMFLOAT3(center.x - queryRadius, center.y - queryRadius, center.z - queryRadius),
+                              DirectX::XMFLOAT3(center.x + queryRadius, center.y + queryRadius, center.z + queryRadius),
+                              [&octreeHits](std::uint32_t) { ++octreeHits; });
+               });
+          const double scanAabb = Median(
+               [&](int)
+               {
+                    for (const auto &center : queryCenters)
+                         for (std::size_t i = 0; i < count; ++i)
+                         {
+                              // Distance from sphere center to the box of half size queryRadius, clamped to zero
+                              // without branches (0.5 * (d + |d|)) so that the scan vectorizes
+                              const float ex = std::abs(centers[i].x - center.x) - queryRadius;
+                              const float ey = std::abs(centers[i].y - center.y) - queryRadius;
+                              const float ez = std::abs(centers[i].z - center.z) - queryRadius;
+                              const float dx = 0.5f * (ex + std::abs(ex));
+                              const float dy = 0.5f * (ey + std::abs(ey));
+                              const float dz = 0.5f * (ez + std::abs(ez));
+                              scanHits += dx * dx + dy * dy + dz * dz <= radii[i] * radii[i] ? 1 : 0;
+                         }
+               });
+          Print("aabb", octreeAabb, scanAabb, octreeHits, scanHits);
+
+          octreeHits = 0;
+          scanHits = 0;
+          const double octreeRay = Median(
+               [&](int)
+               {
+                    for (std::size_t q = 0; q < queryNumber; ++q)
+                         octree.VisitRay(queryCenters[q], rayDirections[q], rayLength, [&octreeHits](std::uint32_t, float) { ++octreeHits; });
+               });
+          const double scanRay = Median(
+               [&](int)
+               {
+                    for (std::size_t q = 0; q < queryNumber; ++q)
+                    {
+                         const DirectX::XMFLOAT3 &origin = queryCenters[q];
+                         const DirectX::XMFLOAT3 &direction = rayDirections[q];
+                         for (std::size_t i = 0; i < count; ++i)
+                         {
+                              const float mx = origin.x - centers[i].x;
+                              const float my = origin.y - centers[i].y;
+                              const float mz = origin.z - centers[i].z;
+                              const float b = mx * direction.x + my * direction.y + mz * direction.z;
+                              const float c = mx * mx + my * my + mz * mz - radii[i] * radii[i];
+                              const float discriminant = b * b - c;
+                              if (discriminant < 0.0f)
+                                   continue;
+                              const float t = std::max(0.0f, -b - std::sqrt(discriminant));
+                              scanHits += t <= rayLength && (c <= 0.0f || b < 0.0f) ? 1 : 0;
+                         }
+                    }
+               });
+          Print("ray", octreeRay, scanRay, octreeHits, scanHits);
+
+          // A tenth of objects moves a little every run: Update relinks only those, rebuilding reinserts all
+          std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+          std::vector<DirectX::XMFLOAT3> moved(centers);
+          LooseOctree rebuilt(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), extent, 5);
+          const double updateTime = Median(
+               [&](int)
+               {
+                    for (std::size_t i = 0; i < count; i += 10)
+                    {
+                         moved[i].x += step(random);
+                         moved[i].z += step(random);
+                         octree.Update(static_cast<std::uint32_t>(i), moved[i], radii[i]);
+                    }
+               });
+          const double rebuildTime = Median(
+               [&](int)
+               {
+                    rebuilt.Clear();
+                    for (std::size_t i = 0; i < count; ++i)
+                         rebuilt.Insert(moved[i], radii[i]);
+               });
+          Print("update", updateTime, rebuildTime, octree.GetSize(), rebuilt.GetSize());
+     }
+     return 0;
+}
@@ -0,0 +1,176 @@
+#include "check.h"
+#include "frustum.h"
+#include "loose_octree.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace
+{
+
+     struct Object
+     {
+          DirectX::XMFLOAT3 center;
+          float radius;
+          std::uint32_t handle;
+          bool alive;
+     };
+
+     // Object indices of visited handles
+     class HitSet
+     {
+     public:
+          explicit HitSet(const std::vector<Object> &objects) :
+               byHandle_(objects.size() * 2, LooseOctree::invalidHandle)
+          {
+               for (std::uint32_t i = 0; i < objects.size(); ++i)
+               {
+                    if (objects[i].alive)
+                         byHandle_[objects[i].handle] = i;
+               }
+          }
+
+          void Add(const std::uint32_t handle)
+          {
+               hits.insert(byHandle_[handle]);
+          }
+
+          std::set<std::uint32_t> hits;
+
+     private:
+          std::vector<std::uint32_t> byHandle_;
+     };
+
+}
+
+// Sphere, box, ray and frustum queries against brute force after inserts, moves and removals
+int main()
+{
+     std::mt19937 random(10);
+     std::uniform_real_distribution<float> coordinate(-55.0f, 55.0f);
+     std::uniform_real_distribution<float> radiusDistribution(0.01f, 1.0f);
+
+     // Some objects are outside of the root or too large and stay in the root
+     LooseOctree tree(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), 50.0f, 5);
+     std::vector<Object> objects(20000);
+     for (std::size_t i = 0; i < objects.size(); ++i)
+     {
+          Object &object = objects[i];
+          object.center = DirectX::XMFLOAT3(coordinate(random), coordinate(random) * 0.2f, coordinate(random));
+          object.radius = radiusDistribution(random) * (0 == i % 100 ? 60.0f : 1.0f);
+          object.handle = tree.Insert(object.center, object.radius);
+          object.alive = true;
+     }
+     for (std::size_t i = 0; i < objects.size(); i += 3)
+     {
+          objects[i].center.x += coordinate(random) * 0.1f;
+          tree.Update(objects[i].handle, objects[i].center, objects[i].radius);
+     }
+     for (std::size_t i = 0; i < objects.size(); i += 7)
+     {
+          tree.Remove(objects[i].handle);
+          objects[i].alive = false;
+     }
+     for (std::size_t i = 0; i < objects.size(); i += 14)
+     {
+          objects[i].handle = tree.Insert(objects[i].center, objects[i].radius);
+          objects[i].alive = true;
+     }
+     CHECK(static_cast<std::size_t>(std::count_if(objects.begin(), objects.end(), [](const Object &object) { return object.alive; })) == tree.GetSize());
+
+     Frustum frustum(0.1f);
+     std::size_t hitTotal = 0;
+     for (int query = 0; query < 50; ++query)
+     {
+          const DirectX::XMFLOAT3 center(coordinate(random), coordinate(random) * 0.2f, coordinate(random));
+          const float radius = radiusDistribution(random) * 12.0f;
+
+          HitSet sphereHits(objects);
+          tree.VisitSphere(center, radius, [&sphereHits](std::uint32_t handle) { sphereHits.Add(handle); });
+          std::set<std::uint32_t> expected;
+          for (std::uint32_t i = 0; i < objects.size(); ++i)
+          {
+               const Object &object = objects[i];
+               const float dx = object.center.x - center.x;
+               const float dy = object.center.y - center.y;
+               const float dz = object.center.z - center.z;
+               const float distance = object.radius + radius;
+               if (object.alive && dx * dx + dy * dy + dz * dz <= distance * distance)
+                    expected.insert(i);
+          }
+          CHECK(expected == sphereHits.hits);
+          hitTotal += expected.size();
+
+          const float boxMin[3] = {center.x - radius, center.y - radius, center.z - radius};
+          const float boxMax[3] = {center.x + radius, center.y + radius, center.z + radius};
+          HitSet boxHits(objects);
+          tree.VisitAabb(
+               DirectX::XMFLOAT3(boxMin[0], boxMin[1], boxMin[2]),
+               DirectX::XMFLOAT3(boxMax[0], boxMax[1], boxMax[2]),
+               [&boxHits](std::uint32_t handle) { boxHits.Add(handle); });
+          expected.clear();
+          for (std::uint32_t i = 0; i < objects.size(); ++i)
+          {
+               const Object &object = objects[i];
+               const float c[3] = {object.center.x, object.center.y, object.center.z};
+               float distanceSq = 0.0f;
+               for (int axis = 0; axis < 3; ++axis)
+               {
+                    const float d = std::max({boxMin[axis] - c[axis], c[axis] - boxMax[axis], 0.0f});
+                    distanceSq += d * d;
+               }
+               if (object.alive && distanceSq <= object.radius * object.radius)
+                    expected.insert(i);
+          }
+          CHECK(expected == boxHits.hits);
+
+          DirectX::XMFLOAT3 direction(coordinate(random), coordinate(random), coordinate(random));
+          const float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+          direction = DirectX::XMFLOAT3(direction.x / length, direction.y / length, direction.z / length);
+          const float maxDistance = 40.0f;
+          HitSet rayHits(objects);
+          tree.VisitRay(center, direction, maxDistance, [&rayHits](std::uint32_t handle, float) { rayHits.Add(handle); });
+          expected.clear();
+          for (std::uint32_t i = 0; i < objects.size(); ++i)
+          {
+               const Object &object = objects[i];
+               const float mx = center.x - object.center.x;
+               const float my = center.y - object.center.y;
+               const float mz = center.z - object.center.z;
+               const float b = mx * direction.x + my * direction.y + mz * direction.z;
+               const float c = mx * mx + my * my + mz * mz - object.radius * object.radius;
+               const float discriminant = b * b - c;
+               if (!object.alive || discriminant < 0.0f)
+                    continue;
+               const float t = std::max(0.0f, -b - std::sqrt(discriminant));
+               if (t <= maxDistance && (c <= 0.0f || b < 0.0f))
+                    expected.insert(i);
+          }
+          CHECK(expected == rayHits.hits);
+
+          frustum.Construct(
+               DirectX::XMMatrixLookAtLH(
+                    DirectX::XMLoadFloat3(&center),
+                    DirectX::XMVectorSet(coordinate(random), 0.0f, coordinate(random), 0.0f),
+                    DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+               DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f));
+          HitSet frustumHits(objects);
+          tree.VisitFrustum(frustum, [&frustumHits](std::uint32_t handle) { frustumHits.Add(handle); });
+          expected.clear();
+          for (std::uint32_t i = 0; i < objects.size(); ++i)
+          {
+               if (objects[i].alive && frustum.CheckSphere(objects[i].center, objects[i].radius))
+                    expected.insert(i);
+          }
+          CHECK(expected == frustumHits.hits);
+     }
+     CHECK(0 < hitTotal);
+
+     tree.Clear();
+     CHECK(0 == tree.GetSize());
+     return CheckResult();
+}
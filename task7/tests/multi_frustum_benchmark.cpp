@@ -0,0 +1,83 @@
+#include "frustum.h"
+#include "multi_frustum.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// One MultiFrustum pass against separate Frustum passes for 1, 6 and 12 frusta, median of repeated runs
+int main()
+{
+     std::mt19937 random(7);
+     std::uniform_real_distribution<float> coordinate(-30.0f, 30.0f);
+     std::uniform_real_distribution<float> extent(0.01f, 3.0f);
+
+     const std::size_t count = 100000;
+     const int runNumber = 21;
+     std::vector<float> bounds[6];
+     for (auto &component : bounds)
+          component.resize(count);
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               const float center = coordinate(random);
+               const float halfSize = extent(random);
+               bounds[axis][i] = center - halfSize;
+               bounds[axis + 3][i] = center + halfSize;
+          }
+     }
+
+     std::printf("%8s %12s %12s\n", "frusta", "multi ms", "separate ms");
+     for (std::size_t number : {1, 6, 12})
+     {
+          std::vector<Frustum> frusta(number, Frustum(0.1f));
+          MultiFrustum multiFrustum;
+          for (Frustum &frustum : frusta)
+          {
+               frustum.Construct(
+                    DirectX::XMMatrixLookAtLH(
+                         DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
+                         DirectX::XMVectorSet(coordinate(random), coordinate(random), coordinate(random), 0.0f),
+                         DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+                    DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV2, 1.0f, 100.0f, 0.1f));
+               multiFrustum.Add(frustum);
+          }
+
+          std::vector<std::uint32_t> masks(count);
+          std::vector<std::uint32_t> visible(count);
+          std::vector<double> multiTimes;
+          std::vector<double> separateTimes;
+          for (int run = 0; run < runNumber; ++run)
+          {
+               const auto start = std::chrono::steady_clock::now();
+               multiFrustum.CheckRectangles(bounds[0].data(), bounds[1].data(), bounds[2].data(), bounds[3].data(), bounds[4].data(), bounds[5].data(), count, masks.data());
+               const auto middle = std::chrono::steady_clock::now();
+               std::fill(masks.begin(), masks.end(), 0);
+               for (std::size_t k = 0; k < number; ++k)
+               {
+                    const std::size_t visibleNumber = frusta[k].CheckRectangles(
+                         bounds[0].data(),
+                         bounds[1].data(),
+                         bounds[2].data(),
+                         bounds[3].data(),
+                         bounds[4].data(),
+                         bounds[5].data(),
+                         count,
+                         visible.data());
+                    for (std::size_t i = 0; i < visibleNumber; ++i)
+                         masks[visible[i]] |= 1u << k;
+               }
+               const auto end = std::chrono::steady_clock::now();
+               multiTimes.push_back(std::chrono::duration<double, std::milli>(middle - start).count());
+               separateTimes.push_back(std::chrono::duration<double, std::milli>(end - middle).count());
+          }
+          std::nth_element(multiTimes.begin(), multiTimes.begin() + runNumber / 2, multiTimes.end());
+          std::nth_element(separateTimes.begin(), separateTimes.begin() + runNumber / 2, separateTimes.end());
+          std::printf("%8zu %12.3f %12.3f\n", number, multiTimes[runNumber / 2], separateTimes[runNumber / 2]);
+     }
+     return 0;
+}
@@ -0,0 +1,67 @@
+#include "check.h"
+#include "frustum.h"
+#include "multi_frustum.h"
+
+#include <directxmath.h>
+#include <random>
+#include <vector>
+
+// Visibility masks of MultiFrustum against separate Frustum::CheckRectangles calls for every frustum number
+int main()
+{
+     std::mt19937 random(7);
+     std::uniform_real_distribution<float> coordinate(-30.0f, 30.0f);
+     std::uniform_real_distribution<float> extent(0.01f, 3.0f);
+
+     const std::size_t count = 10003;
+     std::vector<float> bounds[6];
+     for (auto &component : bounds)
+          component.resize(count);
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               const float center = coordinate(random);
+               const float halfSize = extent(random);
+               bounds[axis][i] = center - halfSize;
+               bounds[axis + 3][i] = center + halfSize;
+          }
+     }
+
+     MultiFrustum multiFrustum;
+     std::vector<std::uint32_t> expected(count, 0);
+     std::vector<std::uint32_t> visible(count);
+     std::vector<std::uint32_t> masks(count);
+     for (std::size_t number = 1; number <= 12; ++number)
+     {
+          // Adding one frustum at a time checks every count of frusta
+          Frustum frustum(0.1f);
+          frustum.Construct(
+               DirectX::XMMatrixLookAtLH(
+                    DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f),
+                    DirectX::XMVectorSet(coordinate(random), coordinate(random), coordinate(random), 0.0f),
+                    DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+               DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV2, 1.0f, 100.0f, 0.1f));
+          CHECK(multiFrustum.Add(frustum));
+          CHECK(number == multiFrustum.GetNumber());
+
+          const std::size_t visibleNumber = frustum.CheckRectangles(
+               bounds[0].data(),
+               bounds[1].data(),
+               bounds[2].data(),
+               bounds[3].data(),
+               bounds[4].data(),
+               bounds[5].data(),
+               count,
+               visible.data());
+          for (std::size_t i = 0; i < visibleNumber; ++i)
+               expected[visible[i]] |= 1u << (number - 1);
+
+          multiFrustum.CheckRectangles(bounds[0].data(), bounds[1].data(), bounds[2].data(), bounds[3].data(), bounds[4].data(), bounds[5].data(), count, masks.data());
+          CHECK(expected == masks);
+     }
+
+     multiFrustum.Clear();
+     CHECK(0 == multiFrustum.GetNumber());
+     return CheckResult();
+}
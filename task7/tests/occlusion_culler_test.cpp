@@ -0,0 +1,216 @@
+#include "check.h"
+#include "occlusion_culler.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+     struct Vertex
+     {
+          float x, y, z;
+     };
+
+     // Unit cube with clockwise front faces, as the renderer's cube
+     const Vertex cubeVertices[24] = {
+          {-0.5f, -0.5f, 0.5f}, {0.5f, -0.5f, 0.5f}, {0.5f, -0.5f, -0.5f}, {-0.5f, -0.5f, -0.5f},
+          {-0.5f, 0.5f, -0.5f}, {0.5f, 0.5f, -0.5f}, {0.5f, 0.5f, 0.5f}, {-0.5f, 0.5f, 0.5f},
+          {0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, 0.5f}, {0.5f, 0.5f, 0.5f}, {0.5f, 0.5f, -0.5f},
+          {-0.5f, -0.5f, 0.5f}, {-0.5f, -0.5f, -0.5f}, {-0.5f, 0.5f, -0.5f}, {-0.5f, 0.5f, 0.5f},
+          {0.5f, -0.5f, 0.5f}, {-0.5f, -0.5f, 0.5f}, {-0.5f, 0.5f, 0.5f}, {0.5f, 0.5f, 0.5f},
+          {-0.5f, -0.5f, -0.5f}, {0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, -0.5f}, {-0.5f, 0.5f, -0.5f}};
+     const unsigned short cubeIndices[36] = {
+          0, 2, 1, 0, 3, 2,
+          4, 6, 5, 4, 7, 6,
+          8, 10, 9, 8, 11, 10,
+          12, 14, 13, 12, 15, 14,
+          16, 18, 17, 16, 19, 18,
+          20, 22, 21, 20, 23, 22};
+
+     struct Occluder
+     {
+          DirectX::XMFLOAT3 scale;
+          DirectX::XMFLOAT3 rotation; // pitch, yaw, roll
+          DirectX::XMFLOAT3 position;
+     };
+
+     DirectX::XMMATRIX GetRotation(const Occluder &occluder)
+     {
+          return DirectX::XMMatrixRotationRollPitchYaw(occluder.rotation.x, occluder.rotation.y, occluder.rotation.z);
+     }
+
+     DirectX::XMMATRIX GetWorld(const Occluder &occluder)
+     {
+          return DirectX::XMMatrixMultiply(
+               DirectX::XMMatrixMultiply(DirectX::XMMatrixScaling(occluder.scale.x, occluder.scale.y, occluder.scale.z), GetRotation(occluder)),
+               DirectX::XMMatrixTranslation(occluder.position.x, occluder.position.y, occluder.position.z));
+     }
+
+     DirectX::XMFLOAT3 ToLocal(const Occluder &occluder, const DirectX::XMFLOAT3 &point)
+     {
+          const DirectX::XMVECTOR offset = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&point), DirectX::XMLoadFloat3(&occluder.position));
+          DirectX::XMFLOAT3 local;
+          DirectX::XMStoreFloat3(&local, DirectX::XMVector3TransformNormal(offset, DirectX::XMMatrixTranspose(GetRotation(occluder))));
+          return DirectX::XMFLOAT3(local.x / occluder.scale.x, local.y / occluder.scale.y, local.z / occluder.scale.z);
+     }
+
+     // Slab test of segment from eye to point against the occluder's local unit cube
+     bool SegmentHitsOccluder(const Occluder &occluder, const DirectX::XMFLOAT3 &eye, const DirectX::XMFLOAT3 &point)
+     {
+          const DirectX::XMFLOAT3 begin = ToLocal(occluder, eye);
+          const DirectX::XMFLOAT3 end = ToLocal(occluder, point);
+          const float from[3] = {begin.x, begin.y, begin.z};
+          const float direction[3] = {end.x - begin.x, end.y - begin.y, end.z - begin.z};
+          float enter = 0.0f;
+          float exit = 1.0f;
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               if (std::fabs(direction[axis]) < 1e-12f)
+               {
+                    if (std::fabs(from[axis]) > 0.5f)
+                         return false;
+                    continue;
+               }
+               float t0 = (-0.5f - from[axis]) / direction[axis];
+               float t1 = (0.5f - from[axis]) / direction[axis];
+               if (t0 > t1)
+                    std::swap(t0, t1);
+               enter = std::max(enter, t0);
+               exit = std::min(exit, t1);
+          }
+          return enter <= exit;
+     }
+
+     bool IsPointHidden(const std::vector<Occluder> &occluders, const DirectX::XMFLOAT3 &eye, const DirectX::XMFLOAT3 &point)
+     {
+          for (const Occluder &occluder : occluders)
+          {
+               if (SegmentHitsOccluder(occluder, eye, point))
+                    return true;
+          }
+          return false;
+     }
+
+     void Render(OcclusionCuller &culler, DirectX::FXMMATRIX viewProj, const std::vector<Occluder> &occluders)
+     {
+          culler.Clear(viewProj);
+          for (const Occluder &occluder : occluders)
+               culler.RenderOccluder(cubeVertices, 24, sizeof(Vertex), cubeIndices, 36, GetWorld(occluder));
+          culler.BuildHiZ();
+     }
+
+     DirectX::XMMATRIX GetViewProj(const DirectX::XMFLOAT3 &eye, const DirectX::XMFLOAT3 &at)
+     {
+          return DirectX::XMMatrixMultiply(
+               DirectX::XMMatrixLookAtLH(DirectX::XMLoadFloat3(&eye), DirectX::XMLoadFloat3(&at), DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+               DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f));
+     }
+
+}
+
+// Known cases and randomized scenes where every box reported hidden is checked by casting segments from the eye
+// to points of the box
+int main()
+{
+     OcclusionCuller culler;
+
+     // Wall 3 x 3 x 1 at the origin seen from -z
+     const std::vector<Occluder> wall = {{{3.0f, 3.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}}};
+     Render(culler, GetViewProj({0.0f, 0.0f, -5.0f}, {0.0f, 0.0f, 0.0f}), wall);
+     const float behindMin[3] = {-0.4f, -0.4f, 2.0f}, behindMax[3] = {0.4f, 0.4f, 3.0f};
+     CHECK(!culler.CheckRectangle(behindMin, behindMax));
+     const float frontMin[3] = {-0.4f, -0.4f, -2.0f}, frontMax[3] = {0.4f, 0.4f, -1.0f};
+     CHECK(culler.CheckRectangle(frontMin, frontMax));
+     const float asideMin[3] = {3.0f, -0.4f, 2.0f}, asideMax[3] = {4.0f, 0.4f, 3.0f};
+     CHECK(culler.CheckRectangle(asideMin, asideMax));
+     const float selfMin[3] = {-1.5f, -1.5f, -0.5f}, selfMax[3] = {1.5f, 1.5f, 0.5f};
+     CHECK(culler.CheckRectangle(selfMin, selfMax));
+     const float largeMin[3] = {-10.0f, -10.0f, 2.0f}, largeMax[3] = {10.0f, 10.0f, 3.0f};
+     CHECK(culler.CheckRectangle(largeMin, largeMax));
+
+     // Same wall seen from +z hides boxes on the other side
+     Render(culler, GetViewProj({0.0f, 0.0f, 5.0f}, {0.0f, 0.0f, 0.0f}), wall);
+     const float otherMin[3] = {-0.4f, -0.4f, -3.0f}, otherMax[3] = {0.4f, 0.4f, -2.0f};
+     CHECK(!culler.CheckRectangle(otherMin, otherMax));
+
+     // Wall crossing the near plane is skipped
+     const std::vector<Occluder> nearWall = {{{3.0f, 3.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -4.7f}}};
+     Render(culler, GetViewProj({0.0f, 0.0f, -5.0f}, {0.0f, 0.0f, 0.0f}), nearWall);
+     CHECK(culler.CheckRectangle(behindMin, behindMax));
+
+     std::mt19937 random(4);
+     std::uniform_real_distribution<float> coordinate(-6.0f, 6.0f);
+     std::uniform_real_distribution<float> size(0.3f, 4.0f);
+     std::uniform_real_distribution<float> angle(-DirectX::XM_PI, DirectX::XM_PI);
+     std::uniform_real_distribution<float> extent(0.05f, 1.0f);
+     std::size_t hiddenNumber = 0;
+     for (int scene = 0; scene < 200; ++scene)
+     {
+          std::vector<Occluder> occluders(8);
+          for (Occluder &occluder : occluders)
+          {
+               occluder.scale = DirectX::XMFLOAT3(size(random), size(random), size(random) * 0.5f);
+               occluder.rotation = DirectX::XMFLOAT3(angle(random), angle(random), angle(random));
+               occluder.position = DirectX::XMFLOAT3(coordinate(random), coordinate(random), coordinate(random));
+          }
+          const DirectX::XMFLOAT3 eye(coordinate(random) * 2.0f, coordinate(random), -15.0f);
+          Render(culler, GetViewProj(eye, {0.0f, 0.0f, 0.0f}), occluders);
+
+          std::vector<float> bounds[6];
+          std::vector<std::uint32_t> indices;
+          for (std::uint32_t box = 0; box < 200; ++box)
+          {
+               const float center[3] = {coordinate(random), coordinate(random), coordinate(random) + 6.0f};
+               for (int axis = 0; axis < 3; ++axis)
+               {
+                    const float halfSize = extent(random);
+                    bounds[axis].push_back(center[axis] - halfSize);
+                    bounds[axis + 3].push_back(center[axis] + halfSize);
+               }
+               indices.push_back(box);
+          }
+          const std::size_t visibleNumber = culler.Filter(
+               bounds[0].data(),
+               bounds[1].data(),
+               bounds[2].data(),
+               bounds[3].data(),
+               bounds[4].data(),
+               bounds[5].data(),
+               indices.data(),
+               indices.size());
+
+          std::size_t next = 0;
+          for (std::uint32_t box = 0; box < bounds[0].size(); ++box)
+          {
+               const float min[3] = {bounds[0][box], bounds[1][box], bounds[2][box]};
+               const float max[3] = {bounds[3][box], bounds[4][box], bounds[5][box]};
+               const bool visible = culler.CheckRectangle(min, max);
+               CHECK(visible == (next < visibleNumber && box == indices[next]));
+               if (visible)
+               {
+                    ++next;
+                    continue;
+               }
+
+               // Hidden box must be hidden at every sampled point
+               ++hiddenNumber;
+               const int samples = 4;
+               for (int i = 0; i <= samples; ++i)
+                    for (int j = 0; j <= samples; ++j)
+                         for (int k = 0; k <= samples; ++k)
+                         {
+                              const DirectX::XMFLOAT3 point(
+                                   min[0] + (max[0] - min[0]) * i / samples,
+                                   min[1] + (max[1] - min[1]) * j / samples,
+                                   min[2] + (max[2] - min[2]) * k / samples);
+                              CHECK(IsPointHidden(occluders, eye, point));
+                         }
+          }
+     }
+     CHECK(0 < hiddenNumber);
+     return CheckResult();
+}
@@ -0,0 +1,128 @@
+#include "bounding_volume.h"
+#include "check.h"
+#include "pvs.h"
+#include "thread_pool.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+     bool SegmentHitsBox(const DirectX::XMFLOAT3 &begin, const DirectX::XMFLOAT3 &end, const Aabb &box)
+     {
+          const float from[3] = {begin.x, begin.y, begin.z};
+          const float direction[3] = {end.x - begin.x, end.y - begin.y, end.z - begin.z};
+          const float min[3] = {box.min.x, box.min.y, box.min.z};
+          const float max[3] = {box.max.x, box.max.y, box.max.z};
+          float enter = 0.0f;
+          float exit = 1.0f;
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               if (std::fabs(direction[axis]) < 1e-9f)
+               {
+                    if (from[axis] < min[axis] || from[axis] > max[axis])
+                         return false;
+                    continue;
+               }
+               float t0 = (min[axis] - from[axis]) / direction[axis];
+               float t1 = (max[axis] - from[axis]) / direction[axis];
+               if (t0 > t1)
+                    std::swap(t0, t1);
+               enter = std::max(enter, t0);
+               exit = std::min(exit, t1);
+               if (enter > exit)
+                    return false;
+          }
+          return true;
+     }
+
+     bool IsInside(const DirectX::XMFLOAT3 &point, const Aabb &box)
+     {
+          return point.x > box.min.x && point.x < box.max.x &&
+               point.y > box.min.y && point.y < box.max.y &&
+               point.z > box.min.z && point.z < box.max.z;
+     }
+
+}
+
+// Baked sets are conservative: from random eyes, every removed object is checked with segments to random
+// points of its target box, each of which must be blocked by another object's occluder
+int main()
+{
+     std::mt19937 random(9);
+     std::uniform_real_distribution<float> coordinate(-6.0f, 6.0f);
+     std::uniform_real_distribution<float> halfSizeDistribution(0.2f, 1.5f);
+
+     // Wall splitting the region and random objects whose occluders are smaller than their targets
+     std::vector<Aabb> occluders = {{{-0.5f, -3.0f, -6.0f}, {0.5f, 3.0f, 6.0f}}};
+     std::vector<Aabb> targets = occluders;
+     for (int i = 0; i < 40; ++i)
+     {
+          const DirectX::XMFLOAT3 center(coordinate(random), coordinate(random) * 0.3f, coordinate(random));
+          const float halfSize = halfSizeDistribution(random);
+          const float occluderHalfSize = halfSize * 0.6f;
+          targets.push_back({
+               {center.x - halfSize, center.y - halfSize, center.z - halfSize},
+               {center.x + halfSize, center.y + halfSize, center.z + halfSize}});
+          occluders.push_back({
+               {center.x - occluderHalfSize, center.y - occluderHalfSize, center.z - occluderHalfSize},
+               {center.x + occluderHalfSize, center.y + occluderHalfSize, center.z + occluderHalfSize}});
+     }
+
+     ThreadPool threadPool;
+     const Aabb region = {{-8.0f, -2.0f, -8.0f}, {8.0f, 2.0f, 8.0f}};
+     Pvs pvs;
+     pvs.Bake(region, 1.0f, occluders, targets, threadPool);
+     CHECK(targets.size() == pvs.GetObjectNumber());
+
+     std::uniform_real_distribution<float> eyeX(region.min.x, region.max.x);
+     std::uniform_real_distribution<float> eyeY(region.min.y, region.max.y);
+     std::uniform_real_distribution<float> eyeZ(region.min.z, region.max.z);
+     std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+     std::size_t hiddenNumber = 0;
+     for (int eyeIndex = 0; eyeIndex < 500; ++eyeIndex)
+     {
+          const DirectX::XMFLOAT3 eye(eyeX(random), eyeY(random), eyeZ(random));
+          if (std::any_of(occluders.begin(), occluders.end(), [&eye](const Aabb &occluder) { return IsInside(eye, occluder); }))
+               continue;
+
+          std::vector<std::uint32_t> indices(targets.size());
+          for (std::size_t i = 0; i < indices.size(); ++i)
+               indices[i] = static_cast<std::uint32_t>(i);
+          const std::size_t visibleNumber = pvs.Filter(eye, indices.data(), indices.size());
+          std::vector<bool> visible(targets.size(), false);
+          for (std::size_t i = 0; i < visibleNumber; ++i)
+               visible[indices[i]] = true;
+
+          for (std::size_t target = 0; target < targets.size(); ++target)
+          {
+               if (visible[target])
+                    continue;
+               ++hiddenNumber;
+               const Aabb &box = targets[target];
+               for (int sample = 0; sample < 100; ++sample)
+               {
+                    const DirectX::XMFLOAT3 point(
+                         box.min.x + (box.max.x - box.min.x) * unit(random),
+                         box.min.y + (box.max.y - box.min.y) * unit(random),
+                         box.min.z + (box.max.z - box.min.z) * unit(random));
+                    bool blocked = false;
+                    for (std::size_t occluder = 0; occluder < occluders.size() && !blocked; ++occluder)
+                         blocked = occluder != target && SegmentHitsBox(eye, point, occluders[occluder]);
+                    CHECK(blocked);
+               }
+          }
+     }
+     CHECK(0 < hiddenNumber);
+
+     // Eye outside of the region keeps everything
+     std::vector<std::uint32_t> indices(targets.size());
+     for (std::size_t i = 0; i < indices.size(); ++i)
+          indices[i] = static_cast<std::uint32_t>(i);
+     CHECK(targets.size() == pvs.Filter(DirectX::XMFLOAT3(100.0f, 0.0f, 0.0f), indices.data(), indices.size()));
+     return CheckResult();
+}
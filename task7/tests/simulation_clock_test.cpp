@@ -0,0 +1,126 @@
+#include "check.h"
+#include "simulation_clock.h"
+#include "time_source.h"
+
+#include <cmath>
+#include <cstdint>
+
+namespace
+{
+
+     class ManualTimeSource : public TimeSource
+     {
+     public:
+          ManualTimeSource() :
+               nanoseconds(1000)
+          {
+          }
+
+          std::uint64_t GetNanoseconds() override
+          {
+               return nanoseconds;
+          }
+
+          std::uint64_t nanoseconds;
+     };
+
+     bool IsNear(const double value, const double expected)
+     {
+          return std::fabs(value - expected) < 1e-9;
+     }
+
+}
+
+// Fixed step accumulation, stall clamping, pause, time scale and virtual mode driven by a manual time source
+int main()
+{
+     {
+          ManualTimeSource source;
+          SimulationClock clock(source, 0.01);
+          CHECK(0 == clock.Tick());
+          CHECK(0.0 == clock.GetInterpolatedTime());
+
+          source.nanoseconds += 25000000;
+          CHECK(2 == clock.Tick());
+          CHECK(IsNear(clock.GetTime(), 0.02));
+          CHECK(IsNear(clock.GetAlpha(), 0.5));
+          CHECK(IsNear(clock.GetInterpolatedTime(), 0.015));
+
+          source.nanoseconds += 5000000;
+          CHECK(1 == clock.Tick());
+          CHECK(0.0 == clock.GetAlpha());
+          CHECK(3 == clock.GetStepNumber());
+
+          // Long stall is clamped to the step limit
+          source.nanoseconds += 10000000000ull;
+          CHECK(8 == clock.Tick());
+          CHECK(11 == clock.GetStepNumber());
+
+          // Paused time is not accumulated
+          clock.SetPaused(true);
+          CHECK(clock.IsPaused());
+          source.nanoseconds += 100000000;
+          CHECK(0 == clock.Tick());
+          CHECK(11 == clock.GetStepNumber());
+          clock.SetPaused(false);
+          source.nanoseconds += 10000000;
+          CHECK(1 == clock.Tick());
+          CHECK(12 == clock.GetStepNumber());
+
+          // Half speed needs two frames of real time for one step
+          clock.SetTimeScale(0.5);
+          CHECK(0.5 == clock.GetTimeScale());
+          const double alpha = clock.GetAlpha();
+          source.nanoseconds += 10000000;
+          CHECK(0 == clock.Tick());
+          CHECK(IsNear(clock.GetAlpha(), alpha + 0.5));
+          source.nanoseconds += 10000000;
+          CHECK(1 == clock.Tick());
+          clock.SetTimeScale(1.0);
+
+          // Time source going backwards does not produce steps
+          source.nanoseconds -= 1000;
+          CHECK(0 == clock.Tick());
+     }
+
+     // Virtual mode does not depend on the time source, so differently driven clocks stay identical
+     {
+          ManualTimeSource firstSource;
+          ManualTimeSource secondSource;
+          SimulationClock first(firstSource, 1.0 / 120);
+          SimulationClock second(secondSource, 1.0 / 120);
+          first.SetVirtualFrameTime(1.0 / 60);
+          second.SetVirtualFrameTime(1.0 / 60);
+          CHECK(first.IsVirtual());
+          bool same = true;
+          for (int frame = 0; frame < 1000; ++frame)
+          {
+               firstSource.nanoseconds += frame * 7919;
+               secondSource.nanoseconds += 12345678;
+               same = same && first.Tick() == second.Tick();
+               same = same && first.GetInterpolatedTime() == second.GetInterpolatedTime();
+          }
+          CHECK(same);
+          CHECK(2000 == first.GetStepNumber());
+          first.SetVirtualFrameTime(0.0);
+          CHECK(!first.IsVirtual());
+     }
+
+     // Presented time never goes back under jittering frame times
+     {
+          ManualTimeSource source;
+          SimulationClock clock(source, 1.0 / 60);
+          bool monotonic = true;
+          double lastTime = 0.0;
+          for (std::uint64_t frame = 0; frame < 100000; ++frame)
+          {
+               source.nanoseconds += (frame * 2654435761u) % 40000000;
+               clock.Tick();
+               const double time = clock.GetInterpolatedTime();
+               monotonic = monotonic && lastTime <= time;
+               lastTime = time;
+          }
+          CHECK(monotonic);
+     }
+     return CheckResult();
+}
@@ -0,0 +1,89 @@
+#include "check.h"
+#include "frame_arena.h"
+#include "frustum.h"
+#include "parallel_culling.h"
+#include "thread_pool.h"
+
+#include <directxmath.h>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <vector>
+
+// Every chunk runs exactly once for any thread number, and parallel culling gives the serial visible list
+// for any chunk size
+int main()
+{
+     std::mt19937 random(5);
+     std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+     std::uniform_real_distribution<float> extent(0.1f, 1.0f);
+
+     const std::size_t count = 30001;
+     std::vector<float> bounds[6];
+     for (auto &component : bounds)
+          component.resize(count);
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          for (int axis = 0; axis < 3; ++axis)
+          {
+               const float center = coordinate(random);
+               const float halfSize = extent(random);
+               bounds[axis][i] = center - halfSize;
+               bounds[axis + 3][i] = center + halfSize;
+          }
+     }
+
+     Frustum frustum(0.1f);
+     frustum.Construct(
+          DirectX::XMMatrixLookAtLH(DirectX::XMVectorSet(-60.0f, 5.0f, -60.0f, 0.0f), DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f), DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+          DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f));
+     std::vector<std::uint32_t> expected(count);
+     expected.resize(frustum.CheckRectangles(
+          bounds[0].data(),
+          bounds[1].data(),
+          bounds[2].data(),
+          bounds[3].data(),
+          bounds[4].data(),
+          bounds[5].data(),
+          count,
+          expected.data()));
+     CHECK(!expected.empty());
+
+     for (std::size_t threadNumber : {1, 2, 3, 8})
+     {
+          ThreadPool pool(threadNumber);
+          CHECK(threadNumber == pool.GetThreadNumber());
+
+          // Many small tasks catch lost or repeated chunks between runs
+          std::vector<std::atomic<int>> calls(257);
+          for (int run = 0; run < 100; ++run)
+               pool.Run(calls.size(), [&calls](std::size_t chunk) { calls[chunk].fetch_add(1, std::memory_order_relaxed); });
+          for (const auto &chunkCalls : calls)
+               CHECK(100 == chunkCalls.load());
+          pool.Run(0, [](std::size_t) {});
+
+          FrameArena arena(4096);
+          for (std::size_t chunkSize : {std::size_t(1), std::size_t(1000), std::size_t(1024), count, count + 1})
+               for (int run = 0; run < 5; ++run)
+               {
+                    arena.Reset();
+                    std::vector<std::uint32_t> visible(count);
+                    visible.resize(CheckRectanglesParallel(
+                         frustum,
+                         bounds[0].data(),
+                         bounds[1].data(),
+                         bounds[2].data(),
+                         bounds[3].data(),
+                         bounds[4].data(),
+                         bounds[5].data(),
+                         count,
+                         chunkSize,
+                         pool,
+                         arena,
+                         visible.data()));
+                    CHECK(expected == visible);
+               }
+          CHECK(0 == CheckRectanglesParallel(frustum, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0, 1024, pool, arena, nullptr));
+     }
+     return CheckResult();
+}
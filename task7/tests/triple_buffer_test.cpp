@@ -0,0 +1,89 @@
+#include "check.h"
+#include "triple_buffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+     struct Packet
+     {
+          std::uint64_t index;
+          std::vector<std::uint32_t> data;
+     };
+
+     std::uint32_t GetValue(const std::uint64_t index)
+     {
+          return static_cast<std::uint32_t>(index * 2654435761u);
+     }
+
+}
+
+// Handoff rules on one thread, then a producer publishing as fast as it can against a null consumer
+// which only validates packets: every acquired packet is complete and newer than the previous one
+int main()
+{
+     {
+          TripleBuffer<int> buffer;
+          CHECK(buffer.IsConsumed());
+          CHECK(!buffer.Acquire());
+          buffer.GetWriteSlot() = 1;
+          buffer.Publish();
+          CHECK(!buffer.IsConsumed());
+          buffer.GetWriteSlot() = 2;
+          buffer.Publish();
+          // Only the latest value is seen
+          CHECK(buffer.Acquire());
+          CHECK(2 == buffer.GetReadSlot());
+          CHECK(buffer.IsConsumed());
+          CHECK(!buffer.Acquire());
+          CHECK(2 == buffer.GetReadSlot());
+          buffer.GetWriteSlot() = 3;
+          buffer.Publish();
+          CHECK(buffer.Acquire());
+          CHECK(3 == buffer.GetReadSlot());
+     }
+
+     TripleBuffer<Packet> buffer;
+     std::atomic<bool> producing(true);
+     const std::uint64_t packetNumber = 200000;
+     std::thread producer(
+          [&]()
+          {
+               for (std::uint64_t i = 1; i <= packetNumber; ++i)
+               {
+                    Packet &packet = buffer.GetWriteSlot();
+                    packet.index = i;
+                    packet.data.assign(i % 64, GetValue(i));
+                    buffer.Publish();
+               }
+               producing.store(false);
+          });
+
+     std::uint64_t receivedNumber = 0;
+     std::uint64_t lastIndex = 0;
+     std::uint64_t badNumber = 0;
+     while (producing.load() || !buffer.IsConsumed())
+     {
+          if (!buffer.Acquire())
+          {
+               std::this_thread::yield();
+               continue;
+          }
+          const Packet &packet = buffer.GetReadSlot();
+          ++receivedNumber;
+          badNumber += packet.index <= lastIndex ? 1 : 0;
+          lastIndex = packet.index;
+          badNumber += packet.data.size() != packet.index % 64 ? 1 : 0;
+          for (const std::uint32_t value : packet.data)
+               badNumber += GetValue(packet.index) != value ? 1 : 0;
+     }
+     producer.join();
+     CHECK(0 == badNumber);
+     CHECK(0 < receivedNumber);
+     CHECK(packetNumber == lastIndex);
+     return CheckResult();
+}
@@ -0,0 +1,113 @@
+#include "check.h"
+#include "fake_upload_ring_backend.h"
+#include "ring_allocator.h"
+#include "upload_ring.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+     typedef std::vector<std::pair<std::size_t, std::size_t>> Regions;
+
+     bool Overlaps(const Regions &regions, const std::size_t begin, const std::size_t end)
+     {
+          for (const auto &region : regions)
+               if (begin < region.second && region.first < end)
+                    return true;
+          return false;
+     }
+
+}
+
+// Ring allocator wrap and fence release on a fixed sequence, then the upload ring over a fake backend
+// with random allocations and GPU latency: no allocation may overlap a region of a frame in flight
+int main()
+{
+     RingAllocator allocator(1000);
+     CHECK(0 == allocator.Allocate(400, 16));
+     CHECK(400 == allocator.Allocate(400, 16));
+     allocator.FinishFrame(1);
+     CHECK(800 == allocator.GetUsed());
+     CHECK(1 == allocator.GetPendingFrameNumber());
+     // Neither the ring end nor its start is free until fence 1 completes
+     CHECK(RingAllocator::invalidOffset == allocator.Allocate(300, 16));
+     CHECK(800 == allocator.Allocate(100, 16));
+     allocator.FinishFrame(2);
+     allocator.Release(1);
+     CHECK(100 == allocator.GetUsed());
+     // The end is too small, so the allocation wraps and the skipped end counts as used
+     CHECK(0 == allocator.Allocate(300, 16));
+     CHECK(500 == allocator.GetUsed());
+     CHECK(RingAllocator::invalidOffset == allocator.Allocate(600, 16));
+     CHECK(304 == allocator.Allocate(100, 16));
+     allocator.FinishFrame(3);
+     allocator.Release(2);
+     CHECK(504 == allocator.GetUsed());
+     allocator.Release(3);
+     CHECK(0 == allocator.GetUsed());
+     CHECK(0 == allocator.GetPendingFrameNumber());
+     // Empty ring starts from the beginning again
+     CHECK(0 == allocator.Allocate(1000, 16));
+     CHECK(RingAllocator::invalidOffset == allocator.Allocate(1, 1));
+     allocator.Reset();
+     CHECK(0 == allocator.GetUsed());
+     CHECK(0 == allocator.Allocate(8, 8));
+
+     const std::size_t capacity = 4096;
+     FakeUploadRingBackend backend(capacity);
+     std::size_t discardNumber = 0;
+     std::size_t allocationNumber = 0;
+     {
+          UploadRing ring(backend, capacity);
+          std::mt19937 random(18);
+          std::map<std::uint64_t, Regions> framesInFlight;
+          for (int frame = 0; frame < 5000; ++frame)
+          {
+               backend.latency = random() % 4;
+               ring.BeginFrame();
+               const std::uint64_t completedFence = backend.GetCompletedFence();
+               for (auto it = framesInFlight.begin(); framesInFlight.end() != it;)
+                    it = it->first <= completedFence ? framesInFlight.erase(it) : std::next(it);
+
+               Regions current;
+               const int number = static_cast<int>(random() % 6);
+               for (int i = 0; i < number; ++i)
+               {
+                    const std::size_t size = 1 + random() % 900;
+                    const std::size_t alignment = std::size_t(1) << (random() % 9);
+                    const UploadRing::Allocation allocation = ring.Allocate(size, alignment);
+                    if (nullptr == allocation.data)
+                         continue;
+                    ++allocationNumber;
+                    // Discard orphans the previous buffer, which may happen only before the first allocation of a frame
+                    if (ring.GetDiscardNumber() != discardNumber)
+                    {
+                         discardNumber = ring.GetDiscardNumber();
+                         framesInFlight.clear();
+                         CHECK(current.empty());
+                    }
+                    CHECK(0 == allocation.offset % alignment);
+                    CHECK(allocation.offset + size <= capacity);
+                    CHECK(backend.memory.data() + allocation.offset == allocation.data);
+                    for (const auto &frameRegions : framesInFlight)
+                         CHECK(!Overlaps(frameRegions.second, allocation.offset, allocation.offset + size));
+                    CHECK(!Overlaps(current, allocation.offset, allocation.offset + size));
+                    current.emplace_back(allocation.offset, allocation.offset + size);
+               }
+               ring.EndFrame();
+               CHECK(!backend.mapped);
+               if (!current.empty())
+                    framesInFlight[backend.signaledFence] = current;
+          }
+     }
+     CHECK(0 < allocationNumber);
+     CHECK(discardNumber == backend.discardNumber);
+     CHECK(!backend.doubleMapped);
+     return CheckResult();
+}
@@ -0,0 +1,69 @@
+#include "check.h"
+#include "frustum.h"
+#include "visibility_cache.h"
+
+#include <directxmath.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Temporal cache against Frustum::CheckSphere along a smooth camera path with jumps, with some spheres moving
+int main()
+{
+     std::mt19937 random(6);
+     std::uniform_real_distribution<float> coordinate(-60.0f, 60.0f);
+     std::uniform_real_distribution<float> radiusDistribution(0.1f, 2.0f);
+
+     const std::size_t count = 10000;
+     std::vector<float> spheres[4];
+     for (auto &component : spheres)
+          component.resize(count);
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          spheres[0][i] = coordinate(random);
+          spheres[1][i] = coordinate(random) * 0.1f;
+          spheres[2][i] = coordinate(random);
+          spheres[3][i] = radiusDistribution(random);
+     }
+
+     Frustum frustum(0.1f);
+     VisibilityCache cache;
+     std::size_t testedTotal = 0;
+     std::size_t visibleTotal = 0;
+     const int frameNumber = 600;
+     for (int frame = 0; frame < frameNumber; ++frame)
+     {
+          // Every 200 frames the camera jumps, every 50 frames spheres of every 10th object move
+          const float time = frame / 60.0f + (frame / 200) * 10.0f;
+          if (0 == frame % 50)
+          {
+               for (std::size_t i = 0; i < count; i += 10)
+                    spheres[0][i] += 0.5f;
+          }
+          const DirectX::XMFLOAT3 eye(std::cos(time * 0.3f) * 40.0f, 2.0f, std::sin(time * 0.3f) * 40.0f);
+          const DirectX::XMVECTOR at = DirectX::XMVectorSet(std::cos(time) * 10.0f, 0.0f, std::sin(time * 0.7f) * 10.0f, 0.0f);
+          frustum.Construct(
+               DirectX::XMMatrixLookAtLH(DirectX::XMLoadFloat3(&eye), at, DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+               DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PI / 3, 16.0f / 9.0f, 100.0f, 0.1f));
+
+          std::vector<std::uint32_t> visible(count);
+          visible.resize(cache.Cull(frustum, eye, spheres[0].data(), spheres[1].data(), spheres[2].data(), spheres[3].data(), count, visible.data()));
+          testedTotal += cache.GetTestedNumber();
+
+          std::vector<std::uint32_t> expected;
+          for (std::size_t i = 0; i < count; ++i)
+          {
+               if (frustum.CheckSphere(DirectX::XMFLOAT3(spheres[0][i], spheres[1][i], spheres[2][i]), spheres[3][i]))
+                    expected.push_back(static_cast<std::uint32_t>(i));
+          }
+          CHECK(expected == visible);
+          visibleTotal += visible.size();
+
+          if (100 == frame)
+               cache.Reset();
+     }
+     CHECK(0 < visibleTotal);
+     // Coherent frames skip most tests
+     CHECK(testedTotal < count * frameNumber / 2);
+     return CheckResult();
+}
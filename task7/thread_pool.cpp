@@ -0,0 +1,94 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(const std::size_t threadNumber) :
+     pTask_(nullptr),
+     chunkNumber_(0),
+     nextChunk_(0),
+     activeWorkers_(0),
+     generation_(0),
+     stop_(false)
+{
+     for (std::size_t i = 1; i < threadNumber; ++i)
+          workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+     {
+          std::lock_guard<std::mutex> lock(mutex_);
+          stop_ = true;
+     }
+     wakeCondition_.notify_all();
+     for (auto &worker : workers_)
+          worker.join();
+}
+
+std::size_t ThreadPool::GetThreadNumber() const
+{
+     return workers_.size() + 1;
+}
+
+void ThreadPool::Run(const std::size_t chunkNumber, const TaskRef &task)
+{
+     if (0 == chunkNumber)
+          return;
+
+     if (workers_.empty() || 1 == chunkNumber)
+     {
+          for (std::size_t chunk = 0; chunk < chunkNumber; ++chunk)
+               task.invoke(task.pTask, chunk);
+          return;
+     }
+
+     {
+          std::lock_guard<std::mutex> lock(mutex_);
+          pTask_ = &task;
+          chunkNumber_ = chunkNumber;
+          nextChunk_.store(0);
+          ++generation_;
+     }
+     wakeCondition_.notify_all();
+
+     ExecuteChunks(task, chunkNumber);
+
+     // Workers that have not picked the task up yet will see it is gone and keep sleeping
+     std::unique_lock<std::mutex> lock(mutex_);
+     pTask_ = nullptr;
+     doneCondition_.wait(lock, [this]() { return 0 == activeWorkers_; });
+}
+
+void ThreadPool::ExecuteChunks(const TaskRef &task, const std::size_t chunkNumber)
+{
+     for (std::size_t chunk = nextChunk_.fetch_add(1); chunk < chunkNumber; chunk = nextChunk_.fetch_add(1))
+          task.invoke(task.pTask, chunk);
+}
+
+void ThreadPool::WorkerLoop()
+{
+     std::size_t seenGeneration = 0;
+     while (true)
+     {
+          const TaskRef *pTask = nullptr;
+          std::size_t chunkNumber = 0;
+          {
+               std::unique_lock<std::mutex> lock(mutex_);
+               wakeCondition_.wait(lock, [this, seenGeneration]() { return stop_ || seenGeneration != generation_; });
+               if (stop_)
+                    return;
+               seenGeneration = generation_;
+               if (nullptr == pTask_)
+                    continue;
+               pTask = pTask_;
+               chunkNumber = chunkNumber_;
+               ++activeWorkers_;
+          }
+
+          ExecuteChunks(*pTask, chunkNumber);
+
+          {
+               std::lock_guard<std::mutex> lock(mutex_);
+               --activeWorkers_;
+          }
+          doneCondition_.notify_one();
+     }
+}
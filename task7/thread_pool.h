@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running chunked tasks, calling thread takes part in every task
+class ThreadPool
+{
+public:
+     ThreadPool(const std::size_t threadNumber = std::thread::hardware_concurrency());
+     ThreadPool(const ThreadPool &) = delete;
+     ThreadPool(ThreadPool &&) = delete;
+     ~ThreadPool();
+     // Number of threads executing chunks including the calling one
+     std::size_t GetThreadNumber() const;
+     // Calls task(chunk) for every chunk in [0, chunkNumber) and returns when all calls are finished.
+     // Task is referenced, not copied, so running it does not allocate.
+     template <typename Task>
+     void Run(const std::size_t chunkNumber, const Task &task)
+     {
+          Run(chunkNumber, TaskRef{&task, [](const void *pTask, std::size_t chunk) { (*static_cast<const Task *>(pTask))(chunk); }});
+     }
+
+private:
+     struct TaskRef
+     {
+          const void *pTask;
+          void (*invoke)(const void *pTask, std::size_t chunk);
+     };
+
+     void Run(const std::size_t chunkNumber, const TaskRef &task);
+     void WorkerLoop();
+     void ExecuteChunks(const TaskRef &task, const std::size_t chunkNumber);
+
+     std::vector<std::thread> workers_;
+     std::mutex mutex_;
+     std::condition_variable wakeCondition_;
+     std::condition_variable doneCondition_;
+     const TaskRef *pTask_;
+     std::size_t chunkNumber_;
+     std::atomic<std::size_t> nextChunk_;
+     std::size_t activeWorkers_;
+     std::size_t generation_;
+     bool stop_;
+};
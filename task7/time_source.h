@@ -0,0 +1,22 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Monotonic time in nanoseconds, can be replaced to drive SimulationClock by hand
+class TimeSource
+{
+public:
+     virtual ~TimeSource() {}
+     virtual std::uint64_t GetNanoseconds() = 0;
+};
+
+class SteadyTimeSource : public TimeSource
+{
+public:
+     std::uint64_t GetNanoseconds() override
+     {
+          return static_cast<std::uint64_t>(
+               std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+     }
+};
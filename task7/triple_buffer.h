@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+
+// Single producer, single consumer handoff of the latest value without locks. The producer fills its
+// own slot and publishes it, the consumer takes the most recently published slot, and the third slot
+// lets both proceed without waiting for each other. Unconsumed values are replaced by newer ones.
+template <typename T>
+class TripleBuffer
+{
+public:
+     TripleBuffer() :
+          slots_{}, writeIndex_(0), middle_(1), readIndex_(2)
+     {
+     }
+     TripleBuffer(const TripleBuffer &) = delete;
+
+     // Producer side
+     T &GetWriteSlot()
+     {
+          return slots_[writeIndex_];
+     }
+     void Publish()
+     {
+          writeIndex_ = middle_.exchange(writeIndex_ | freshBit_, std::memory_order_acq_rel) & indexMask_;
+     }
+     // False while the last published value has not been acquired
+     bool IsConsumed() const
+     {
+          return 0 == (middle_.load(std::memory_order_acquire) & freshBit_);
+     }
+
+     // Consumer side, returns false if nothing was published since the previous call
+     bool Acquire()
+     {
+          if (0 == (middle_.load(std::memory_order_relaxed) & freshBit_))
+               return false;
+          readIndex_ = middle_.exchange(readIndex_, std::memory_order_acq_rel) & indexMask_;
+          return true;
+     }
+     const T &GetReadSlot() const
+     {
+          return slots_[readIndex_];
+     }
+
+private:
+     static constexpr const unsigned indexMask_ = 3;
+     static constexpr const unsigned freshBit_ = 4;
+
+     T slots_[3];
+     unsigned writeIndex_;
+     std::atomic<unsigned> middle_; // slot index with freshBit_ set when it holds an unconsumed value
+     unsigned readIndex_;
+};
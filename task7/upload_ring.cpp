@@ -0,0 +1,81 @@
+#include "upload_ring.h"
+
+UploadRing::UploadRing(UploadRingBackend &backend, const std::size_t capacity) :
+     backend_(backend),
+     allocator_(capacity),
+     pMapped_(nullptr),
+     discardNext_(true),
+     discardNumber_(0)
+{
+}
+
+UploadRing::~UploadRing()
+{
+     Unmap();
+}
+
+void UploadRing::BeginFrame()
+{
+     allocator_.Release(backend_.GetCompletedFence());
+}
+
+UploadRing::Allocation UploadRing::Allocate(const std::size_t size, const std::size_t alignment)
+{
+     std::size_t offset = allocator_.Allocate(size, alignment);
+     if (RingAllocator::invalidOffset == offset)
+     {
+          // Discarding drops the frame's earlier allocations too, so it is only possible before the first one
+          if (0 != allocator_.GetFrameUsed())
+               return Allocation{nullptr, 0};
+          Unmap();
+          allocator_.Reset();
+          discardNext_ = true;
+          offset = allocator_.Allocate(size, alignment);
+          if (RingAllocator::invalidOffset == offset)
+               return Allocation{nullptr, 0};
+     }
+
+     if (nullptr == pMapped_ && !Map(discardNext_))
+          return Allocation{nullptr, 0};
+     return Allocation{pMapped_ + offset, static_cast<unsigned>(offset)};
+}
+
+bool UploadRing::Map(const bool discard)
+{
+     pMapped_ = static_cast<char *>(backend_.Map(discard));
+     if (nullptr == pMapped_)
+          return false;
+     if (discard)
+          ++discardNumber_;
+     discardNext_ = false;
+     return true;
+}
+
+void UploadRing::Unmap()
+{
+     if (nullptr == pMapped_)
+          return;
+     backend_.Unmap();
+     pMapped_ = nullptr;
+}
+
+void UploadRing::EndFrame()
+{
+     Unmap();
+     allocator_.FinishFrame(backend_.SignalFence());
+}
+
+std::size_t UploadRing::GetCapacity() const
+{
+     return allocator_.GetCapacity();
+}
+
+std::size_t UploadRing::GetUsed() const
+{
+     return allocator_.GetUsed();
+}
+
+std::size_t UploadRing::GetDiscardNumber() const
+{
+     return discardNumber_;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ring_allocator.h"
+#include "upload_ring_backend.h"
+
+#include <cstddef>
+
+// Per-frame GPU data written into one large dynamic buffer. The buffer is mapped without overwrite
+// while the fences protect regions of frames in flight, and discarded only when a frame starts with
+// no free space left. Draws bind allocations by offset.
+class UploadRing
+{
+public:
+     struct Allocation
+     {
+          void *data; // nullptr on failure
+          unsigned offset;
+     };
+
+     UploadRing(UploadRingBackend &backend, const std::size_t capacity);
+     UploadRing(const UploadRing &) = delete;
+     ~UploadRing();
+     // Frees regions of frames completed by GPU
+     void BeginFrame();
+     Allocation Allocate(const std::size_t size, const std::size_t alignment);
+     template <typename T>
+     T *Allocate(const std::size_t count, unsigned &offset)
+     {
+          const Allocation allocation = Allocate(count * sizeof(T), alignof(T) > 16 ? alignof(T) : 16);
+          offset = allocation.offset;
+          return static_cast<T *>(allocation.data);
+     }
+     // Must be called before draws which read the allocations
+     void Unmap();
+     // Protects allocations of the frame until GPU passes its commands
+     void EndFrame();
+     std::size_t GetCapacity() const;
+     std::size_t GetUsed() const;
+     std::size_t GetDiscardNumber() const;
+
+private:
+     bool Map(const bool discard);
+
+     UploadRingBackend &backend_;
+     RingAllocator allocator_;
+     char *pMapped_;
+     bool discardNext_;
+     std::size_t discardNumber_;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+// Buffer and fence behind UploadRing, lets the ring run without D3D
+class UploadRingBackend
+{
+public:
+     virtual ~UploadRingBackend() {}
+     // Maps the whole buffer discarding previous content or promising not to overwrite regions in use,
+     // returns nullptr on failure
+     virtual void *Map(const bool discard) = 0;
+     virtual void Unmap() = 0;
+     // Inserts a fence after commands issued so far and returns its value, values grow from 1
+     virtual std::uint64_t SignalFence() = 0;
+     virtual std::uint64_t GetCompletedFence() = 0;
+};
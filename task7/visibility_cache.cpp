@@ -0,0 +1,129 @@
+#include "visibility_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+VisibilityCache::VisibilityCache() :
+     planes_{},
+     eye_(0.0f, 0.0f, 0.0f),
+     hasPlanes_(false),
+     slopeSum_(0.0),
+     offsetSum_(0.0),
+     eyeTravel_(0.0),
+     frame_(0),
+     testedNumber_(0)
+{
+}
+
+void VisibilityCache::Reset()
+{
+     entries_.clear();
+     hasPlanes_ = false;
+}
+
+void VisibilityCache::UpdateDrift(const Frustum &frustum, const DirectX::XMFLOAT3 &eye)
+{
+     ++frame_;
+     if (hasPlanes_)
+     {
+          // Plane value change at point eye + v is (dn, v) + (dn, eye) + dw
+          double slope = 0.0;
+          double offset = 0.0;
+          for (int i = 0; i < 6; ++i)
+          {
+               const float *plane = frustum.GetPlane(i);
+               const double dx = plane[0] - planes_[i][0];
+               const double dy = plane[1] - planes_[i][1];
+               const double dz = plane[2] - planes_[i][2];
+               const double dw = plane[3] - planes_[i][3];
+               slope = std::max(slope, std::sqrt(dx * dx + dy * dy + dz * dz));
+               offset = std::max(offset, std::abs(dx * eye.x + dy * eye.y + dz * eye.z + dw));
+          }
+          const double ex = eye.x - eye_.x;
+          const double ey = eye.y - eye_.y;
+          const double ez = eye.z - eye_.z;
+          eyeTravel_ += std::sqrt(ex * ex + ey * ey + ez * ez);
+          slopeSum_ += slope;
+          offsetSum_ += offset;
+     }
+
+     for (int i = 0; i < 6; ++i)
+          std::copy(frustum.GetPlane(i), frustum.GetPlane(i) + 4, planes_[i]);
+     eye_ = eye;
+     hasPlanes_ = true;
+}
+
+std::size_t VisibilityCache::Cull(
+     const Frustum &frustum,
+     const DirectX::XMFLOAT3 &eye,
+     const float *centerX,
+     const float *centerY,
+     const float *centerZ,
+     const float *radius,
+     const std::size_t count,
+     std::uint32_t *visibleIndices)
+{
+     // Fresh entries have zero margin and are always tested
+     if (entries_.size() != count)
+          entries_.assign(count, Entry{});
+     UpdateDrift(frustum, eye);
+
+     std::size_t visibleNumber = 0;
+     testedNumber_ = 0;
+     for (std::size_t i = 0; i < count; ++i)
+     {
+          Entry &entry = entries_[i];
+          const bool moved =
+               entry.sphere.x != centerX[i] ||
+               entry.sphere.y != centerY[i] ||
+               entry.sphere.z != centerZ[i] ||
+               entry.sphere.w != radius[i];
+          if (!moved && frame_ - entry.frame < maxAge_)
+          {
+               const double drift =
+                    (slopeSum_ - entry.slopeSum) * (entry.distance + eyeTravel_ - entry.eyeTravel) +
+                    (offsetSum_ - entry.offsetSum);
+               if (drift * driftScale_ + driftBias_ < entry.margin)
+               {
+                    visibleIndices[visibleNumber] = static_cast<std::uint32_t>(i);
+                    visibleNumber += entry.visible;
+                    continue;
+               }
+          }
+
+          ++testedNumber_;
+          entry.sphere = DirectX::XMFLOAT4(centerX[i], centerY[i], centerZ[i], radius[i]);
+          float insideMargin = std::numeric_limits<float>::max();
+          float outsideMargin = 0.0f;
+          for (int p = 0; p < 6; ++p)
+          {
+               const float *plane = planes_[p];
+               const float distance = plane[0] * centerX[i] + plane[1] * centerY[i] + plane[2] * centerZ[i] + plane[3];
+               if (distance < -radius[i])
+                    outsideMargin = std::max(outsideMargin, -radius[i] - distance);
+               else
+                    insideMargin = std::min(insideMargin, distance + radius[i]);
+          }
+          entry.visible = 0.0f == outsideMargin;
+          entry.margin = entry.visible ? insideMargin : outsideMargin;
+          const float dx = centerX[i] - eye.x;
+          const float dy = centerY[i] - eye.y;
+          const float dz = centerZ[i] - eye.z;
+          entry.distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+          entry.slopeSum = slopeSum_;
+          entry.offsetSum = offsetSum_;
+          entry.eyeTravel = eyeTravel_;
+          entry.frame = frame_;
+
+          visibleIndices[visibleNumber] = static_cast<std::uint32_t>(i);
+          visibleNumber += entry.visible;
+     }
+
+     return visibleNumber;
+}
+
+std::size_t VisibilityCache::GetTestedNumber() const
+{
+     return testedNumber_;
+}
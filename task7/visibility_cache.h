@@ -0,0 +1,59 @@
+#pragma once
+
+#include "frustum.h"
+
+#include <directxmath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Frame to frame coherent sphere culling. Every object keeps its last result with the distance
+// to the closest deciding plane and is retested only when frustum movement since then could cross it.
+class VisibilityCache
+{
+public:
+     VisibilityCache();
+     void Reset();
+     // Same result as testing every sphere with Frustum::CheckSphere, indices are written in increasing order
+     std::size_t Cull(
+          const Frustum &frustum,
+          const DirectX::XMFLOAT3 &eye,
+          const float *centerX,
+          const float *centerY,
+          const float *centerZ,
+          const float *radius,
+          const std::size_t count,
+          std::uint32_t *visibleIndices);
+     // Number of spheres actually tested during last Cull
+     std::size_t GetTestedNumber() const;
+
+private:
+     static constexpr const std::size_t maxAge_ = 120;
+     static constexpr const double driftScale_ = 1.001;
+     static constexpr const double driftBias_ = 1e-4;
+
+     struct Entry
+     {
+          DirectX::XMFLOAT4 sphere;
+          float margin;
+          float distance;
+          double slopeSum;
+          double offsetSum;
+          double eyeTravel;
+          std::size_t frame;
+          bool visible;
+     };
+
+     void UpdateDrift(const Frustum &frustum, const DirectX::XMFLOAT3 &eye);
+
+     std::vector<Entry> entries_;
+     float planes_[6][4];
+     DirectX::XMFLOAT3 eye_;
+     bool hasPlanes_;
+     // Sums over frames of plane drift bound: |dn| * distance to eye + offset
+     double slopeSum_;
+     double offsetSum_;
+     double eyeTravel_;
+     std::size_t frame_;
+     std::size_t testedNumber_;
+};